@@ -0,0 +1,87 @@
+#include <algorithm>
+
+#include <i3ipc++/ipc.hpp>
+#include <i3ipc++/mock-server.hpp>
+#include <i3ipc++/synthetic.hpp>
+
+#include "bench.hpp"
+
+/**
+ * Dispatching: emission of signals by a connection and the whole way of an event from the socket to a slot
+ */
+
+static const std::string  g_window_event = "{\"change\":\"title\",\"container\":{\"id\":42,\"type\":\"con\",\"name\":\"w\",\"layout\":\"splith\""
+	",\"border\":\"normal\",\"rect\":{\"x\":0,\"y\":0,\"width\":800,\"height\":600},\"window_properties\":{\"class\":\"Term\",\"title\":\"w\"}}}";
+
+
+/**
+ * Emit signal_event with a window event
+ * @param  typed connect a slot to signal_window_event (so the event is decoded) instead of signal_event
+ */
+static void  bench_emit(bench::state_t&  state, const bool  typed) {
+	i3ipc::mock_server  server;
+	i3ipc::connection  conn(server.get_socket_path());
+	uint64_t  handled = 0;
+	if (typed) {
+		conn.signal_window_event.connect([&handled](const i3ipc::window_event_t&  ev) { handled += ev.container->id; });
+	} else {
+		conn.signal_event.connect([&handled](i3ipc::EventType  type, const std::shared_ptr<const i3ipc::buf_t>&  buf) { handled += buf->header->size; });
+	}
+	std::shared_ptr<const i3ipc::buf_t>  buf = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, g_window_event);
+
+	state.bytes_per_op = g_window_event.size();
+	state.reset_timer();
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		conn.signal_event.emit(i3ipc::ET_WINDOW, buf);
+	}
+	bench::do_not_optimize(handled);
+}
+
+
+/**
+ * Receive a synthetic stream of window and workspace events from a mock server with handle_event()
+ */
+static void  bench_handle_event(bench::state_t&  state, const bool  typed) {
+	i3ipc::mock_server  server;
+	i3ipc::synthetic_tree  tree;
+	i3ipc::connection  conn(server.get_socket_path());
+	uint64_t  handled = 0;
+	if (typed) {
+		conn.signal_window_event.connect([&handled](const i3ipc::window_event_t&  ev) { handled++; });
+		conn.signal_workspace_event.connect([&handled](const i3ipc::workspace_event_t&  ev) { handled++; });
+	} else {
+		conn.signal_event.connect([&handled](i3ipc::EventType  type, const std::shared_ptr<const i3ipc::buf_t>&  buf) { handled++; });
+	}
+	conn.subscribe(i3ipc::ET_WINDOW | i3ipc::ET_WORKSPACE);
+	conn.connect_event_socket();
+
+	uint64_t  bytes = 0;
+	state.reset_timer();
+	for (uint64_t  done = 0; done < state.iterations; ) {
+		state.pause_timer();
+		auto  batch = tree.generate_events(std::min<uint64_t>(1024, state.iterations - done));
+		state.resume_timer();
+		for (auto&  ev : batch) {
+			server.send_event(ev.type, ev.payload);
+			bytes += ev.payload.size() + sizeof(i3ipc::header_t);
+		}
+		for (size_t  i = 0; i < batch.size(); i++) {
+			conn.handle_event();
+		}
+		done += batch.size();
+	}
+	state.bytes_per_op = bytes / state.iterations;
+	bench::do_not_optimize(handled);
+}
+
+
+static bool  register_dispatch() {
+	for (bool  typed : { false, true }) {
+		const bench::params_t  params = { { "slot", typed ? "typed" : "raw" } };
+		bench::add("emit", params, [typed](bench::state_t&  state) { bench_emit(state, typed); });
+		bench::add("handle_event", params, [typed](bench::state_t&  state) { bench_handle_event(state, typed); });
+	}
+	return true;
+}
+
+static const bool  g_registered = register_dispatch();
@@ -0,0 +1,53 @@
+extern "C" {
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+#include <stdexcept>
+
+#include <i3ipc++/ipc-util.hpp>
+
+#include "bench.hpp"
+
+/**
+ * Framing: packing of a message and its way through a socket pair
+ */
+
+static void  bench_pack(bench::state_t&  state, const size_t  size) {
+	const std::string  payload(size, 'x');
+	state.bytes_per_op = sizeof(i3ipc::header_t) + size;
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		auto  buf = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, payload);
+		bench::do_not_optimize(buf);
+	}
+}
+
+
+static void  bench_send_recv(bench::state_t&  state, const size_t  size) {
+	int  fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+		throw std::runtime_error("Failed to create a socket pair");
+	}
+	auto  buf = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, std::string(size, 'x'));
+	state.bytes_per_op = buf->data.size();
+	state.reset_timer();
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		i3ipc::i3_send(fds[0], *buf);
+		auto  reply = i3ipc::i3_recv(fds[1]);
+		bench::do_not_optimize(reply);
+	}
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+static bool  register_framing() {
+	for (size_t  size : { 16, 1024, 65536 }) {
+		const bench::params_t  params = { { "payload", std::to_string(size) } };
+		bench::add("pack", params, [size](bench::state_t&  state) { bench_pack(state, size); });
+		bench::add("send_recv", params, [size](bench::state_t&  state) { bench_send_recv(state, size); });
+	}
+	return true;
+}
+
+static const bool  g_registered = register_framing();
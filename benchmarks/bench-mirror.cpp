@@ -0,0 +1,74 @@
+#include <algorithm>
+
+#include <i3ipc++/focus-tracker.hpp>
+#include <i3ipc++/ipc.hpp>
+#include <i3ipc++/mock-server.hpp>
+#include <i3ipc++/synthetic.hpp>
+
+#include "bench.hpp"
+
+/**
+ * Mirroring of the state of i3: focus_tracker seeded from synthetic trees of different sizes and kept up to
+ * date from their event streams
+ */
+
+static i3ipc::synthetic_tree_params_t  mirror_params(const uint32_t  windows) {
+	i3ipc::synthetic_tree_params_t  params;
+	params.windows = windows;
+	params.outputs = std::max<uint32_t>(1, windows / 500);
+	return params;
+}
+
+
+static void  bench_seed(bench::state_t&  state, const uint32_t  windows) {
+	i3ipc::mock_server  server;
+	i3ipc::synthetic_tree  tree(mirror_params(windows));
+	tree.install(server);
+	i3ipc::connection  conn(server.get_socket_path());
+	state.bytes_per_op = tree.get_tree_json().size();
+	state.reset_timer();
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		i3ipc::focus_tracker  tracker(conn);
+		bench::do_not_optimize(tracker.focused_window());
+	}
+}
+
+
+static void  bench_follow(bench::state_t&  state, const uint32_t  windows) {
+	i3ipc::mock_server  server;
+	i3ipc::synthetic_tree  tree(mirror_params(windows));
+	tree.install(server);
+	i3ipc::connection  conn(server.get_socket_path());
+	i3ipc::focus_tracker  tracker(conn);
+	conn.connect_event_socket();
+
+	uint64_t  bytes = 0;
+	state.reset_timer();
+	for (uint64_t  done = 0; done < state.iterations; ) {
+		state.pause_timer();
+		auto  batch = tree.generate_events(std::min<uint64_t>(256, state.iterations - done));
+		state.resume_timer();
+		for (auto&  ev : batch) {
+			server.send_event(ev.type, ev.payload);
+			bytes += ev.payload.size() + sizeof(i3ipc::header_t);
+		}
+		for (size_t  i = 0; i < batch.size(); i++) {
+			conn.handle_event();
+		}
+		done += batch.size();
+	}
+	state.bytes_per_op = bytes / state.iterations;
+	bench::do_not_optimize(tracker.focused_window());
+}
+
+
+static bool  register_mirror() {
+	for (uint32_t  windows : { 100, 1000, 5000 }) {
+		const bench::params_t  params = { { "windows", std::to_string(windows) } };
+		bench::add("focus_tracker_seed", params, [windows](bench::state_t&  state) { bench_seed(state, windows); });
+		bench::add("focus_tracker_events", params, [windows](bench::state_t&  state) { bench_follow(state, windows); });
+	}
+	return true;
+}
+
+static const bool  g_registered = register_mirror();
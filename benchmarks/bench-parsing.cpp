@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include <i3ipc++/ipc.hpp>
+#include <i3ipc++/mock-server.hpp>
+#include <i3ipc++/synthetic.hpp>
+
+#include "bench.hpp"
+
+/**
+ * Parsing: synthetic GET_TREE replies of different sizes and decoding of each type of events
+ */
+
+static std::string  rect_json(const int  w, const int  h) {
+	return "{\"x\":0,\"y\":0,\"width\":" + std::to_string(w) + ",\"height\":" + std::to_string(h) + "}";
+}
+
+static std::string  window_json(const uint64_t  id) {
+	return "{\"id\":" + std::to_string(id) + ",\"type\":\"con\",\"name\":\"window " + std::to_string(id) + "\",\"layout\":\"splith\",\"border\":\"normal\""
+		",\"current_border_width\":2,\"percent\":0.5,\"urgent\":false,\"focused\":false,\"window\":" + std::to_string(0x1000000 + id) +
+		",\"rect\":" + rect_json(800, 600) + ",\"window_rect\":" + rect_json(796, 580) + ",\"deco_rect\":" + rect_json(800, 18) +
+		",\"geometry\":" + rect_json(640, 480) + ",\"window_properties\":{\"class\":\"Term\",\"instance\":\"term\",\"title\":\"window " + std::to_string(id) + "\"}"
+		",\"nodes\":[],\"floating_nodes\":[],\"focus\":[]}";
+}
+
+static void  bench_get_tree(bench::state_t&  state, const i3ipc::synthetic_tree_params_t&  params) {
+	i3ipc::mock_server  server;
+	i3ipc::synthetic_tree  tree(params);
+	tree.install(server);
+	i3ipc::connection  conn(server.get_socket_path());
+	state.bytes_per_op = tree.get_tree_json().size();
+	state.reset_timer();
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		auto  root = conn.get_tree();
+		bench::do_not_optimize(root);
+	}
+}
+
+
+static void  bench_decode(bench::state_t&  state, const i3ipc::EventType  type, const std::string&  payload) {
+	auto  buf = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, payload);
+	buf->header->type = 0x80000000;
+	state.bytes_per_op = payload.size();
+	for (uint64_t  i = 0; i < state.iterations; i++) {
+		i3ipc::event_t  ev;
+		ev.type = type;
+		ev.buf = buf;
+		i3ipc::decode_event(ev);
+		bench::do_not_optimize(ev);
+	}
+}
+
+
+static bool  register_parsing() {
+	for (uint32_t  windows : { 10, 100, 1000, 10000 }) {
+		i3ipc::synthetic_tree_params_t  params;
+		params.windows = windows;
+		params.outputs = std::max<uint32_t>(1, windows / 500);
+		bench::add("get_tree", { { "windows", std::to_string(windows) }, { "outputs", std::to_string(params.outputs) } }, [params](bench::state_t&  state) {
+			bench_get_tree(state, params);
+		});
+	}
+
+	const std::string  workspace = "{\"num\":2,\"name\":\"2\",\"visible\":true,\"focused\":true,\"urgent\":false,\"rect\":" + rect_json(1920, 1080) + ",\"output\":\"HDMI-1\"}";
+	const std::pair<i3ipc::EventType, std::string>  events[] = {
+		{ i3ipc::ET_WORKSPACE, "{\"change\":\"focus\",\"current\":" + workspace + ",\"old\":" + workspace + "}" },
+		{ i3ipc::ET_WINDOW, "{\"change\":\"focus\",\"container\":" + window_json(42) + "}" },
+		{ i3ipc::ET_MODE, "{\"change\":\"resize\",\"pango_markup\":false}" },
+		{ i3ipc::ET_BARCONFIG_UPDATE, "{\"id\":\"bar-0\",\"mode\":\"dock\",\"position\":\"top\",\"status_command\":\"i3status\",\"font\":\"monospace 10\""
+			",\"workspace_buttons\":true,\"binding_mode_indicator\":true,\"verbose\":false,\"colors\":{\"background\":\"#000000\",\"statusline\":\"#ffffff\"}}" },
+		{ i3ipc::ET_BINDING, "{\"change\":\"run\",\"binding\":{\"command\":\"workspace 2\",\"event_state_mask\":[\"Mod4\"],\"input_code\":0"
+			",\"symbol\":\"2\",\"input_type\":\"keyboard\"}}" },
+		{ i3ipc::ET_TICK, "{\"first\":false,\"payload\":\"bench\"}" },
+	};
+	const char*  names[] = { "workspace", "window", "mode", "barconfig_update", "binding", "tick" };
+	for (size_t  i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		const auto  type = events[i].first;
+		const std::string  payload = events[i].second;
+		bench::add("decode_event", { { "type", names[i] } }, [type, payload](bench::state_t&  state) {
+			bench_decode(state, type, payload);
+		});
+	}
+	return true;
+}
+
+static const bool  g_registered = register_parsing();
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "bench.hpp"
+
+namespace bench {
+
+struct benchmark_t {
+	std::string  name;
+	params_t  params;
+	body_t  body;
+};
+
+static std::vector<benchmark_t>&  registry() {
+	static std::vector<benchmark_t>  benchmarks;
+	return benchmarks;
+}
+
+
+bool  add(const std::string&  name, const params_t&  params, body_t  body) {
+	registry().push_back({ name, params, std::move(body) });
+	return true;
+}
+
+
+static std::string  full_name(const benchmark_t&  b) {
+	std::string  name = b.name;
+	for (auto&  p : b.params) {
+		name += '/' + p.first + '=' + p.second;
+	}
+	return name;
+}
+
+
+static double  run_once(const benchmark_t&  b, const uint64_t  iterations, uint64_t&  bytes_per_op) {
+	state_t  state;
+	state.iterations = iterations;
+	state.bytes_per_op = 0;
+	state.paused = std::chrono::steady_clock::duration::zero();
+	state.start = std::chrono::steady_clock::now();
+	b.body(state);
+	const auto  elapsed = std::chrono::steady_clock::now() - state.start - state.paused;
+	bytes_per_op = state.bytes_per_op;
+	return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+
+static void  print_result(const benchmark_t&  b, const uint64_t  iterations, std::vector<double>  ns_per_op, const uint64_t  bytes_per_op) {
+	std::sort(ns_per_op.begin(), ns_per_op.end());
+	const double  median = ns_per_op[ns_per_op.size() / 2];
+
+	std::cout << "{\"name\":\"" << b.name << "\",\"params\":{";
+	bool  first = true;
+	for (auto&  p : b.params) {
+		std::cout << (first ? "" : ",") << '"' << p.first << "\":\"" << p.second << '"';
+		first = false;
+	}
+	std::cout << "},\"iterations\":" << iterations
+		<< ",\"repetitions\":" << ns_per_op.size()
+		<< ",\"ns_per_op\":{\"min\":" << ns_per_op.front() << ",\"median\":" << median << ",\"max\":" << ns_per_op.back() << '}'
+		<< ",\"ops_per_sec\":" << (median > 0 ? 1e9 / median : 0);
+	if (bytes_per_op) {
+		std::cout << ",\"bytes_per_op\":" << bytes_per_op << ",\"mb_per_sec\":" << (median > 0 ? bytes_per_op * 1e3 / median : 0);
+	}
+	std::cout << '}' << std::endl;
+}
+
+
+int  run_main(int  argc, char**  argv) {
+	std::string  filter;
+	double  min_time_ns = 200e6;
+	size_t  repetitions = 5;
+	bool  list = false;
+	for (int  i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+			min_time_ns = atof(argv[++i]) * 1e6;
+		} else if (!strcmp(argv[i], "--repetitions") && i + 1 < argc) {
+			repetitions = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--list")) {
+			list = true;
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--filter SUBSTRING] [--min-time MS] [--repetitions N] [--list]" << std::endl;
+			return 1;
+		}
+	}
+
+	for (auto&  b : registry()) {
+		const std::string  name = full_name(b);
+		if (!filter.empty() && name.find(filter) == std::string::npos)
+			continue;
+		if (list) {
+			std::cout << name << std::endl;
+			continue;
+		}
+
+		// Find the number of iterations, that takes a repetition about min_time
+		uint64_t  iterations = 1;
+		uint64_t  bytes_per_op = 0;
+		while (true) {
+			const double  elapsed = run_once(b, iterations, bytes_per_op);
+			if (elapsed >= min_time_ns / repetitions || iterations >= (uint64_t(1) << 40))
+				break;
+			const double  factor = elapsed > 0 ? min_time_ns / repetitions / elapsed * 1.2 : 10;
+			iterations = std::max<uint64_t>(iterations + 1, iterations * std::min(10.0, std::max(1.5, factor)));
+		}
+
+		std::vector<double>  ns_per_op;
+		for (size_t  r = 0; r < repetitions; r++) {
+			ns_per_op.push_back(run_once(b, iterations, bytes_per_op) / iterations);
+		}
+		print_result(b, iterations, ns_per_op, bytes_per_op);
+	}
+	return 0;
+}
+
+}
+
+
+int  main(int  argc, char**  argv) {
+	return bench::run_main(argc, argv);
+}
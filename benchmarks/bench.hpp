@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * A tiny benchmark harness. Results are printed as JSON lines, one per benchmark run
+ */
+namespace bench {
+
+/**
+ * What a benchmark body gets
+ */
+struct state_t {
+	uint64_t  iterations; ///< Number of operations to do
+	uint64_t  bytes_per_op; ///< Set by the body to report the throughput in bytes
+
+	/**
+	 * Exclude a setup from the measured time (call it after the setup)
+	 */
+	void  reset_timer() { start = std::chrono::steady_clock::now(); }
+
+	/**
+	 * Exclude a part of the body from the measured time (e.g. generation of the next batch of input)
+	 */
+	void  pause_timer() { paused_at = std::chrono::steady_clock::now(); }
+	void  resume_timer() { paused += std::chrono::steady_clock::now() - paused_at; }
+
+	std::chrono::steady_clock::time_point  start;
+	std::chrono::steady_clock::time_point  paused_at;
+	std::chrono::steady_clock::duration  paused;
+};
+
+typedef std::function<void(state_t&)>  body_t;
+typedef std::map<std::string, std::string>  params_t;
+
+/**
+ * Register a benchmark
+ * @param  name   name of the benchmark
+ * @param  params parameters, that are printed with the result (e.g. the size of the input)
+ * @param  body   the body, that does state.iterations operations
+ * @return true (to be used for static registration)
+ */
+bool  add(const std::string&  name, const params_t&  params, body_t  body);
+
+/**
+ * Run registered benchmarks. Options: --filter SUBSTRING, --min-time MS, --repetitions N, --list
+ */
+int  run_main(int  argc, char**  argv);
+
+/**
+ * Keep a value from being optimized out
+ */
+template<typename T>
+inline void  do_not_optimize(const T&  value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}
@@ -0,0 +1,317 @@
+/**
+ * This program measures how many commands per second a client can send to i3 and where the time goes.
+ * Commands are sent serially, pipelined (several requests in flight on one socket) or from several threads
+ * (a socket per thread), and the latency is reported with a breakdown by phase: packing, the write syscall,
+ * waiting for the reply, reading it and JSON parsing of the reply array.
+ *
+ * Usage: i3ipc-bench [--mode serial|pipelined|threads] [--count N] [--warmup N] [--depth N] [--threads N]
+ *                    [--command CMD]... [--socket PATH | --mock [--mock-delay US]]
+ *
+ * By default "nop" commands are sent to the running i3. With --mock a fake i3 (i3ipc::mock_server) is started
+ * in the process, optionally spending US microseconds on each command.
+ */
+
+extern "C" {
+#include <poll.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <json/json.h>
+
+#include <i3ipc++/histogram.hpp>
+#include <i3ipc++/ipc.hpp>
+#include <i3ipc++/ipc-util.hpp>
+#include <i3ipc++/mock-server.hpp>
+
+typedef std::chrono::steady_clock  bench_clock;
+
+struct options_t {
+	std::string  mode = "serial";
+	uint64_t  count = 10000; ///< Measured commands (in all threads)
+	uint64_t  warmup = 100; ///< Not measured commands (in each thread)
+	uint32_t  depth = 16; ///< Requests in flight in the pipelined mode
+	uint32_t  threads = 4; ///< Threads in the threads mode
+	std::vector<std::string>  commands;
+	std::string  socket_path;
+	bool  mock = false;
+	uint32_t  mock_delay = 0; ///< Microseconds
+};
+
+/**
+ * Phases of a command
+ */
+struct stats_t {
+	i3ipc::log_histogram  latency; ///< From the start of packing to the parsed reply
+	i3ipc::log_histogram  pack;
+	i3ipc::log_histogram  send;
+	i3ipc::log_histogram  wait; ///< Waiting for the socket to become readable
+	i3ipc::log_histogram  recv;
+	i3ipc::log_histogram  parse;
+	std::atomic<uint64_t>  failed{0}; ///< Commands with "success": false
+	std::atomic<bench_clock::rep>  measured_since{std::numeric_limits<bench_clock::rep>::max()}; ///< When the first measured command was started (in any thread)
+};
+
+
+/**
+ * Account the end of the warmup of a thread. The throughput is counted from the earliest one
+ */
+static void  start_measuring(stats_t&  stats) {
+	const bench_clock::rep  now = bench_clock::now().time_since_epoch().count();
+	bench_clock::rep  since = stats.measured_since.load();
+	while (now < since && !stats.measured_since.compare_exchange_weak(since, now)) {}
+}
+
+
+/**
+ * Parse a reply of COMMAND like i3ipc::connection::send_command() does
+ * @return number of failed commands
+ */
+static uint64_t  parse_reply(const i3ipc::buf_t&  buf) {
+	Json::CharReaderBuilder  builder;
+	std::unique_ptr<Json::CharReader>  reader{builder.newCharReader()};
+	Json::Value  root;
+	std::string  error;
+	if (!reader->parse(buf.payload, buf.payload + buf.header->size, &root, &error) || !root.isArray()) {
+		throw i3ipc::invalid_reply_payload_error("Failed to parse reply on \"COMMAND\": " + error);
+	}
+	uint64_t  failed = 0;
+	for (auto&  result : root) {
+		if (!result["success"].asBool())
+			failed++;
+	}
+	return failed;
+}
+
+
+static void  wait_readable(const int32_t  fd) {
+	struct pollfd  pfd = { fd, POLLIN, 0 };
+	while (poll(&pfd, 1, -1) == -1) {
+		if (errno != EINTR)
+			throw i3ipc::errno_error("Failed to poll the socket");
+	}
+}
+
+
+/**
+ * Send commands one by one: each one waits for the reply of the previous one
+ */
+static void  run_serial(const options_t&  options, const std::string&  socket_path, const uint64_t  count, stats_t&  stats) {
+	const int32_t  fd = i3ipc::i3_connect(socket_path);
+	for (uint64_t  i = 0; i < options.warmup + count; i++) {
+		const bool  measured = (i >= options.warmup);
+		if (i == options.warmup)
+			start_measuring(stats);
+		const auto  t0 = bench_clock::now();
+		auto  request = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, options.commands[i % options.commands.size()]);
+		const auto  t1 = bench_clock::now();
+		i3ipc::i3_send(fd, *request);
+		const auto  t2 = bench_clock::now();
+		wait_readable(fd);
+		const auto  t3 = bench_clock::now();
+		auto  reply = i3ipc::i3_recv(fd);
+		const auto  t4 = bench_clock::now();
+		const uint64_t  failed = parse_reply(*reply);
+		const auto  t5 = bench_clock::now();
+		if (measured) {
+			stats.pack.record(t1 - t0);
+			stats.send.record(t2 - t1);
+			stats.wait.record(t3 - t2);
+			stats.recv.record(t4 - t3);
+			stats.parse.record(t5 - t4);
+			stats.latency.record(t5 - t0);
+			stats.failed.fetch_add(failed, std::memory_order_relaxed);
+		}
+	}
+	i3ipc::i3_disconnect(fd);
+}
+
+
+/**
+ * Keep several commands in flight on one socket. i3 answers in order, so replies are matched by a FIFO
+ */
+static void  run_pipelined(const options_t&  options, const std::string&  socket_path, const uint64_t  count, stats_t&  stats) {
+	const int32_t  fd = i3ipc::i3_connect(socket_path);
+	const uint64_t  total = options.warmup + count;
+	std::deque<bench_clock::time_point>  in_flight;
+	uint64_t  sent = 0;
+	uint64_t  received = 0;
+	while (received < total) {
+		while (sent < total && in_flight.size() < options.depth) {
+			const bool  measured = (sent >= options.warmup);
+			if (sent == options.warmup)
+				start_measuring(stats);
+			const auto  t0 = bench_clock::now();
+			auto  request = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, options.commands[sent % options.commands.size()]);
+			const auto  t1 = bench_clock::now();
+			i3ipc::i3_send(fd, *request);
+			const auto  t2 = bench_clock::now();
+			if (measured) {
+				stats.pack.record(t1 - t0);
+				stats.send.record(t2 - t1);
+			}
+			in_flight.push_back(t0);
+			sent++;
+		}
+
+		const bool  measured = (received >= options.warmup);
+		const auto  t2 = bench_clock::now();
+		wait_readable(fd);
+		const auto  t3 = bench_clock::now();
+		auto  reply = i3ipc::i3_recv(fd);
+		const auto  t4 = bench_clock::now();
+		const uint64_t  failed = parse_reply(*reply);
+		const auto  t5 = bench_clock::now();
+		if (measured) {
+			stats.wait.record(t3 - t2);
+			stats.recv.record(t4 - t3);
+			stats.parse.record(t5 - t4);
+			stats.latency.record(t5 - in_flight.front());
+			stats.failed.fetch_add(failed, std::memory_order_relaxed);
+		}
+		in_flight.pop_front();
+		received++;
+	}
+	i3ipc::i3_disconnect(fd);
+}
+
+
+static void  print_row(const std::string&  name, const i3ipc::histogram_snapshot_t&  s) {
+	std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1);
+	std::cout << std::setw(10) << s.mean() / 1000;
+	for (double  q : { 0.5, 0.9, 0.99 }) {
+		std::cout << std::setw(10) << s.percentile(q) / 1000.0;
+	}
+	std::cout << std::setw(10) << s.max / 1000.0 << std::endl;
+}
+
+
+static void  usage(const char*  argv0) {
+	std::cerr << "Usage: " << argv0 << " [--mode serial|pipelined|threads] [--count N] [--warmup N] [--depth N] [--threads N]" << std::endl
+		<< "       [--command CMD]... [--socket PATH | --mock [--mock-delay US]]" << std::endl;
+}
+
+
+int  main(int  argc, char*  argv[]) {
+	options_t  options;
+	for (int  i = 1; i < argc; i++) {
+		const std::string  arg = argv[i];
+		if (i + 1 >= argc && arg != "--mock") {
+			usage(argv[0]);
+			return 1;
+		}
+		if (arg == "--mode") {
+			options.mode = argv[++i];
+		} else if (arg == "--count") {
+			options.count = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "--warmup") {
+			options.warmup = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "--depth") {
+			options.depth = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--threads") {
+			options.threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--command") {
+			options.commands.push_back(argv[++i]);
+		} else if (arg == "--socket") {
+			options.socket_path = argv[++i];
+		} else if (arg == "--mock") {
+			options.mock = true;
+		} else if (arg == "--mock-delay") {
+			options.mock_delay = std::strtoul(argv[++i], nullptr, 10);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (options.mode != "serial" && options.mode != "pipelined" && options.mode != "threads") {
+		usage(argv[0]);
+		return 1;
+	}
+	if (options.commands.empty()) {
+		options.commands.push_back("nop");
+	}
+
+	std::unique_ptr<i3ipc::mock_server>  server;
+	if (options.mock) {
+		server.reset(new i3ipc::mock_server());
+		const uint32_t  delay = options.mock_delay;
+		server->set_handler(i3ipc::ClientMessageType::COMMAND, [delay](const std::string&  payload) {
+			if (delay)
+				std::this_thread::sleep_for(std::chrono::microseconds(delay));
+			// A result per command of the list
+			std::string  reply = "[{\"success\":true}";
+			for (char  c : payload) {
+				if (c == ';' || c == ',')
+					reply += ",{\"success\":true}";
+			}
+			return reply + ']';
+		});
+		options.socket_path = server->get_socket_path();
+	} else if (options.socket_path.empty()) {
+		options.socket_path = i3ipc::get_socketpath();
+	}
+
+	stats_t  stats;
+	const uint32_t  threads = (options.mode == "threads" ? options.threads : 1);
+	try {
+		if (options.mode == "serial") {
+			run_serial(options, options.socket_path, options.count, stats);
+		} else if (options.mode == "pipelined") {
+			run_pipelined(options, options.socket_path, options.count, stats);
+		} else {
+			std::vector<std::thread>  workers;
+			for (uint32_t  t = 0; t < threads; t++) {
+				const uint64_t  count = options.count / threads + (t < options.count % threads ? 1 : 0);
+				workers.emplace_back([&options, &stats, count]() {
+					try {
+						run_serial(options, options.socket_path, count, stats);
+					} catch (const std::exception&  e) {
+						std::cerr << "Thread failed: " << e.what() << std::endl;
+						std::exit(1);
+					}
+				});
+			}
+			for (auto&  w : workers) {
+				w.join();
+			}
+		}
+	} catch (const std::exception&  e) {
+		std::cerr << "Failed: " << e.what() << std::endl;
+		return 1;
+	}
+	// Only the measured commands: from the end of the first warmup until the last reply
+	const bench_clock::time_point  since(bench_clock::duration(stats.measured_since.load()));
+	const double  seconds = (options.count ? std::chrono::duration<double>(bench_clock::now() - since).count() : 0);
+
+	std::cout << "mode: " << options.mode;
+	if (options.mode == "pipelined")
+		std::cout << " (depth " << options.depth << ')';
+	if (options.mode == "threads")
+		std::cout << " (" << threads << " threads)";
+	std::cout << ", socket: " << (options.mock ? "mock" : options.socket_path)
+		<< ", commands: " << options.count << ", failed: " << stats.failed.load() << std::endl;
+	std::cout << "throughput: " << std::fixed << std::setprecision(0) << (seconds > 0 ? options.count / seconds : 0) << " commands/s" << std::endl;
+	std::cout << std::left << std::setw(10) << "us" << std::right;
+	for (const char*  column : { "mean", "p50", "p90", "p99", "max" }) {
+		std::cout << std::setw(10) << column;
+	}
+	std::cout << std::endl;
+	print_row("latency", stats.latency.snapshot());
+	print_row("pack", stats.pack.snapshot());
+	print_row("send", stats.send.snapshot());
+	print_row("wait", stats.wait.snapshot());
+	print_row("recv", stats.recv.snapshot());
+	print_row("parse", stats.parse.snapshot());
+	return 0;
+}
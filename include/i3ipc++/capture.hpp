@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc-util.hpp"
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * Sockets, which frames are captured
+ */
+enum class CaptureChannel : uint8_t {
+	EVENT = 'e', ///< Events from the event socket
+	MAIN = 'm', ///< Replies from the main socket
+};
+
+/**
+ * @brief Header of a record of a capture file
+ *
+ * A capture file starts with the 8 bytes of magic "i3ipccap" and a 32-bit version, then the records
+ * follow: a header and a payload of the header's size. Integers are in the host byte order.
+ */
+struct capture_record_header_t {
+	uint64_t  time; ///< Nanoseconds since the start of the capture
+	uint8_t  channel; ///< CaptureChannel
+	uint8_t  reserved[3];
+	uint32_t  type; ///< Type of the message as it was in the i3 IPC header
+	uint32_t  size; ///< Size of the payload
+} __attribute__ ((packed));
+
+/**
+ * @brief A record of a capture file
+ */
+struct capture_record_t {
+	std::chrono::nanoseconds  time; ///< Time since the start of the capture
+	CaptureChannel  channel;
+	std::shared_ptr<buf_t>  buf; ///< The frame (header and payload)
+};
+
+
+/**
+ * @brief Writes frames into a capture file
+ *
+ * Thread-safe. Usually used through connection::start_capture()
+ */
+class capture_recorder {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	/**
+	 * Create (truncate) a capture file. Times of records are counted from here
+	 * @param  path path to the file
+	 */
+	explicit capture_recorder(const std::string&  path);
+
+	/**
+	 * Write a frame
+	 * @param  channel the socket the frame came from
+	 * @param  buf     the frame
+	 * @param  when    time of arrival of the frame
+	 */
+	void  write(const CaptureChannel  channel, const buf_t&  buf, const clock::time_point  when = clock::now());
+
+	/**
+	 * Flush buffered records into the file
+	 */
+	void  flush();
+
+	/**
+	 * Get number of written records
+	 */
+	uint64_t  records() const;
+
+private:
+	const clock::time_point  m_start;
+	mutable std::mutex  m_mutex;
+	std::ofstream  m_out;
+	uint64_t  m_records;
+};
+
+
+/**
+ * @brief Reads records of a capture file one by one
+ */
+class capture_reader {
+public:
+	/**
+	 * Open a capture file
+	 * @param  path path to the file
+	 * @throw  ipc_error if it isn't a capture file
+	 */
+	explicit capture_reader(const std::string&  path);
+
+	/**
+	 * Read the next record
+	 * @return false at the end of the file
+	 */
+	bool  next(capture_record_t&  record);
+
+private:
+	std::ifstream  m_in;
+};
+
+
+/**
+ * @brief Feeds a connection with a capture instead of i3
+ *
+ * Owns a connection over a pair of sockets and a thread, that plays i3 on the other ends:
+ * events of the capture are sent on the event socket (only of subscribed types, after the first SUBSCRIBE,
+ * like i3 does), requests on the main socket are answered with the captured replies of the same type, in
+ * order of capture (the last one is repeated, when they are over). After the last event the event socket
+ * is shut down, so handle_event() throws eof_error.
+ *
+ * Example (benchmarking of handlers on real traffic):
+ * @code{.cpp}
+ * i3ipc::capture_replayer  replayer("storm.i3cap", 0);
+ * auto&  conn = replayer.get_connection();
+ * conn.signal_window_event.connect(handler);
+ * conn.subscribe(i3ipc::ET_WINDOW);
+ * try {
+ * 	while (true)
+ * 		conn.handle_event();
+ * } catch (const i3ipc::eof_error&) {}
+ * @endcode
+ */
+class capture_replayer {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	/**
+	 * Load a capture and start replaying
+	 * @param  path  path to the capture file
+	 * @param  speed speed of replay: 1 - original timing, 2 - twice faster etc. 0 - as fast as possible
+	 */
+	capture_replayer(const std::string&  path, const double  speed = 1.0);
+	~capture_replayer();
+
+	capture_replayer(const capture_replayer&) = delete;
+	capture_replayer&  operator=(const capture_replayer&) = delete;
+
+	/**
+	 * Get the connection, which is fed by the replayer
+	 */
+	connection&  get_connection() { return *m_conn; }
+
+	/**
+	 * Get number of events in the capture
+	 */
+	size_t  size() const { return m_events.size(); }
+
+	/**
+	 * Get number of events sent to the connection
+	 */
+	uint64_t  sent() const { return m_sent.load(std::memory_order_relaxed); }
+
+	/**
+	 * Are all events sent
+	 */
+	bool  finished() const { return m_finished.load(); }
+
+private:
+	void  run();
+	bool  serve_request(const int32_t  fd, std::vector<uint8_t>&  out);
+
+	const double  m_speed;
+	std::vector<capture_record_t>  m_events;
+	std::map<uint32_t, std::vector<std::shared_ptr<buf_t>>>  m_replies; ///< Captured replies of the main socket by type
+	std::map<uint32_t, size_t>  m_next_reply;
+	int32_t  m_subscriptions;
+
+	int32_t  m_main_fd; ///< Our end of the main socket
+	int32_t  m_event_fd; ///< Our end of the event socket
+	int32_t  m_stop_fd; ///< eventfd to stop the thread
+	std::unique_ptr<connection>  m_conn;
+
+	std::atomic<uint64_t>  m_sent;
+	std::atomic<bool>  m_finished;
+	std::thread  m_thread;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ipc-util.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * Verbs of i3 commands
+ */
+enum class CommandVerb : uint8_t {
+	EXEC,
+	FOCUS,
+	MOVE,
+	RESIZE,
+	KILL,
+	MARK,
+	UNMARK,
+	LAYOUT,
+	SPLIT,
+	FLOATING,
+	FULLSCREEN,
+	STICKY,
+	BORDER,
+	TITLE_FORMAT,
+	SCRATCHPAD,
+	WORKSPACE,
+	RENAME,
+	MODE,
+	SWAP,
+	NOP,
+	RELOAD,
+	RESTART,
+};
+
+/**
+ * Keywords of arguments of i3 commands
+ */
+enum class CommandOption : uint8_t {
+	CONTAINER,
+	WINDOW,
+	WORKSPACE,
+	OUTPUT,
+	MARK,
+	TO,
+	LEFT,
+	RIGHT,
+	UP,
+	DOWN,
+	PARENT,
+	CHILD,
+	NEXT,
+	PREV,
+	CURRENT,
+	BACK_AND_FORTH,
+	NUMBER,
+	POSITION,
+	CENTER,
+	MOUSE,
+	ABSOLUTE,
+	GROW,
+	SHRINK,
+	SET,
+	WIDTH,
+	HEIGHT,
+	PX,
+	PPT,
+	OR,
+	ENABLE,
+	DISABLE,
+	TOGGLE,
+	GLOBAL,
+	DEFAULT,
+	TABBED,
+	STACKING,
+	SPLITH,
+	SPLITV,
+	HORIZONTAL,
+	VERTICAL,
+	TILING,
+	MODE_TOGGLE,
+	SHOW,
+	NORMAL,
+	PIXEL,
+	NONE,
+	ADD, ///< --add
+	REPLACE, ///< --replace
+	TOGGLE_FLAG, ///< --toggle
+	NO_AUTO_BACK_AND_FORTH, ///< --no-auto-back-and-forth
+	NO_STARTUP_ID, ///< --no-startup-id
+};
+
+/**
+ * Get the text of a verb
+ */
+std::string_view  to_string(const CommandVerb  verb);
+
+/**
+ * Get the text of an option
+ */
+std::string_view  to_string(const CommandOption  option);
+
+/**
+ * @brief Builds i3 commands right into a reusable message buffer
+ *
+ * Verbs and options are enums, criteria take typed values, and string arguments and criteria values are
+ * quoted and escaped ('"' and '\' get a backslash), so no quoting is done by hand. The buffer is kept between
+ * commands (clear() doesn't free it) and is sent as is by connection::send_commands(command_builder&),
+ * so building and sending doesn't allocate in the steady state.
+ *
+ * Commands are separated by next() (criteria are reset, like ';') or chain() (criteria apply, like ',').
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::command_builder  cmd;
+ * cmd.con_id(123).verb(i3ipc::CommandVerb::MOVE)
+ * 	.option(i3ipc::CommandOption::CONTAINER).option(i3ipc::CommandOption::TO).option(i3ipc::CommandOption::WORKSPACE)
+ * 	.arg("foo \"bar\""); // [con_id=123] move container to workspace "foo \"bar\""
+ * auto  results = conn.send_commands(cmd);
+ * @endcode
+ */
+class command_builder {
+public:
+	command_builder();
+
+	/**
+	 * Start over, keeping the buffer
+	 */
+	void  clear();
+
+	/**
+	 * @name Criteria of the current command
+	 * A criterion after the verb starts the next command
+	 * @{
+	 */
+	command_builder&  con_id(const uint64_t  id);
+	command_builder&  window_id(const uint64_t  id); ///< X11 window ID (id criterion)
+	command_builder&  window_class(const std::string_view  regex);
+	command_builder&  instance(const std::string_view  regex);
+	command_builder&  window_role(const std::string_view  regex);
+	command_builder&  title(const std::string_view  regex);
+	command_builder&  con_mark(const std::string_view  regex);
+	command_builder&  workspace(const std::string_view  regex);
+	command_builder&  floating();
+	command_builder&  tiling();
+	/**
+	 * @}
+	 */
+
+	/**
+	 * Add the verb of the current command
+	 */
+	command_builder&  verb(const CommandVerb  verb);
+
+	/**
+	 * Add a keyword argument
+	 */
+	command_builder&  option(const CommandOption  option);
+
+	/**
+	 * Add a string argument (quoted and escaped)
+	 */
+	command_builder&  arg(const std::string_view  value);
+
+	/**
+	 * Add a number argument
+	 */
+	command_builder&  arg(const int64_t  value);
+
+	/**
+	 * Start the next command. Criteria of the current command don't apply to it
+	 */
+	command_builder&  next();
+
+	/**
+	 * Start the next command, that applies to the criteria of the current one
+	 */
+	command_builder&  chain();
+
+	/**
+	 * Get number of commands (separated by next()). Each one gets a result from connection::send_commands()
+	 */
+	size_t  size() const { return m_results.size(); }
+
+	/**
+	 * Get number of results of a command (its chained commands)
+	 */
+	uint32_t  results_of(const size_t  command) const { return m_results[command]; }
+
+	/**
+	 * Get the text of the commands
+	 */
+	std::string_view  str() const;
+
+	/**
+	 * Get the COMMAND message (the size in its header is updated)
+	 */
+	const buf_t&  message();
+
+private:
+	enum class State : char {
+		EMPTY = 'e', ///< Nothing of the current command
+		CRITERIA = 'c', ///< Inside criteria
+		BODY = 'b', ///< After the verb
+	};
+
+	void  append(const std::string_view  s);
+	void  append_quoted(const std::string_view  s);
+	void  begin();
+	void  criterion(const std::string_view  name);
+
+	buf_t  m_buf;
+	State  m_state;
+	bool  m_chained; ///< The next command is chained to the current one
+	std::vector<uint32_t>  m_results; ///< Number of chained commands of each command
+};
+
+}
+
+/**
+ * @}
+ */
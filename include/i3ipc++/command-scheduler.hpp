@@ -0,0 +1,154 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Statistics of command_scheduler
+ */
+struct command_scheduler_stats_t {
+	uint64_t  scheduled; ///< Commands passed to schedule()
+	uint64_t  superseded; ///< Commands dropped, because a newer one with the same key was scheduled (saved commands)
+	uint64_t  sent; ///< Commands sent to i3
+	uint64_t  batches; ///< COMMAND messages sent to i3
+	uint64_t  failed; ///< Sent commands, that have failed
+};
+
+/**
+ * Get a key of a command for command_scheduler: its criteria and its subcommand (the verb and the known
+ * keywords after it, up to the first argument, e.g. a workspace name, a number or a quoted string)
+ * @param  command the command (e.g. "[con_id=42] move container to workspace 3")
+ * @param  key     the criteria without brackets and the subcommand (e.g. {"con_id=42", "move container to workspace"})
+ * @return false if the command is a list of commands (has ',' or ';' out of criteria and quotes), so it has no key
+ */
+bool  get_command_key(const std::string&  command, std::pair<std::string, std::string>&  key);
+
+/**
+ * @brief Collects commands over a short window and sends them as one batch
+ *
+ * Superseding is off by default. A command with criteria, which subcommand is enabled by set_superseding()
+ * (e.g. "resize set"), replaces a scheduled command with the same criteria and subcommand: the older one
+ * is dropped and the newer one takes its place at the end of the batch. Commands without criteria (they act
+ * on the focused window) and other commands are kept in order.
+ *
+ * The batch is sent with connection::send_commands() not earlier than the window after its first command
+ * and not more often than the max rate. So a burst of commands costs one round trip to i3.
+ *
+ * @note The newest command of a key wins, so enable only absolute subcommands (e.g. "resize set",
+ * "move position", "move container to workspace"): relative ones (e.g. "resize grow width") would lose steps.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::command_scheduler  scheduler(conn, std::chrono::milliseconds(5));
+ * scheduler.set_superseding("resize set", true);
+ * scheduler.schedule("[con_id=42] resize set 640 480");
+ * scheduler.schedule("[con_id=42] resize set 650 480"); // Replaces the previous one
+ * // ... in the main loop, waiting not longer than scheduler.next_deadline()
+ * scheduler.run();
+ * @endcode
+ */
+class command_scheduler {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	/**
+	 * @param  conn     connection to send commands through
+	 * @param  window   how long the first command of a batch waits for others
+	 * @param  max_rate max batches per second. 0 - no limit
+	 */
+	explicit command_scheduler(connection&  conn, const clock::duration  window = std::chrono::milliseconds(5), const double  max_rate = 0);
+
+	command_scheduler(const command_scheduler&) = delete;
+	command_scheduler&  operator=(const command_scheduler&) = delete;
+
+	void  set_window(const clock::duration  window) { m_window = window; }
+
+	/**
+	 * Set the max number of batches per second. 0 - no limit
+	 */
+	void  set_max_rate(const double  max_rate);
+
+	/**
+	 * Enable or disable superseding of commands with a subcommand (e.g. "resize set", see get_command_key())
+	 */
+	void  set_superseding(const std::string&  subcommand, const bool  enabled);
+
+	/**
+	 * Add a command to the batch and send the batch if it is due
+	 * @param  command the command
+	 * @param  now     current time
+	 */
+	void  schedule(const std::string&  command, const clock::time_point  now = clock::now());
+
+	/**
+	 * Send the batch if it is due
+	 * @param  now current time
+	 * @return true if the batch is sent
+	 */
+	bool  run(const clock::time_point  now = clock::now());
+
+	/**
+	 * Send the batch right now (ignoring the window and the max rate)
+	 */
+	void  flush();
+
+	/**
+	 * Get the time, when the batch should be sent
+	 * @return the deadline or nothing if there are no scheduled commands
+	 */
+	std::optional<clock::time_point>  next_deadline() const;
+
+	/**
+	 * Get number of scheduled commands
+	 */
+	size_t  size() const { return m_queue.size(); }
+
+	const command_scheduler_stats_t&  stats() const { return m_stats; }
+	void  reset_stats() { m_stats = command_scheduler_stats_t(); }
+
+#ifdef I3CPP_IPC_SIGCPP3
+	sigc::signal<void(const std::string&, const command_result_t&)>  signal_command_error; ///< A sent command has failed (the command and its result)
+#else
+	sigc::signal<void, const std::string&, const command_result_t&>  signal_command_error; ///< A sent command has failed (the command and its result)
+#endif
+
+private:
+	typedef std::pair<std::string, std::string>  key_t;
+
+	struct scheduled_t {
+		std::string  command;
+		std::optional<key_t>  key; ///< Set only for commands, that can be superseded
+	};
+
+	void  send(const clock::time_point  now);
+
+	connection&  m_conn;
+	clock::duration  m_window;
+	clock::duration  m_min_interval; ///< Between batches
+	std::set<std::string>  m_superseding; ///< Subcommands
+	std::list<scheduled_t>  m_queue;
+	std::map<key_t, std::list<scheduled_t>::iterator>  m_index;
+	clock::time_point  m_first; ///< When the first command of the batch was scheduled
+	std::optional<clock::time_point>  m_last_sent;
+	command_scheduler_stats_t  m_stats;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Broadcasts events of one event socket to many consumer threads
+ *
+ * One reader thread (with its own connection) reads and decodes events and publishes them into a ring
+ * buffer. Every consumer has its own cursor in the ring, so consumers don't block each other or the
+ * reader: a consumer, that lags behind by more than the capacity, skips the overwritten events (and
+ * counts them). An event is decoded once and shared by all consumers. A slot of the ring has a spinlock,
+ * that is held only to copy the pointer to its event, so the publisher and a consumer contend only if they
+ * touch the same slot at once. The list of consumers is locked only if some of them are waiting to be woken up.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::event_bus  bus(i3ipc::get_socketpath(), i3ipc::ET_WINDOW | i3ipc::ET_WORKSPACE);
+ * auto  logger = bus.subscribe();
+ * std::thread  t([logger]() {
+ * 	std::shared_ptr<const i3ipc::event_t>  ev;
+ * 	while (logger->next(ev)) {
+ * 		// ...
+ * 	}
+ * });
+ * @endcode
+ */
+class event_bus {
+public:
+	/**
+	 * @brief A cursor of a consumer thread
+	 *
+	 * Must be used from one thread at a time
+	 */
+	class consumer {
+	public:
+		~consumer();
+
+		consumer(const consumer&) = delete;
+		consumer&  operator=(const consumer&) = delete;
+
+		/**
+		 * Take the next event without waiting
+		 * @return false if there are no new events
+		 * @note If there are no new events and the bus has failed, rethrows the exception of the reader
+		 */
+		bool  try_next(std::shared_ptr<const event_t>&  ev);
+
+		/**
+		 * Take the next event, waiting for it
+		 * @param  timeout  max time to wait. Negative - forever
+		 * @return false on timeout or if the bus is stopped
+		 */
+		bool  next(std::shared_ptr<const event_t>&  ev, const std::chrono::milliseconds  timeout = std::chrono::milliseconds(-1));
+
+		/**
+		 * Skip all published events, e.g. if the consumer can't keep up and is going to resync
+		 */
+		void  skip_to_latest();
+
+		/**
+		 * Get the eventfd, that is readable, when there are new events (to poll it along with other fds)
+		 *
+		 * It is armed, when try_next() returns false
+		 */
+		int32_t  get_fd() const { return m_eventfd; }
+
+		uint64_t  lag() const; ///< Number of published events, that the consumer hasn't taken yet
+		uint64_t  skipped() const { return m_skipped; } ///< Events lost, because the consumer lagged behind by more than the capacity
+		uint64_t  taken() const { return m_taken; } ///< Events taken
+
+	private:
+		friend class event_bus;
+		consumer(event_bus&  bus, const int32_t  events);
+		bool  stop_waiting(); ///< @return Was the consumer waiting
+
+		event_bus&  m_bus;
+		const int32_t  m_events;
+		int32_t  m_eventfd;
+		std::atomic<uint64_t>  m_cursor; ///< Sequence number of the last seen event
+		std::atomic<bool>  m_waiting;
+		uint64_t  m_skipped;
+		uint64_t  m_taken;
+	};
+
+	/**
+	 * Connect to i3 and start the reader thread
+	 * @param  socket_path  path to the i3 IPC socket
+	 * @param  events       types of events to subscribe (EventType mask)
+	 * @param  capacity     capacity of the ring (rounded up to a power of two)
+	 * @param  predecode    types of events (EventType mask), that are decoded before publishing. All by default
+	 */
+	event_bus(const std::string&  socket_path, const int32_t  events, const size_t  capacity = 4096, const int32_t  predecode = ~0);
+
+	/**
+	 * Stop the bus
+	 * @note Consumer threads must be stopped (see stop()) and consumers released before the bus is destroyed
+	 */
+	~event_bus();
+
+	/**
+	 * Stop the reader thread and wake up all consumers. Waiting in consumer::next() returns false then
+	 */
+	void  stop();
+
+	event_bus(const event_bus&) = delete;
+	event_bus&  operator=(const event_bus&) = delete;
+
+	/**
+	 * Register a consumer. It gets events published after this call
+	 * @param  events types of events the consumer is interested in (EventType mask)
+	 */
+	std::shared_ptr<consumer>  subscribe(const int32_t  events = ~0);
+
+	/**
+	 * Get number of published events
+	 */
+	uint64_t  published() const { return m_published.load(std::memory_order_acquire); }
+
+	/**
+	 * Get number of consumers, that lag behind by more than the threshold
+	 * @param  threshold  lag threshold. 0 - a half of the capacity
+	 */
+	size_t  count_slow_consumers(uint64_t  threshold = 0) const;
+
+	/**
+	 * Publish an event (used by the reader thread, but can be called instead of it, if the bus is not reading)
+	 */
+	void  publish(std::shared_ptr<const event_t>  ev);
+
+	/**
+	 * Get the connection of the reader
+	 * @note It is used by the reader thread: don't handle its events, main socket requests are fine
+	 */
+	connection&  get_connection() { return *m_conn; }
+
+private:
+	struct alignas(64) slot_t {
+		std::atomic_flag  busy = ATOMIC_FLAG_INIT; ///< Spinlock of seq and ev
+		uint64_t  seq = 0; ///< Sequence number of the event in the slot. 0 - none yet
+		std::shared_ptr<const event_t>  ev;
+
+		void  lock() {
+			while (busy.test_and_set(std::memory_order_acquire)) {}
+		}
+		void  unlock() { busy.clear(std::memory_order_release); }
+	};
+
+	void  run();
+	void  wake_consumers(const bool  all);
+	void  detach(consumer*  c);
+
+	std::unique_ptr<connection>  m_conn;
+	const int32_t  m_predecode;
+	std::vector<slot_t>  m_slots;
+	const uint64_t  m_mask;
+	alignas(64) std::atomic<uint64_t>  m_published;
+	std::atomic<uint32_t>  m_waiting_consumers; ///< Consumers with armed eventfds: publish() locks the list only if there are some
+
+	mutable std::mutex  m_consumers_mutex;
+	std::list<consumer*>  m_consumers;
+
+	std::atomic<bool>  m_stop;
+	std::atomic<bool>  m_failed;
+	std::exception_ptr  m_error;
+	std::thread  m_thread;
+};
+
+}
+
+/**
+ * @}
+ */
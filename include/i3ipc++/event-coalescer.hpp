@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ipc-util.hpp"
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Statistics of event_coalescer
+ */
+struct coalescing_stats_t {
+	uint64_t  passed; ///< Events delivered without holding
+	uint64_t  held; ///< Events, that started a hold
+	uint64_t  merged; ///< Events dropped, because a newer one with the same key arrived during a hold
+	uint64_t  delivered; ///< Held events delivered
+};
+
+/**
+ * Get an ID of the object an event is about: the container of window events and the current workspace of workspace events
+ *
+ * The raw payload is scanned, no JSON is decoded
+ * @return the ID or 0 if the event isn't about a container
+ */
+uint64_t  scan_event_object_id(const EventType  type, const buf_t&  buf);
+
+/**
+ * @brief Holds bursts of events and delivers only the latest one per key
+ *
+ * A key is a triple of an event type, a value of "change" field and an ID of the container (or of the
+ * "current" workspace) of the event. Only (type, change) pairs, that were configured by set_interval(),
+ * are held; all other events (e.g. window "new" and "close") pass straight through. Before an event passes
+ * through, held events of the same container are delivered, so the order per container is kept.
+ *
+ * A held event is delivered not later than the interval after the first event of its key arrived, so
+ * the interval is the upper bound of added latency.
+ *
+ * The raw payload is scanned for the key, no JSON is decoded.
+ *
+ * Usually used through connection::get_event_coalescer().
+ */
+class event_coalescer {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	event_coalescer();
+
+	/**
+	 * Set a hold interval for a kind of events
+	 * @param  type     type of events
+	 * @param  change   value of "change" field (e.g. "title")
+	 * @param  interval hold interval. Zero disables coalescing of these events
+	 */
+	void  set_interval(const EventType  type, const std::string&  change, const clock::duration  interval);
+
+	/**
+	 * Is any kind of events configured to be coalesced
+	 */
+	bool  enabled() const { return !m_intervals.empty(); }
+
+	/**
+	 * Feed an event
+	 * @param  ev   the event
+	 * @param  now  time of arrival
+	 * @param  out  events to deliver right now, in order, are appended here
+	 */
+	void  push(const event_t&  ev, const clock::time_point  now, std::vector<event_t>&  out);
+
+	/**
+	 * Take events, which hold is over
+	 * @param  now  current time
+	 * @param  out  events to deliver, in order of arrival
+	 */
+	void  pop_due(const clock::time_point  now, std::vector<event_t>&  out);
+
+	/**
+	 * Take all held events
+	 * @param  out  events to deliver, in order of arrival
+	 */
+	void  flush(std::vector<event_t>&  out);
+
+	/**
+	 * Get the time, when the first of held events must be delivered
+	 * @return the deadline or nothing if there are no held events
+	 */
+	std::optional<clock::time_point>  next_deadline() const;
+
+	/**
+	 * Get number of held events
+	 */
+	size_t  size() const { return m_held.size(); }
+
+	const coalescing_stats_t&  stats() const { return m_stats; }
+	void  reset_stats() { m_stats = coalescing_stats_t(); }
+
+private:
+	struct key_t {
+		EventType  type;
+		std::string  change;
+		uint64_t  id;
+
+		bool  operator<(const key_t&  other) const;
+	};
+
+	struct held_t {
+		key_t  key;
+		event_t  ev;
+		clock::time_point  deadline;
+	};
+
+	std::map<std::pair<EventType, std::string>, clock::duration>  m_intervals;
+	std::list<held_t>  m_held; ///< In order of arrival of the first event of a key
+	std::map<key_t, std::list<held_t>::iterator>  m_index;
+	coalescing_stats_t  m_stats;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ipc-util.hpp"
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief A cheap filter of events
+ *
+ * Evaluated on the raw payload of an event, before any JSON is decoded. All specified conditions must match
+ */
+struct event_filter_t {
+	int32_t  events; ///< Types of events the filter applies to (EventType mask)
+	std::vector<std::string>  changes; ///< Accepted values of "change" field. Empty - any
+	uint64_t  id; ///< Accepted ID of the container of window events or of the "current" workspace of workspace events. 0 - any
+	std::string  workspace; ///< Accepted name of the "current" workspace of workspace events. Empty - any. Compared with the name as it is in JSON (escape sequences are not decoded)
+};
+
+/**
+ * @brief A set of event filters
+ *
+ * An event passes, if no filter applies to its type or if at least one of filters, that apply to its type, matches.
+ * So each subscriber adds filters for what it wants, and events nobody wants are discarded.
+ *
+ * Usually used through connection::get_event_filters().
+ */
+class event_filter_set {
+public:
+	event_filter_set();
+
+	/**
+	 * Add a filter
+	 * @return an ID of the filter for remove()
+	 */
+	uint32_t  add(const event_filter_t&  filter);
+
+	/**
+	 * Remove a filter
+	 * @param  id an ID, returned by add()
+	 */
+	void  remove(const uint32_t  id);
+
+	/**
+	 * Remove all filters
+	 */
+	void  clear();
+
+	/**
+	 * Is there any filter
+	 */
+	bool  empty() const { return m_filters.empty(); }
+
+	/**
+	 * Check an event
+	 * @param  type type of the event
+	 * @param  buf  raw message of the event
+	 * @return Should the event be handled
+	 */
+	bool  accepts(const EventType  type, const buf_t&  buf) const;
+
+	/**
+	 * Same as accepts(), but also counts discarded events
+	 */
+	bool  check(const EventType  type, const buf_t&  buf);
+
+	/**
+	 * Get number of events, discarded by check()
+	 */
+	uint64_t  discarded() const { return m_discarded; }
+
+private:
+	std::map<uint32_t, event_filter_t>  m_filters;
+	int32_t  m_events; ///< Union of events of all filters
+	uint32_t  m_next_id;
+	uint64_t  m_discarded;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <string>
+#include <thread>
+
+#include "ipc.hpp"
+#include "spsc-ring.hpp"
+
+/**
+ * @addtogroup i3ipc_util i3 IPC internal utilities
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief A thread, that reads events from a socket into a queue
+ *
+ * Used by connection::start_event_reader()
+ */
+class event_reader {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	/**
+	 * Start the thread
+	 * @param  sockfd    the event socket (already subscribed)
+	 * @param  capacity  capacity of the queue
+	 * @param  predecode types of events (EventType mask), that are decoded in the thread
+	 * @param  overflow  what to do, when the queue is full. Except of OverflowPolicy::BLOCK, the thread keeps
+	 *                   up to the capacity of events in its private backlog
+	 */
+	event_reader(const int32_t  sockfd, const size_t  capacity, const int32_t  predecode, const OverflowPolicy  overflow = OverflowPolicy::BLOCK);
+
+	/**
+	 * Stop the thread. The socket is shut down, but not closed
+	 */
+	~event_reader();
+
+	event_reader(const event_reader&) = delete;
+	event_reader&  operator=(const event_reader&) = delete;
+
+	/**
+	 * Get the eventfd, that is readable when events are queued
+	 */
+	int32_t  get_fd() const { return m_eventfd; }
+
+	/**
+	 * Take an event (consumer side)
+	 * @return false if the queue is empty
+	 * @note If the queue is empty and the thread failed, rethrows its exception
+	 */
+	bool  pop(event_t&  ev);
+
+	/**
+	 * Announce, that the consumer is going to wait on the eventfd
+	 *
+	 * Clears the eventfd and arms the notification. Must be called after the queue was found empty
+	 * @return false if events were queued meanwhile (so no need to wait)
+	 */
+	bool  prepare_to_wait();
+
+	/**
+	 * Make the eventfd readable, e.g. if the consumer has left events in the queue
+	 */
+	void  wake();
+
+	/**
+	 * Get number of events dropped by the overflow policy
+	 */
+	uint64_t  dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+	event_reader_stats_t  stats() const;
+
+private:
+	struct item_t {
+		event_t  ev;
+		clock::time_point  enqueued;
+	};
+
+	struct held_t {
+		item_t  item;
+		uint64_t  id; ///< Container of the event (OverflowPolicy::COALESCE only)
+		std::string  change; ///< "change" of the event (OverflowPolicy::COALESCE only)
+	};
+
+	void  run();
+	void  enqueue(item_t&&  item);
+	void  hold(item_t&&  item);
+	bool  flush_backlog();
+	bool  wait_for_room(const bool  socket);
+	void  notify();
+
+	const int32_t  m_sockfd;
+	const int32_t  m_predecode;
+	const OverflowPolicy  m_overflow;
+	int32_t  m_eventfd;
+	int32_t  m_room_fd; ///< eventfd, that wakes the thread, when the consumer takes an event from the full queue
+	spsc_ring<item_t>  m_ring;
+	std::deque<held_t>  m_backlog; ///< Events, that didn't fit into the queue. Used only by the thread
+
+	std::atomic<bool>  m_stop;
+	std::atomic<bool>  m_waiting; ///< Consumer waits on the eventfd
+	std::atomic<bool>  m_producer_waiting; ///< The thread waits on m_room_fd
+	std::atomic<bool>  m_failed;
+	std::exception_ptr  m_error; ///< Written by the thread before m_failed is set
+
+	std::atomic<uint64_t>  m_enqueued;
+	std::atomic<size_t>  m_max_depth;
+	std::atomic<size_t>  m_backlog_depth;
+	std::atomic<uint64_t>  m_overflows;
+	std::atomic<uint64_t>  m_dropped;
+	std::atomic<uint64_t>  m_coalesced;
+	uint64_t  m_dequeued;
+	clock::duration  m_last_queue_time;
+	clock::duration  m_max_queue_time;
+	clock::duration  m_total_queue_time;
+
+	std::thread  m_thread;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sigc++/sigc++.h>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Most-recently-used list with O(1) touch and erase
+ */
+template<typename T>
+class mru_list {
+public:
+	/**
+	 * Move an item to the front (add it if absent)
+	 */
+	void  touch(const T&  item) {
+		auto  it = m_index.find(item);
+		if (it != m_index.end()) {
+			m_order.splice(m_order.begin(), m_order, it->second);
+		} else {
+			m_order.push_front(item);
+			m_index.emplace(item, m_order.begin());
+		}
+	}
+
+	/**
+	 * Add an item to the back (if absent)
+	 */
+	void  append(const T&  item) {
+		if (m_index.count(item) == 0) {
+			m_order.push_back(item);
+			m_index.emplace(item, std::prev(m_order.end()));
+		}
+	}
+
+	/**
+	 * Remove an item
+	 * @return Was the item in the list
+	 */
+	bool  erase(const T&  item) {
+		auto  it = m_index.find(item);
+		if (it == m_index.end())
+			return false;
+		m_order.erase(it->second);
+		m_index.erase(it);
+		return true;
+	}
+
+	/**
+	 * Replace an item with another one at its position
+	 * @return Was the item in the list
+	 */
+	bool  replace(const T&  item, const T&  with) {
+		auto  it = m_index.find(item);
+		if (it == m_index.end())
+			return false;
+		auto  pos = it->second;
+		m_index.erase(it);
+		this->erase(with);
+		*pos = with;
+		m_index.emplace(with, pos);
+		return true;
+	}
+
+	bool  contains(const T&  item) const { return m_index.count(item) != 0; }
+	bool  empty() const { return m_order.empty(); }
+	size_t  size() const { return m_order.size(); }
+	const std::list<T>&  items() const { return m_order; } ///< Items, the most recent first
+
+private:
+	std::list<T>  m_order;
+	std::unordered_map<T, typename std::list<T>::iterator>  m_index;
+};
+
+
+/**
+ * @brief Tracks focus history of windows and workspaces
+ *
+ * Seeds itself from a connection::get_tree() call (using "focus" arrays of containers) and then keeps
+ * itself up to date from window (focus, new, move, close) and workspace (focus, init, rename, empty) events.
+ * Windows are identified by container IDs (container_t::id).
+ *
+ * All updates are O(1) and take no requests. A focused window is attributed to the focused workspace (i3
+ * reports the focus of a workspace before the focus of its window), and so is a new one. Window events
+ * don't tell the destination of a move, so a moved window is in no workspace list until it is focused
+ * again. Workspaces are followed by their container IDs, so renames keep their lists.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::connection  conn;
+ * i3ipc::focus_tracker  tracker(conn);
+ * while (true) {
+ * 	conn.handle_event();
+ * 	auto  mru = tracker.windows(); // mru[0] is the focused window
+ * }
+ * @endcode
+ *
+ * @note The tracker subscribes the connection on ET_WINDOW and ET_WORKSPACE events and must not outlive it
+ */
+class focus_tracker {
+public:
+	/**
+	 * Create a tracker and seed it with the current tree
+	 * @param  conn connection to i3
+	 * @throw  ipc_error if the connection can't be subscribed to ET_WINDOW and ET_WORKSPACE (e.g. its event reader is running)
+	 */
+	explicit focus_tracker(connection&  conn);
+	~focus_tracker();
+
+	focus_tracker(const focus_tracker&) = delete;
+	focus_tracker&  operator=(const focus_tracker&) = delete;
+
+	/**
+	 * Get windows of all workspaces, the most recently focused first
+	 */
+	const std::list<uint64_t>&  windows() const { return m_windows.items(); }
+
+	/**
+	 * Get windows of a workspace, the most recently focused first
+	 * @param  workspace name of the workspace
+	 */
+	std::list<uint64_t>  windows(const std::string&  workspace) const;
+
+	/**
+	 * Get names of workspaces, the most recently focused first
+	 */
+	const std::list<std::string>&  workspaces() const { return m_workspaces.items(); }
+
+	/**
+	 * Get the focused window
+	 * @return ID of the container or 0 if there is no one
+	 */
+	uint64_t  focused_window() const;
+
+	/**
+	 * Get name of the focused workspace
+	 */
+	const std::string&  focused_workspace() const { return m_focused_workspace; }
+
+private:
+	void  seed(const container_t&  node, const std::string*  workspace);
+	void  on_window_event(const window_event_t&  ev);
+	void  on_workspace_event(const workspace_event_t&  ev);
+	void  forget_window(const uint64_t  id);
+	void  attribute_window(const uint64_t  id, const std::string&  workspace);
+	void  detach_window(const uint64_t  id);
+	void  rename_workspace(const std::string&  old_name, const std::string&  new_name);
+
+	mru_list<uint64_t>  m_windows;
+	mru_list<std::string>  m_workspaces;
+	std::unordered_map< std::string, mru_list<uint64_t> >  m_workspace_windows;
+	std::unordered_map<uint64_t, std::string>  m_window_workspace;
+	std::unordered_map<uint64_t, std::string>  m_workspace_names; ///< Names of workspaces by their container IDs
+	std::string  m_focused_workspace;
+
+	sigc::connection  m_window_connection;
+	sigc::connection  m_workspace_connection;
+};
+
+}
+
+/**
+ * @}
+ */
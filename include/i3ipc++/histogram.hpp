@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief A copy of a log_histogram at some moment
+ */
+struct histogram_snapshot_t {
+	uint64_t  count; ///< Number of recorded values
+	uint64_t  sum; ///< Sum of recorded values
+	uint64_t  min; ///< Min recorded value (0 if there are none)
+	uint64_t  max; ///< Max recorded value
+	std::vector<uint64_t>  buckets; ///< Counters of buckets (see log_histogram::bucket_of())
+
+	/**
+	 * Get a percentile
+	 * @param  q  the quantile from 0 to 1 (e.g. 0.99)
+	 * @return the upper bound of the bucket of the percentile (so it is overestimated by less than 12.5%)
+	 */
+	uint64_t  percentile(const double  q) const;
+
+	double  mean() const { return count ? static_cast<double>(sum) / count : 0; }
+};
+
+/**
+ * @brief Lock-free histogram with logarithmic buckets
+ *
+ * Every power of two is split into 8 linear buckets, so any value is stored with the relative error
+ * below 12.5%, and the whole uint64_t range takes 496 counters. record() is wait-free (except of min/max
+ * updates) and can be called from any thread. Usually values are nanoseconds.
+ */
+class log_histogram {
+public:
+	static const size_t  SUB_BUCKETS = 8;
+	static const size_t  BUCKETS = (64 - 2) * SUB_BUCKETS;
+
+	log_histogram();
+
+	log_histogram(const log_histogram&) = delete;
+	log_histogram&  operator=(const log_histogram&) = delete;
+
+	/**
+	 * Record a value
+	 */
+	void  record(const uint64_t  value);
+
+	/**
+	 * Record a duration in nanoseconds
+	 */
+	template<typename Rep, typename Period>
+	void  record(const std::chrono::duration<Rep, Period>  d) {
+		const auto  ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+		this->record(static_cast<uint64_t>(ns > 0 ? ns : 0));
+	}
+
+	/**
+	 * Copy the counters. Concurrent records may be partially seen
+	 */
+	histogram_snapshot_t  snapshot() const;
+
+	/**
+	 * Clear the counters
+	 */
+	void  reset();
+
+	/**
+	 * Get an index of the bucket of a value
+	 */
+	static size_t  bucket_of(const uint64_t  value);
+
+	/**
+	 * Get the max value of a bucket
+	 */
+	static uint64_t  bucket_upper_bound(const size_t  bucket);
+
+private:
+	std::array<std::atomic<uint64_t>, BUCKETS>  m_buckets;
+	std::atomic<uint64_t>  m_sum;
+	std::atomic<uint64_t>  m_min;
+	std::atomic<uint64_t>  m_max;
+};
+
+}
+
+/**
+ * @}
+ */
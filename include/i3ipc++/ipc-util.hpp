@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 #include <stdexcept>
@@ -38,17 +39,26 @@ class ipc_error : public std::runtime_error { using std::runtime_error::runtime_
 /**
  * @brief Something wrong in message header (wrong magic number, message type etc.)
  */
-class invalid_header_error : public ipc_error { using ipc_error::ipc_error; };
+class invalid_header_error : public ipc_error {
+public:
+	invalid_header_error(const std::string&  msg);
+};
 
 /**
  * @brief Socket return EOF, but expected a data
  */
-class eof_error : public ipc_error { using ipc_error::ipc_error; };
+class eof_error : public ipc_error {
+public:
+	eof_error(const std::string&  msg);
+};
 
 /**
  * @brief If something wrong in a payload of i3's reply
  */
-class invalid_reply_payload_error : public ipc_error { using ipc_error::ipc_error; };
+class invalid_reply_payload_error : public ipc_error {
+public:
+	invalid_reply_payload_error(const std::string&  msg);
+};
 
 /**
  * @brief If any error occured, while using C-functions
@@ -72,6 +82,10 @@ enum class ClientMessageType : uint32_t {
 	GET_MARKS = 5,
 	GET_BAR_CONFIG = 6,
 	GET_VERSION = 7,
+	GET_BINDING_MODES = 8,
+	GET_CONFIG = 9,
+	SEND_TICK = 10,
+	SYNC = 11,
 };
 
 
@@ -87,6 +101,10 @@ enum class ReplyType : uint32_t {
 	MARKS = 5,
 	BAR_CONFIG = 6,
 	VERSION = 7,
+	BINDING_MODES = 8,
+	CONFIG = 9,
+	TICK = 10,
+	SYNC = 11,
 };
 
 
@@ -140,10 +158,11 @@ void   i3_send(const int32_t  sockfd, const buf_t&  buff);
 
 /**
  * @brief Recive a message from i3
- * @param  sockfd  a socket
+ * @param  sockfd     a socket
+ * @param  accounted  count the message in get_metrics(). false - for the sides, that play i3 (e.g. capture_replayer)
  * @return  a buffer of the message
  */
-std::shared_ptr<buf_t>   i3_recv(const int32_t  sockfd);
+std::shared_ptr<buf_t>   i3_recv(const int32_t  sockfd, const bool  accounted = true);
 
 /**
  * @brief Pack a buffer of message
@@ -161,6 +180,53 @@ std::shared_ptr<buf_t>  i3_pack(const ClientMessageType  type, const std::string
  */
 std::shared_ptr<buf_t>  i3_msg(const int32_t  sockfd, const ClientMessageType  type, const std::string&  payload = std::string());
 
+/**
+ * @brief Send a packed message and receive a reply
+ *
+ * Used to send a reusable buffer (e.g. of command_builder) without packing the payload again
+ * @param  sockfd  a socket
+ * @param  request the message
+ */
+std::shared_ptr<buf_t>  i3_msg(const int32_t  sockfd, const buf_t&  request);
+
+/**
+ * @brief Find a key in a JSON payload without parsing it
+ *
+ * Looks for the first occurrence of "key": at or after the position. i3 produces compact JSON and puts
+ * "change" before the nested objects, so it is enough to locate top-level fields of event payloads.
+ *
+ * @param  buff  a message
+ * @param  key   a key (without quotes)
+ * @param  from  offset in the payload to search from
+ * @return offset of the value in the payload, std::string_view::npos if not found
+ */
+size_t  i3_payload_find_key(const buf_t&  buff, const std::string_view  key, const size_t  from = 0);
+
+/**
+ * @brief Read a string value at the offset, returned by i3_payload_find_key()
+ * @param  value  raw contents of the string (escape sequences are not decoded)
+ * @return Is there a string
+ */
+bool  i3_payload_read_string(const buf_t&  buff, const size_t  pos, std::string_view&  value);
+
+/**
+ * @brief Read an unsigned integer value at the offset, returned by i3_payload_find_key()
+ * @return Is there an integer
+ */
+bool  i3_payload_read_uint(const buf_t&  buff, const size_t  pos, uint64_t&  value);
+
+/**
+ * @brief Find a field of a nested object in a JSON payload without parsing it
+ *
+ * E.g. i3_payload_find_member(buff, "container", "id") of a window event. The field is searched from the
+ * beginning of the object, so nested objects, that come earlier and have the same key, would shadow it
+ *
+ * @param  object  key of the object
+ * @param  key     key of the field
+ * @return offset of the value in the payload, std::string_view::npos if not found or the object is not an object (e.g. null)
+ */
+size_t  i3_payload_find_member(const buf_t&  buff, const std::string_view  object, const std::string_view  key);
+
 /**
  * @}
  */
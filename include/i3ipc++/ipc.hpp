@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <list>
 #include <optional>
 #include <string>
@@ -40,6 +43,7 @@ struct rect_t {
  * i3's workspace
  */
 struct workspace_t {
+	uint64_t  id; ///< ID of the workspace container (see container_t::id). 0 if i3 doesn't report it
 	int  num; ///< Index of the worksapce
 	std::string  name; ///< Name of the workspace
 	bool  visible; ///< Is the workspace visible
@@ -82,6 +86,8 @@ enum EventType {
 	ET_WINDOW = (1 << 3), ///< Window event
 	ET_BARCONFIG_UPDATE = (1 << 4), ///< Bar config update event @attention Yet is not implemented as signal in connection
 	ET_BINDING = (1 << 5), ///< Binding event
+	ET_SHUTDOWN = (1 << 6), ///< i3 is going to restart or exit
+	ET_TICK = (1 << 7), ///< Tick event (see connection::send_tick())
 };
 
 /**
@@ -109,6 +115,7 @@ enum class WindowEventType : char {
 	MOVE = 'M', ///< Window moved
 	FLOATING = '_', ///< Window toggled floating mode
 	URGENT = 'u', ///< Window became urgent
+	MARK = 'm', ///< Marks of window have been changed
 };
 
 
@@ -205,6 +212,8 @@ struct container_t {
 
 	std::list< std::shared_ptr<container_t> >  nodes;
 	std::list< std::shared_ptr<container_t> >  floating_nodes;
+	std::vector<uint64_t>  focus; ///< IDs of the child containers (both tiling and floating) in focus order, the most recently focused first. For tabbed and stacked containers the first one is the visible child
+	std::vector<std::string>  marks; ///< Marks of the container. A mark belongs to one container at most
 
 	std::map<std::string, std::string> map;
 };
@@ -250,6 +259,15 @@ struct mode_t {
 };
 
 
+/**
+ * A tick event
+ */
+struct tick_event_t {
+	bool  first; ///< Is it the tick, that is sent right after subscribing
+	std::string  payload; ///< The payload of connection::send_tick() (empty for the first tick)
+};
+
+
 /**
  * A bar configuration
  */
@@ -266,7 +284,97 @@ struct bar_config_t {
 };
 
 
+/**
+ * A result of a command
+ */
+struct command_result_t {
+	bool  success; ///< Is the command successfully executed
+	std::string  error; ///< Error message of i3 (empty on success)
+};
+
+/**
+ * Receives the result of a command, sent by connection::send_command_async()
+ */
+typedef std::function<void(const command_result_t&  result)>  command_callback_t;
+
+
 struct buf_t;
+enum class ClientMessageType : uint32_t;
+
+/**
+ * An event of i3: its raw message and, if it was decoded, its payload
+ */
+struct event_t {
+	EventType  type; ///< Type of the event
+	std::shared_ptr<const buf_t>  buf; ///< Raw message of the event
+	bool  decoded = false; ///< Is the payload decoded. Only the field according to the type is set (and could be null, if the payload is not valid)
+	std::shared_ptr<const workspace_event_t>  workspace = nullptr; ///< Payload of ET_WORKSPACE
+	std::shared_ptr<const window_event_t>  window = nullptr; ///< Payload of ET_WINDOW
+	std::shared_ptr<const mode_t>  mode = nullptr; ///< Payload of ET_MODE
+	std::shared_ptr<const bar_config_t>  bar_config = nullptr; ///< Payload of ET_BARCONFIG_UPDATE
+	std::shared_ptr<const binding_t>  binding = nullptr; ///< Payload of ET_BINDING
+	std::shared_ptr<const tick_event_t>  tick = nullptr; ///< Payload of ET_TICK
+	std::chrono::steady_clock::time_point  received = {}; ///< When the event was read from the socket. Set by the event reader, or while event timing or a capture is on
+	std::chrono::nanoseconds  decode_time = {}; ///< How long decode_event() took in the event reader thread
+};
+
+/**
+ * Decode a payload of an event
+ * @param  ev the event. Its typed field is set and decoded becomes true
+ */
+void  decode_event(event_t&  ev);
+
+
+/**
+ * What the event reader thread does, when its queue is full (see connection::start_event_reader())
+ */
+enum class OverflowPolicy : char {
+	BLOCK = 'b', ///< Stop reading the socket until there is a room in the queue (events pile up in the socket)
+	DROP_OLDEST = 'o', ///< Keep reading into a backlog and drop its oldest event, when it is full
+	DROP_NEWEST = 'n', ///< Keep reading into a backlog and drop the new event, when it is full
+	COALESCE = 'c', ///< Keep reading into a backlog. An appended event replaces an older one with the same key: the container (or workspace) id, the event type and the "change" field. The newer one goes to the end of the backlog. If there is none to replace, drop the oldest event, when the backlog is full
+};
+
+/**
+ * Statistics of the event reader thread (see connection::start_event_reader())
+ */
+struct event_reader_stats_t {
+	OverflowPolicy  policy; ///< Overflow policy
+	size_t  capacity; ///< Capacity of the queue
+	size_t  depth; ///< Number of events in the queue at the moment
+	size_t  max_depth; ///< Max number of events, that were in the queue at once
+	size_t  backlog; ///< Number of events in the backlog of the reader at the moment
+	uint64_t  enqueued; ///< Events pushed by the reader thread
+	uint64_t  dequeued; ///< Events taken by the consumer
+	uint64_t  overflows; ///< Events, that have found the queue full
+	uint64_t  dropped; ///< Events dropped by the overflow policy
+	uint64_t  coalesced; ///< Events replaced by newer ones with the same container id, type and change (OverflowPolicy::COALESCE)
+	std::chrono::nanoseconds  last_queue_time; ///< Time the last dequeued event spent in the queue
+	std::chrono::nanoseconds  max_queue_time; ///< Max time an event spent in the queue
+	std::chrono::nanoseconds  total_queue_time; ///< Total time dequeued events spent in the queue
+};
+
+
+/**
+ * Timing of an event (see connection::set_event_timing())
+ */
+struct event_timing_t {
+	EventType  type; ///< Type of the event
+	size_t  bytes; ///< Size of the message (with the header)
+	std::chrono::steady_clock::time_point  received; ///< When the event was read from the socket
+	std::chrono::steady_clock::time_point  dispatched; ///< When the dispatching started. The difference from received is the time in the queue and in the coalescing stage
+	std::chrono::nanoseconds  parse; ///< Time of JSON decoding (in any thread)
+	std::chrono::nanoseconds  dispatch; ///< Time of the slots of signal_event and typed signals, without the decoding
+	bool  predecoded; ///< Was the event decoded by the event reader thread
+};
+
+
+class capture_recorder;
+class command_builder;
+class event_coalescer;
+class event_filter_set;
+class event_reader;
+class latency_probe;
 /**
  * Connection to the i3
  */
@@ -277,6 +385,13 @@ public:
 	 * @param  socket_path path to a i3 IPC socket
 	 */
 	connection(const std::string&  socket_path = get_socketpath());
+
+	/**
+	 * Use already connected sockets (e.g. of capture_replayer). The connection takes the ownership of them
+	 * @param  main_socket  the main socket
+	 * @param  event_socket the event socket. -1 - none (it can't be connected then, because the socket path is unknown)
+	 */
+	connection(const int32_t  main_socket, const int32_t  event_socket);
 	~connection();
 
 	/**
@@ -286,6 +401,69 @@ public:
 	 */
 	bool  send_command(const std::string&  command) const;
 
+	/**
+	 * @brief Send several commands in one message and get a result of each of them
+	 *
+	 * Commands are joined with ';' (so criteria of a command don't apply to the next one) and sent in a single
+	 * request. A command may be a list itself ("focus left, move right"), then its result is successful only
+	 * if all of the list are. If i3 fails to parse a command, it stops there, so the next commands get the
+	 * error "Not executed". An empty command is successful.
+	 * @param  commands commands
+	 * @return          results in the order of the commands
+	 */
+	std::vector<command_result_t>  send_commands(const std::vector<std::string>&  commands) const;
+
+	/**
+	 * @brief Send commands of a builder in one message and get a result of each of them
+	 *
+	 * The message of the builder is sent as is (its header is updated, so the builder isn't const). Results are mapped like by send_commands(const std::vector<std::string>&),
+	 * commands are separated by command_builder::next()
+	 * @param  commands the builder
+	 * @return          results in the order of the commands
+	 */
+	std::vector<command_result_t>  send_commands(command_builder&  commands) const;
+
+	/**
+	 * @brief Send a command without waiting for its reply
+	 *
+	 * i3 replies on the main socket in order, so replies are matched to commands by a queue. They are read by
+	 * process_command_replies(), wait_command_replies() and before any synchronous request. A failed command is
+	 * reported by signal_command_error. If the number of unanswered commands is at the limit (see
+	 * set_max_pending_commands()), the oldest reply is waited for first.
+	 * @param  command  the command
+	 * @param  callback called with the result, when the reply is read. May be empty
+	 */
+	void  send_command_async(const std::string&  command, command_callback_t  callback = command_callback_t());
+
+	/**
+	 * Read replies of asynchronous commands, that have already arrived, without blocking
+	 * @return number of read replies
+	 */
+	size_t  process_command_replies();
+
+	/**
+	 * Wait for replies of all asynchronous commands
+	 */
+	void  wait_command_replies();
+
+	/**
+	 * Get number of asynchronous commands, that wait for replies
+	 */
+	size_t  get_pending_commands() const { return m_pending_commands.size(); }
+
+	/**
+	 * Set the limit of asynchronous commands, that wait for replies. 64 by default
+	 * @param  max the limit (at least 1)
+	 */
+	void  set_max_pending_commands(const size_t  max);
+
+	/**
+	 * Send a tick: i3 sends a tick event with the payload to all clients subscribed to ET_TICK
+	 * @param  payload payload of the tick event
+	 * @return         Is the tick successfully sent
+	 */
+	bool  send_tick(const std::string&  payload = std::string()) const;
+
 	/**
 	 * Request a list of workspaces
 	 * @return List of workspaces
@@ -316,6 +494,12 @@ public:
 	 */
 	std::vector<std::string>  get_bar_configs_list() const;
 
+	/**
+	 * Request a list of all marks
+	 * @return Names of marks
+	 */
+	std::vector<std::string>  get_marks() const;
+
 	/**
 	 * Request a barconfig
 	 * @param  name  name of barconfig
@@ -337,15 +521,85 @@ public:
 	 * 
 	 * @param  events event type (EventType enum)
 	 * @return        Is successfully subscribed. If connection isn't handling events at the moment, then always true.
+	 *                If the event reader is running, true only if the events are subscribed already
 	 */
 	bool  subscribe(const int32_t  events);
 
 	/**
 	 * Handle an event from i3
+	 *
+	 * Waits for an event and dispatches it. Events, that are discarded by filters (see get_event_filters()),
+	 * are dropped before signal_event is emitted.
+	 *
+	 * If event coalescing is enabled (see get_event_coalescer()), waits not longer than the deadline of
+	 * already held events and dispatches held events, which deadline is over.
+	 *
+	 * If the event reader thread is running (see start_event_reader()), waits for queued events and dispatches all of them.
 	 * @note Used only in main()
 	 */
 	void  handle_event();
 
+	/**
+	 * Get the coalescing stage of event handling
+	 *
+	 * Disabled until some intervals are configured. Example:
+	 * @code{.cpp}
+	 * #include <i3ipc++/event-coalescer.hpp>
+	 *
+	 * conn.get_event_coalescer().set_interval(i3ipc::ET_WINDOW, "title", std::chrono::milliseconds(50));
+	 * @endcode
+	 * @return the coalescer
+	 */
+	event_coalescer&  get_event_coalescer() { return *m_coalescer; }
+
+	/**
+	 * Get filters of events
+	 *
+	 * Filters are evaluated on the raw payload, so unwanted events are discarded before any JSON decoding
+	 * (and before the coalescing stage). Example:
+	 * @code{.cpp}
+	 * #include <i3ipc++/event-filter.hpp>
+	 *
+	 * conn.get_event_filters().add({ i3ipc::ET_WINDOW, { "focus", "close" }, 0, "" });
+	 * @endcode
+	 * @return the filters
+	 */
+	event_filter_set&  get_event_filters() { return *m_filters; }
+
+	/**
+	 * Enable periodic measurement of latencies with ticks (see latency_probe)
+	 *
+	 * Ticks are sent from handle_event() (or dispatch_queued_events()), so they are sent only while events
+	 * are being handled. Tick events of the probe are not dispatched. Subscribes to ET_TICK.
+	 * @param  interval interval between ticks. Zero disables the probe
+	 * @throw  ipc_error if the connection can't be subscribed to ET_TICK
+	 * @note If the event reader is used, enable the probe before starting it (or subscribe to ET_TICK)
+	 */
+	void  set_latency_probe_interval(const std::chrono::milliseconds  interval);
+
+	/**
+	 * Enable or disable collecting of timing of events
+	 *
+	 * If enabled, after every dispatched event signal_event_timing is emitted. Disabled by default and costs
+	 * almost nothing then
+	 */
+	void  set_event_timing(const bool  enabled) { m_timing = enabled; }
+
+	/**
+	 * Get timing of the last dispatched event (if timing is enabled)
+	 */
+	const event_timing_t&  get_last_event_timing() const { return m_last_timing; }
+
+	/**
+	 * Get the latency probe with its histograms
+	 */
+	const latency_probe&  get_latency_probe() const { return *m_probe; }
+
+	/**
+	 * Deliver all events, held by the coalescing stage, right now
+	 */
+	void  flush_coalesced_events();
+
 	/**
 	 * Get the fd of the main socket
 	 * @return the file descriptor of the main socket.
@@ -369,6 +623,74 @@ public:
 	 * Disconnect the event socket
 	 */
 	void  disconnect_event_socket();
+
+	/**
+	 * Start reading events in a dedicated thread
+	 *
+	 * The thread reads (and optionally decodes) events from the event socket and passes them through a
+	 * bounded lock-free single-producer/single-consumer queue to the thread, that calls handle_event()
+	 * or dispatch_queued_events(). The consumer thread is woken through an eventfd
+	 * (get_event_reader_fd()), so it can be polled along with other file descriptors:
+	 * @code{.cpp}
+	 * conn.subscribe(i3ipc::ET_WORKSPACE | i3ipc::ET_WINDOW);
+	 * conn.start_event_reader(1024, i3ipc::ET_WINDOW);
+	 * // In the UI loop, when get_event_reader_fd() is readable:
+	 * conn.dispatch_queued_events();
+	 * @endcode
+	 *
+	 * Signals are still emitted only in the consumer thread. Filters and coalescing apply on the consumer side.
+	 *
+	 * If the consumer falls behind, the overflow policy decides: either the reader stops reading (and i3
+	 * may block on the socket or drop the client), or it keeps draining the socket into a backlog of the
+	 * same capacity and sacrifices events, when the backlog is full too. After events were dropped,
+	 * signal_resync_needed is emitted, so the state can be re-fetched.
+	 *
+	 * @param  capacity  capacity of the queue (rounded up to a power of two)
+	 * @param  predecode  types of events (EventType mask), that are decoded in the reader thread
+	 * @param  overflow  what to do, when the queue is full
+	 * @note Subscribe before starting: subscribe() can't be used, while the reader is running
+	 */
+	void  start_event_reader(const size_t  capacity = 1024, const int32_t  predecode = 0, const OverflowPolicy  overflow = OverflowPolicy::BLOCK);
+
+	/**
+	 * Stop the event reader thread
+	 *
+	 * Queued events are discarded and the event socket is disconnected (it will be reconnected on the next handle_event() call)
+	 */
+	void  stop_event_reader();
+
+	/**
+	 * Get the eventfd of the event reader
+	 * @return the file descriptor, that is readable, when there are queued events. -1 if the reader isn't running
+	 */
+	int32_t  get_event_reader_fd() const;
+
+	/**
+	 * Dispatch events, queued by the event reader, without waiting
+	 * @return number of events taken from the queue
+	 * @note Rethrows an exception (e.g. eof_error), that stopped the reader thread, after the queue is drained and the taken events (with the held coalesced ones) are dispatched
+	 */
+	size_t  dispatch_queued_events();
+
+	/**
+	 * Get statistics of the event reader
+	 */
+	event_reader_stats_t  get_event_reader_stats() const;
+
+	/**
+	 * Start writing frames into a capture file (see capture_replayer)
+	 *
+	 * Events are captured at the time they are processed (before filters), replies of the main socket
+	 * at the time they arrive
+	 * @param  path        path to the file (truncated)
+	 * @param  main_socket capture replies of the main socket too
+	 */
+	void  start_capture(const std::string&  path, const bool  main_socket = false);
+
+	/**
+	 * Stop capturing and flush the file
+	 */
+	void  stop_capture();
 #ifdef I3CPP_IPC_SIGCPP3
         sigc::signal<void(const workspace_event_t&)>  signal_workspace_event; ///< Workspace event signal
 	sigc::signal<void()> signal_output_event; ///< Output event signal
@@ -376,19 +698,64 @@ public:
 	sigc::signal<void(const window_event_t&)>  signal_window_event; ///< Window event signal
 	sigc::signal<void(const bar_config_t&)>  signal_barconfig_update_event; ///< Barconfig update event signal
 	sigc::signal<void(const binding_t&)>  signal_binding_event; ///< Binding event signal
-	sigc::signal<void(EventType, const std::shared_ptr<const buf_t>&)>  signal_event; ///< i3 event signal @note Default handler routes event to signal according to type
+	sigc::signal<void(const tick_event_t&)>  signal_tick_event; ///< Tick event signal
+	sigc::signal<void()>  signal_shutdown_event; ///< Shutdown event signal
+	sigc::signal<void(const event_timing_t&)>  signal_event_timing; ///< Timing of a dispatched event (see set_event_timing())
+	sigc::signal<void(uint64_t)>  signal_resync_needed; ///< Emitted after queued events are dispatched, if the event reader has dropped some events (their number is passed) since the last emission
+	sigc::signal<void(const std::string&, const command_result_t&)>  signal_command_error; ///< A command, sent by send_command_async(), has failed (the command and its result)
+	sigc::signal<void(EventType, const std::shared_ptr<const buf_t>&)>  signal_event; ///< i3 event signal @note Default handler routes event to signal according to type. Typed signals are decoded only if they have connected slots, so slots of this signal alone get raw events almost for free
 #else
     sigc::signal<void, const workspace_event_t&>  signal_workspace_event; ///< Workspace event signal
 	sigc::signal<void>  signal_output_event; ///< Output event signal
 	sigc::signal<void, const mode_t&>  signal_mode_event; ///< Output mode event signal
 	sigc::signal<void, const window_event_t&>  signal_window_event; ///< Window event signal
 	sigc::signal<void, const bar_config_t&>  signal_barconfig_update_event; ///< Barconfig update event signal
+	sigc::signal<void, const binding_t&>  signal_binding_event; ///< Binding event signal
+	sigc::signal<void, const tick_event_t&>  signal_tick_event; ///< Tick event signal
+	sigc::signal<void>  signal_shutdown_event; ///< Shutdown event signal
+	sigc::signal<void, const event_timing_t&>  signal_event_timing; ///< Timing of a dispatched event (see set_event_timing())
+	sigc::signal<void, uint64_t>  signal_resync_needed; ///< Emitted after queued events are dispatched, if the event reader has dropped some events (their number is passed) since the last emission
+	sigc::signal<void, const std::string&, const command_result_t&>  signal_command_error; ///< A command, sent by send_command_async(), has failed (the command and its result)
+	sigc::signal<void, EventType, const std::shared_ptr<const buf_t>&>  signal_event; ///< i3 event signal @note Default handler routes event to signal according to type. Typed signals are decoded only if they have connected slots, so slots of this signal alone get raw events almost for free
 #endif
 private:
+	connection(const int32_t  main_socket, const int32_t  event_socket, const std::string&  socket_path);
+
 	const int32_t  m_main_socket;
 	int32_t  m_event_socket;
 	int32_t  m_subscriptions;
 	const std::string  m_socket_path;
+	std::unique_ptr<event_coalescer>  m_coalescer;
+	std::unique_ptr<event_filter_set>  m_filters;
+	std::unique_ptr<event_reader>  m_reader;
+	uint64_t  m_reported_drops; ///< Drops of the event reader, that signal_resync_needed was emitted for
+	const event_t*  m_dispatching; ///< An event, which signal_event is emitting at the moment
+	std::unique_ptr<capture_recorder>  m_capture;
+	bool  m_capture_main;
+	std::unique_ptr<latency_probe>  m_probe;
+	bool  m_timing;
+	event_timing_t  m_last_timing;
+	event_timing_t*  m_timing_current; ///< Timing of the event, which is dispatched at the moment
+
+	/**
+	 * A command of send_command_async(), that waits for the reply
+	 */
+	struct pending_command_t {
+		std::string  command;
+		command_callback_t  callback;
+		std::chrono::steady_clock::time_point  sent; ///< The epoch, if the metrics were disabled
+	};
+	mutable std::deque<pending_command_t>  m_pending_commands; ///< Read by synchronous requests too, so mutable
+	size_t  m_max_pending_commands;
+
+	std::shared_ptr<buf_t>  request(const ClientMessageType  type, const std::string&  payload = std::string()) const;
+	std::shared_ptr<buf_t>  request(const buf_t&  message) const;
+	void  read_command_reply() const;
+	void  run_latency_probe();
+	bool  wait_for_event(const int32_t  fd);
+	void  process_event(event_t&&  ev, std::vector<event_t>&  ready);
+	void  dispatch_event(const event_t&  ev);
+	void  dispatch_timed_event(const event_t&  ev);
 };
 
 /**
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+#include "histogram.hpp"
+#include "ipc-util.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Measures latencies of i3 IPC with ticks
+ *
+ * Every interval a tick with a unique payload is sent. Its round trip on the main socket and the delay
+ * until the tick event is processed (the whole event path including the event socket, the event reader
+ * queue and the consumer lag) are recorded into histograms (in nanoseconds).
+ *
+ * Usually used through connection::set_latency_probe_interval() and connection::get_latency_probe()
+ */
+class latency_probe {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	latency_probe();
+
+	latency_probe(const latency_probe&) = delete;
+	latency_probe&  operator=(const latency_probe&) = delete;
+
+	/**
+	 * Set the interval between ticks. Zero disables probing
+	 */
+	void  set_interval(const clock::duration  interval);
+
+	bool  enabled() const { return m_interval != clock::duration::zero(); }
+
+	/**
+	 * Get the time, when the next tick should be sent
+	 * @return the deadline or nothing if the probe is disabled
+	 */
+	std::optional<clock::time_point>  next_deadline() const;
+
+	/**
+	 * Start a probe
+	 * @param  now  current time
+	 * @return the payload of a tick to send
+	 */
+	std::string  start(const clock::time_point  now);
+
+	/**
+	 * Account the reply of SEND_TICK
+	 * @param  rtt  round trip of the request
+	 */
+	void  on_reply(const clock::duration  rtt) { m_rtt.record(rtt); }
+
+	/**
+	 * Account a tick event
+	 * @param  buf  the raw event
+	 * @param  now  time of processing
+	 * @return true if it is a tick of the probe (it shouldn't be dispatched then)
+	 */
+	bool  on_tick(const buf_t&  buf, const clock::time_point  now);
+
+	const log_histogram&  rtt() const { return m_rtt; } ///< Round trips of SEND_TICK requests
+	const log_histogram&  event_delay() const { return m_event_delay; } ///< Delays from sending a tick until its event is processed
+	uint64_t  sent() const { return m_sent; } ///< Sent ticks
+	uint64_t  received() const { return m_received; } ///< Received tick events of the probe
+	uint64_t  lost() const { return m_lost; } ///< Ticks, which events didn't come until too many newer ones were sent
+
+private:
+	clock::duration  m_interval;
+	clock::time_point  m_next;
+	const std::string  m_prefix; ///< Prefix of payloads, unique for the probe
+	uint64_t  m_seq;
+	std::map<uint64_t, clock::time_point>  m_pending; ///< Send times of ticks by sequence number
+
+	log_histogram  m_rtt;
+	log_histogram  m_event_delay;
+	uint64_t  m_sent;
+	uint64_t  m_received;
+	uint64_t  m_lost;
+};
+
+}
+
+/**
+ * @}
+ */
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <ostream>
+#include <string>
 #include <vector>
 #include <auss.hpp>
 
@@ -11,58 +16,178 @@
 
 namespace i3ipc {
 
+/**
+ * Levels of log messages
+ */
+enum class LogLevel : uint8_t {
+	VERBOSE = 0, ///< Debug messages (I3IPC_DEBUG, only in builds with DEBUG defined)
+	INFO = 1, ///< Information messages
+	WARNING = 2, ///< Warnings (e.g. unknown values in replies of i3)
+	ERROR = 3, ///< Errors
+	OFF = 4, ///< Nothing is logged
+};
+
+/**
+ * @brief Receives log messages
+ *
+ * Called from the logger thread, one message at a time
+ * @param  level   level of the message
+ * @param  message the message without a level prefix and a newline
+ */
+typedef std::function<void(LogLevel  level, const std::string&  message)>  log_sink_t;
+
 /**
  * @brief Common logging outputs
+ * @deprecated Used only by the default sink. Use set_log_sink()
  */
 extern std::vector<std::ostream*>  g_logging_outs;
 
 /**
  * @brief Logging outputs for error messages
+ * @deprecated Used only by the default sink. Use set_log_sink()
  */
 extern std::vector<std::ostream*>  g_logging_err_outs;
 
 /**
- * @brief Put to a logging outputs some dtat
+ * @brief The minimal level of messages (don't use directly)
+ */
+extern std::atomic<uint8_t>  g_log_level;
+
+/**
+ * @brief Is a level of messages logged
+ *
+ * Checked by the I3IPC_* macros before a message is formatted, so filtered messages cost a relaxed load
+ */
+inline bool  log_enabled(const LogLevel  level) {
+	return static_cast<uint8_t>(level) >= g_log_level.load(std::memory_order_relaxed);
+}
+
+/**
+ * Set the minimal level of logged messages. By default it is LogLevel::INFO (LogLevel::VERBOSE in builds with DEBUG defined)
+ */
+void  set_log_level(const LogLevel  level);
+
+/**
+ * Get the minimal level of logged messages
+ */
+LogLevel  get_log_level();
+
+/**
+ * @brief Set a receiver of log messages
+ *
+ * The default sink writes messages with a level prefix ("E: ", "W: " etc.) to g_logging_outs (INFO) and
+ * g_logging_err_outs (other levels), flushing them once per batch of messages.
+ * @param  sink the sink. nullptr restores the default one
+ */
+void  set_log_sink(log_sink_t  sink);
+
+/**
+ * @brief Limit messages of a single place of the code
+ *
+ * Messages over the limit are dropped and counted. The count is appended to the next message of the place,
+ * that passes. Repeats of the same message of a place within the interval are collapsed into a
+ * "message repeated N times: ..." note. By default it is 10 messages per second
+ * @param  messages number of messages per interval. 0 - no limit and no deduplication
+ * @param  interval the interval
+ */
+void  set_log_rate_limit(const uint32_t  messages, const std::chrono::milliseconds  interval = std::chrono::seconds(1));
+
+/**
+ * Wait until all queued messages are passed to the sink
+ */
+void  flush_log();
+
+/**
+ * @brief Get number of messages dropped since the start
+ *
+ * Messages are dropped by the rate limit and when the queue of the logger thread is full
+ */
+uint64_t  get_log_dropped();
+
+
+/**
+ * @brief A place of the code, that logs (an internal of the I3IPC_* macros)
+ */
+class log_site {
+public:
+	log_site(const char*  file, const int  line) : file(file), line(line), m_window_start(0), m_count(0), m_suppressed(0) {}
+
+	/**
+	 * Check the rate limit. Lock-free
+	 */
+	bool  allow();
+
+	/**
+	 * Take the number of messages suppressed since the last allowed one
+	 */
+	uint32_t  take_suppressed() { return m_suppressed.exchange(0, std::memory_order_relaxed); }
+
+	const char* const  file;
+	const int  line;
+
+private:
+	std::atomic<int64_t>  m_window_start; ///< Start of the current interval (nanoseconds of steady_clock)
+	std::atomic<uint32_t>  m_count; ///< Messages in the current interval
+	std::atomic<uint32_t>  m_suppressed;
+};
+
+/**
+ * @brief Queue a formatted message for the logger thread (an internal of the I3IPC_* macros)
+ * @param  level   level of the message
+ * @param  site    place of the code (nullptr - no rate limiting and deduplication)
+ * @param  message the message
+ */
+void  log_message(const LogLevel  level, log_site*  site, std::string  message);
+
+/**
+ * @brief Put to a logging outputs some data
  * @param  data  data, that you want to put to the logging outputs
  * @param  err  is your information is error report or something that must be putted to the error logging outputs
  */
 template<typename T>
 inline void  log(const T&  data, const bool  err=false) {
-	for (auto  out : (err ? g_logging_err_outs : g_logging_outs)) {
-		*out << data << std::endl;
+	const LogLevel  level = (err ? LogLevel::ERROR : LogLevel::INFO);
+	if (log_enabled(level)) {
+		log_message(level, nullptr, std::string(auss_t() << data));
 	}
 }
 
 template<>
 inline void  log(const auss_t&  data, const bool  err) {
-	log(data.to_string());
+	log(data.to_string(), err);
 }
 
 }
 
 /**
- * Internal macro used in I3IPC_*-logging macros
+ * Internal macro used in I3IPC_*-logging macros. The message is formatted only if its level is enabled and the
+ * rate limit of the place allows it
  */
-#define I3IPC_LOG(T, ERR) \
-	::i3ipc::log((T), (ERR));
+#define I3IPC_LOG(LEVEL, T) \
+	{ \
+		static ::i3ipc::log_site  i3ipc_log_site(__FILE__, __LINE__); \
+		if (::i3ipc::log_enabled(LEVEL) && i3ipc_log_site.allow()) { \
+			::i3ipc::log_message((LEVEL), &i3ipc_log_site, std::string(auss_t() << T)); \
+		} \
+	}
 
 /**
  * Put information message to log
  * @param T message
  */
-#define I3IPC_INFO(T) I3IPC_LOG(auss_t() << "i: " << T, false)
+#define I3IPC_INFO(T) I3IPC_LOG(::i3ipc::LogLevel::INFO, T)
 
 /**
  * Put error message to log
  * @param T message
  */
-#define I3IPC_ERR(T) I3IPC_LOG(auss_t() << "E: " << T, true)
+#define I3IPC_ERR(T) I3IPC_LOG(::i3ipc::LogLevel::ERROR, T)
 
 /**
  * Put warning message to log
  * @param T message
  */
-#define I3IPC_WARN(T) I3IPC_LOG(auss_t() << "W: " << T, true)
+#define I3IPC_WARN(T) I3IPC_LOG(::i3ipc::LogLevel::WARNING, T)
 
 #ifdef DEBUG
 
@@ -70,7 +195,7 @@ inline void  log(const auss_t&  data, const bool  err) {
  * Put debug message to log
  * @param T message
  */
-#define I3IPC_DEBUG(T) I3IPC_LOG(auss_t() << "D: " << T, true)
+#define I3IPC_DEBUG(T) I3IPC_LOG(::i3ipc::LogLevel::VERBOSE, T)
 
 #else
 
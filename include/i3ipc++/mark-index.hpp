@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sigc++/sigc++.h>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Index of marks: which container has a mark
+ *
+ * Seeds itself from a single connection::get_tree() call and then keeps itself up to date from window
+ * (mark, close) events, so marks are resolved in O(1) without tree requests. A mark belongs to one container
+ * at most: when i3 moves a mark to another container, the index moves it too.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::connection  conn;
+ * i3ipc::mark_index  marks(conn);
+ * // ... on a keypress
+ * if (uint64_t  id = marks.find("scratch-term"))
+ * 	conn.send_command("[con_id=" + std::to_string(id) + "] scratchpad show");
+ * @endcode
+ *
+ * @note The index subscribes the connection on ET_WINDOW events and must not outlive it
+ */
+class mark_index {
+public:
+	/**
+	 * Create an index and seed it with the current tree
+	 * @param  conn connection to i3
+	 * @throw  ipc_error if the connection can't be subscribed to ET_WINDOW (e.g. its event reader is running)
+	 */
+	explicit mark_index(connection&  conn);
+	~mark_index();
+
+	mark_index(const mark_index&) = delete;
+	mark_index&  operator=(const mark_index&) = delete;
+
+	/**
+	 * Get the container with a mark
+	 * @param  mark the mark
+	 * @return ID of the container or 0 if no container has the mark
+	 */
+	uint64_t  find(const std::string&  mark) const;
+
+	/**
+	 * Get marks of a container
+	 * @param  id ID of the container
+	 */
+	const std::vector<std::string>&  marks(const uint64_t  id) const;
+
+	/**
+	 * Get number of marks
+	 */
+	size_t  size() const { return m_containers.size(); }
+
+	/**
+	 * Rebuild the index from the current tree (e.g. after events have been lost)
+	 */
+	void  reseed();
+
+private:
+	void  seed(const container_t&  node);
+	void  on_window_event(const window_event_t&  ev);
+	void  set_marks(const uint64_t  id, const std::vector<std::string>&  marks);
+	void  forget_container(const uint64_t  id);
+
+	connection&  m_conn;
+	std::unordered_map<std::string, uint64_t>  m_containers; ///< Container of each mark
+	std::unordered_map< uint64_t, std::vector<std::string> >  m_marks; ///< Marks of each marked container
+
+	sigc::connection  m_window_connection;
+};
+
+}
+
+/**
+ * @}
+ */
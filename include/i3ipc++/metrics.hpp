@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "histogram.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * Classes of errors, counted by metrics_registry
+ */
+enum class ErrorClass : uint8_t {
+	ERRNO_ERROR = 0, ///< errno_error
+	EOF_ERROR = 1, ///< eof_error
+	INVALID_HEADER_ERROR = 2, ///< invalid_header_error
+	INVALID_REPLY_PAYLOAD_ERROR = 3, ///< invalid_reply_payload_error
+};
+
+/**
+ * Metrics of requests of one type
+ */
+struct request_metrics_t {
+	uint64_t  count; ///< Number of requests, that got a reply
+	histogram_snapshot_t  latency; ///< Round trips in nanoseconds
+};
+
+/**
+ * @brief A copy of metrics at some moment
+ */
+struct metrics_snapshot_t {
+	std::chrono::nanoseconds  period; ///< Time since the last reset
+	uint64_t  frames_sent;
+	uint64_t  frames_received;
+	uint64_t  bytes_sent;
+	uint64_t  bytes_received;
+	std::map<std::string, request_metrics_t>  requests; ///< By type of request (e.g. "GET_TREE"). Only types, that were requested
+	std::map<std::string, uint64_t>  events; ///< Received events by type (e.g. "window"). Only types, that were received
+	std::map<std::string, uint64_t>  errors; ///< Constructed exceptions by class (e.g. "eof_error"). Only classes, that occured
+	histogram_snapshot_t  parse_time; ///< Time of JSON parsing of replies and events in nanoseconds
+
+	/**
+	 * Format in the Prometheus text exposition format
+	 * @param  prefix prefix of names of metrics
+	 */
+	std::string  to_text(const std::string&  prefix = "i3ipc_") const;
+
+	/**
+	 * Format as a JSON object
+	 */
+	std::string  to_json() const;
+};
+
+/**
+ * @brief Counters of IPC traffic of the whole process
+ *
+ * Updated by i3_send(), i3_recv(), i3_msg(), by JSON parsing and by constructors of the exceptions, so all
+ * connections are accounted without any instrumentation by the user. Counters are relaxed atomics and
+ * histograms are log_histogram, so updating is lock-free and can be done from any thread. Enabled by default.
+ *
+ * Example:
+ * @code{.cpp}
+ * std::cout << i3ipc::get_metrics().snapshot().to_text();
+ * @endcode
+ */
+class metrics_registry {
+public:
+	typedef std::chrono::steady_clock  clock;
+
+	static const size_t  MAX_REQUEST_TYPES = 16;
+	static const size_t  MAX_EVENT_TYPES = 32;
+	static const size_t  MAX_ERROR_CLASSES = 4;
+
+	metrics_registry();
+
+	metrics_registry(const metrics_registry&) = delete;
+	metrics_registry&  operator=(const metrics_registry&) = delete;
+
+	/**
+	 * Enable or disable updating
+	 */
+	void  set_enabled(const bool  enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+	bool  enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+	void  on_send(const size_t  bytes);
+	void  on_receive(const uint32_t  type, const size_t  bytes);
+	void  on_reply(const uint32_t  type, const clock::duration  latency);
+	void  on_parse(const clock::duration  duration);
+	void  on_error(const ErrorClass  error_class);
+
+	/**
+	 * Copy the metrics. Concurrent updates may be partially seen
+	 */
+	metrics_snapshot_t  snapshot() const;
+
+	/**
+	 * Clear all counters
+	 */
+	void  reset();
+
+private:
+	std::atomic<bool>  m_enabled;
+	std::atomic<clock::rep>  m_since;
+	std::atomic<uint64_t>  m_frames_sent;
+	std::atomic<uint64_t>  m_frames_received;
+	std::atomic<uint64_t>  m_bytes_sent;
+	std::atomic<uint64_t>  m_bytes_received;
+	std::atomic<uint64_t>  m_requests[MAX_REQUEST_TYPES];
+	log_histogram  m_request_latency[MAX_REQUEST_TYPES];
+	std::atomic<uint64_t>  m_events[MAX_EVENT_TYPES];
+	std::atomic<uint64_t>  m_errors[MAX_ERROR_CLASSES];
+	log_histogram  m_parse_time;
+};
+
+/**
+ * Get the metrics of the process
+ */
+metrics_registry&  get_metrics();
+
+/**
+ * @brief Get a name of a message type as used in the metrics
+ * @param  type type of the message (as in header_t::type)
+ * @return  name of the request (e.g. "GET_TREE") or of the event (e.g. "window"), or the number if it is unknown
+ */
+std::string  message_type_name(const uint32_t  type);
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ipc-util.hpp"
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * Get types of events from a payload of SUBSCRIBE request
+ * @param  payload the payload (a JSON array of names of events)
+ * @return EventType mask
+ */
+int32_t  parse_subscription_payload(const std::string_view  payload);
+
+/**
+ * @brief A fake i3 for tests and benchmarks
+ *
+ * Listens on a Unix socket in a temporary directory and speaks the i3 IPC framing in its own thread, so
+ * connections can be created with get_socket_path(). Requests are answered from fixtures (set_reply()) or
+ * callbacks (set_handler()). SUBSCRIBE and SEND_TICK are handled like i3 does, other requests have
+ * minimal valid default replies. Events are sent only to clients, that have subscribed to their types.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::mock_server  server;
+ * server.set_reply(i3ipc::ClientMessageType::GET_TREE, tree_json);
+ * i3ipc::connection  conn(server.get_socket_path());
+ * conn.subscribe(i3ipc::ET_WINDOW);
+ * conn.connect_event_socket();
+ * server.send_events(i3ipc::ET_WINDOW, payloads, 10000); // 10000 events per second
+ * @endcode
+ */
+class mock_server {
+public:
+	typedef std::chrono::steady_clock  clock;
+	typedef std::function<std::string(const std::string&  payload)>  handler_t;
+
+	/**
+	 * Create the socket and start the thread
+	 */
+	mock_server();
+
+	/**
+	 * Stop the thread, close connections and remove the socket
+	 */
+	~mock_server();
+
+	mock_server(const mock_server&) = delete;
+	mock_server&  operator=(const mock_server&) = delete;
+
+	/**
+	 * Get the path of the socket
+	 */
+	const std::string&  get_socket_path() const { return m_socket_path; }
+
+	/**
+	 * Answer requests of a type with a fixed payload
+	 */
+	void  set_reply(const ClientMessageType  type, const std::string&  payload);
+
+	/**
+	 * Answer requests of a type with a callback (called in the thread of the server). Overrides set_reply()
+	 */
+	void  set_handler(const ClientMessageType  type, handler_t  handler);
+
+	/**
+	 * Send an event to subscribed clients as soon as possible
+	 * @param  type    type of the event
+	 * @param  payload JSON payload
+	 */
+	void  send_event(const EventType  type, const std::string&  payload);
+
+	/**
+	 * Send a stream of events at a rate
+	 * @param  type     type of the events
+	 * @param  payloads JSON payloads
+	 * @param  rate     events per second. 0 - as fast as possible
+	 */
+	void  send_events(const EventType  type, const std::vector<std::string>&  payloads, const double  rate = 0);
+
+	/**
+	 * Wait until all injected events are sent and written to the sockets
+	 * @return false on timeout
+	 */
+	bool  wait_idle(const std::chrono::milliseconds  timeout = std::chrono::milliseconds(5000));
+
+	/**
+	 * Get number of received requests of a type
+	 */
+	uint64_t  requests(const ClientMessageType  type) const;
+
+	/**
+	 * Get number of sent events (one per subscribed client)
+	 */
+	uint64_t  sent_events() const { return m_sent_events.load(std::memory_order_relaxed); }
+
+	/**
+	 * Get number of connected clients
+	 */
+	size_t  clients() const { return m_clients_count.load(std::memory_order_relaxed); }
+
+private:
+	struct client_t {
+		int32_t  fd;
+		std::vector<uint8_t>  in;
+		std::vector<uint8_t>  out;
+		size_t  out_pos;
+		int32_t  subscriptions;
+	};
+
+	struct pending_event_t {
+		clock::time_point  due;
+		uint32_t  type; ///< Type in the i3 IPC header
+		std::string  payload;
+	};
+
+	void  run();
+	void  wake();
+	void  accept_client();
+	bool  read_client(client_t&  client);
+	bool  write_client(client_t&  client);
+	std::string  reply_to(client_t&  client, const uint32_t  type, const std::string&  payload);
+	void  broadcast(const uint32_t  type, const std::string&  payload, const int32_t  mask);
+
+	std::string  m_dir;
+	std::string  m_socket_path;
+	int32_t  m_listen_fd;
+	int32_t  m_wake_fd;
+
+	mutable std::mutex  m_mutex;
+	std::condition_variable  m_idle;
+	std::map<uint32_t, std::string>  m_replies;
+	std::map<uint32_t, handler_t>  m_handlers;
+	std::deque<pending_event_t>  m_events; ///< Injected events in order of due time
+	bool  m_busy; ///< There are unsent events or unwritten data
+
+	std::vector<client_t>  m_clients; ///< Used only by the thread
+	std::atomic<uint64_t>  m_requests[16];
+	std::atomic<uint64_t>  m_sent_events;
+	std::atomic<size_t>  m_clients_count;
+	std::atomic<bool>  m_stop;
+	std::thread  m_thread;
+};
+
+}
+
+/**
+ * @}
+ */
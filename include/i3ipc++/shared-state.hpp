@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sigc++/sigc++.h>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief State of i3, that is shared between processes
+ */
+struct shared_state_t {
+	uint32_t  sequence; ///< Version of the state (even, increased on each publishing). 0 - nothing is published yet
+	std::shared_ptr<container_t>  tree; ///< Like connection::get_tree()
+	std::vector< std::shared_ptr<workspace_t> >  workspaces; ///< Like connection::get_workspaces()
+	std::vector< std::shared_ptr<output_t> >  outputs; ///< Like connection::get_outputs()
+};
+
+/**
+ * Get the default name of the shared memory segment of the state ("/i3ipc-state-<uid>")
+ */
+std::string  get_shared_state_name();
+
+/**
+ * @brief Publishes the tree, workspaces and outputs into a shared memory segment
+ *
+ * One process keeps a connection to i3 and publishes the state on every window, workspace and output event,
+ * so many local clients (bars, notifiers, tools) read it with state_reader without IPC requests and JSON
+ * parsing, and i3 serializes the tree once per change instead of once per client.
+ *
+ * The segment (POSIX shm_open()) must be owned by the user and have mode 0600, or it is refused
+ * by both the publisher and readers (its name is predictable). A publisher holds an exclusive flock() on
+ * it, so there is a single writer. The segment has a small header and a snapshot in a binary relocatable layout
+ * (no pointers, sections are addressed by offsets). The snapshot is written under a seqlock: the sequence
+ * is odd while it is being written, readers copy the snapshot and retry if the sequence has changed.
+ * The sequence is also a futex word, readers are woken on each publishing. The segment grows, when a
+ * snapshot doesn't fit it.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::connection  conn;
+ * i3ipc::state_publisher  publisher(conn);
+ * conn.connect_event_socket();
+ * while (true) {
+ * 	conn.handle_event();
+ * }
+ * @endcode
+ *
+ * @note Every event costs requests of the tree, workspaces and outputs. Enable coalescing of the connection
+ * (connection::get_event_coalescer()) to publish bursts of events once
+ * @note The publisher subscribes the connection on ET_WINDOW, ET_WORKSPACE and ET_OUTPUT events and must not outlive it
+ */
+class state_publisher {
+public:
+	/**
+	 * Create (or take over, if its publisher is gone) the segment and publish the current state
+	 * @param  conn connection to i3
+	 * @param  name name of the segment
+	 * @throw  ipc_error if the segment isn't private to the user or another process publishes it,
+	 *         or if the connection can't be subscribed to the events (e.g. its event reader is running)
+	 */
+	explicit state_publisher(connection&  conn, const std::string&  name = get_shared_state_name());
+
+	/**
+	 * Mark the state as closed (waiting readers are woken) and remove the segment
+	 */
+	~state_publisher();
+
+	state_publisher(const state_publisher&) = delete;
+	state_publisher&  operator=(const state_publisher&) = delete;
+
+	/**
+	 * Request the state from i3 and publish it
+	 */
+	void  publish();
+
+	/**
+	 * Get the sequence of the last publishing
+	 */
+	uint32_t  sequence() const;
+
+	/**
+	 * Get size of the last snapshot in bytes
+	 */
+	size_t  snapshot_size() const { return m_snapshot.size(); }
+
+	const std::string&  get_name() const { return m_name; }
+
+private:
+	void  resize(const size_t  capacity);
+
+	connection&  m_conn;
+	const std::string  m_name;
+	int32_t  m_fd;
+	uint8_t*  m_data; ///< The mapped segment
+	size_t  m_capacity;
+	std::vector<uint8_t>  m_snapshot; ///< Encoded out of the lock, kept to reuse its buffer
+
+	sigc::connection  m_window_connection;
+	sigc::connection  m_workspace_connection;
+	sigc::connection  m_output_connection;
+};
+
+/**
+ * @brief Reads the state, published by state_publisher
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::state_reader  reader;
+ * i3ipc::shared_state_t  state;
+ * while (!reader.is_closed()) {
+ * 	reader.read(state);
+ * 	// ... draw state.workspaces
+ * 	reader.wait(state.sequence);
+ * }
+ * @endcode
+ */
+class state_reader {
+public:
+	/**
+	 * Map the segment
+	 * @param  name name of the segment
+	 * @throw  errno_error if there is no segment (no publisher)
+	 * @throw  ipc_error if the segment isn't private to the user
+	 */
+	explicit state_reader(const std::string&  name = get_shared_state_name());
+	~state_reader();
+
+	state_reader(const state_reader&) = delete;
+	state_reader&  operator=(const state_reader&) = delete;
+
+	/**
+	 * Get the current sequence (odd while a snapshot is being written)
+	 */
+	uint32_t  sequence() const;
+
+	/**
+	 * Is the publisher gone (the state won't be updated anymore)
+	 */
+	bool  is_closed() const;
+
+	/**
+	 * Wait for a newer state
+	 * @param  sequence sequence of the state, that the caller has
+	 * @param  timeout  max time to wait. Negative - forever
+	 * @return true if a state with another sequence is published (or the publisher is gone), false on timeout
+	 */
+	bool  wait(const uint32_t  sequence, const std::chrono::milliseconds  timeout = std::chrono::milliseconds(-1)) const;
+
+	/**
+	 * Read a consistent snapshot of the state
+	 * @param  state the state to fill (the whole state is replaced)
+	 * @return the sequence of the state
+	 * @throw  ipc_error if the publisher has died while writing a snapshot, or a snapshot isn't finished in a second
+	 */
+	uint32_t  read(shared_state_t&  state);
+
+private:
+	void  map(const size_t  size);
+	void  check_writer(std::chrono::steady_clock::time_point&  deadline) const;
+
+	const std::string  m_name;
+	int32_t  m_fd;
+	uint8_t*  m_data; ///< The mapped segment
+	size_t  m_mapped;
+	std::vector<uint8_t>  m_copy; ///< The last copied snapshot, kept to reuse its buffer
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Spatial index over the visible windows of a tree
+ *
+ * Built once from a root container (as returned by connection::get_tree()) and answers
+ * "which window is at (x, y)" and "which windows intersect a rectangle" without walking the tree.
+ *
+ * Only what is actually on screen is indexed:
+ * - only the visible workspace of each output (hidden outputs like "__i3" are skipped);
+ * - only the focused child of tabbed and stacked containers, but the tabs/titles of all children;
+ * - floating windows are above tiling ones, the later in floating_nodes the higher;
+ * - fullscreen windows are above everything on their workspace.
+ *
+ * Rectangles are bucketed into a uniform grid, so a point lookup only checks the windows of one cell.
+ *
+ * Example:
+ * @code{.cpp}
+ * i3ipc::spatial_index  index(conn.get_tree());
+ * auto  window = index.window_at(x, y);
+ * @endcode
+ */
+class spatial_index {
+public:
+	/**
+	 * Build an index
+	 * @param  root a root container of a tree
+	 */
+	explicit spatial_index(const std::shared_ptr<container_t>&  root);
+
+	/**
+	 * Find the topmost window at a point
+	 * @param  x absolute X coordinate
+	 * @param  y absolute Y coordinate
+	 * @return A container of the window (or of the tab, if a point is on a tab/title of tabbed or stacked container). Null if nothing is there
+	 */
+	std::shared_ptr<container_t>  window_at(const int32_t  x, const int32_t  y) const;
+
+	/**
+	 * Find all visible windows, that intersect a rectangle
+	 * @param  region a rectangle in absolute coordinates
+	 * @return Containers ordered from the topmost to the bottommost. Each container is listed once
+	 */
+	std::vector< std::shared_ptr<container_t> >  windows_in(const rect_t&  region) const;
+
+	/**
+	 * Get number of indexed rectangles (windows and tabs)
+	 */
+	size_t  size() const { return m_entries.size(); }
+
+private:
+	struct entry_t {
+		rect_t  rect;
+		uint32_t  z; ///< Stacking order, the bigger the higher
+		std::shared_ptr<container_t>  container;
+	};
+
+	void  collect(const std::shared_ptr<container_t>&  node, uint32_t  z);
+	void  add(const rect_t&  rect, const uint32_t  z, const std::shared_ptr<container_t>&  container);
+	void  build_grid();
+	bool  cell_range(const rect_t&  rect, uint32_t&  col0, uint32_t&  row0, uint32_t&  col1, uint32_t&  row1) const;
+
+	std::vector<entry_t>  m_entries;
+	uint32_t  m_next_floating_z;
+
+	int64_t  m_origin_x;
+	int64_t  m_origin_y;
+	uint32_t  m_cell_size;
+	uint32_t  m_cols;
+	uint32_t  m_rows;
+	std::vector<uint32_t>  m_cell_offsets; ///< Cell i holds m_cell_items[m_cell_offsets[i] .. m_cell_offsets[i + 1])
+	std::vector<uint32_t>  m_cell_items; ///< Indices in m_entries
+};
+
+}
+
+/**
+ * @}
+ */
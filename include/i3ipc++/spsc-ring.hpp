@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @addtogroup i3ipc_util i3 IPC internal utilities
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer queue
+ *
+ * push() must be called only from one thread and pop() only from another one.
+ * Indices are kept on separate cache lines and each side caches the index of the other one, so
+ * the shared cache lines are touched only when the cached index says the queue is full (or empty).
+ */
+template<typename T>
+class spsc_ring {
+public:
+	/**
+	 * @param  capacity  max number of items, rounded up to a power of two
+	 */
+	explicit spsc_ring(size_t  capacity) : m_head(0), m_tail(0), m_cached_head(0), m_cached_tail(0) {
+		size_t  n = 1;
+		while (n < capacity)
+			n <<= 1;
+		m_mask = n - 1;
+		m_items.resize(n);
+	}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring&  operator=(const spsc_ring&) = delete;
+
+	/**
+	 * Push an item (producer side)
+	 * @return false if the queue is full
+	 */
+	bool  push(T&&  item) {
+		const size_t  tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_cached_head > m_mask) {
+			m_cached_head = m_head.load(std::memory_order_acquire);
+			if (tail - m_cached_head > m_mask)
+				return false;
+		}
+		m_items[tail & m_mask] = std::move(item);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Pop an item (consumer side)
+	 * @return false if the queue is empty
+	 */
+	bool  pop(T&  item) {
+		const size_t  head = m_head.load(std::memory_order_relaxed);
+		if (head == m_cached_tail) {
+			m_cached_tail = m_tail.load(std::memory_order_acquire);
+			if (head == m_cached_tail)
+				return false;
+		}
+		item = std::move(m_items[head & m_mask]);
+		m_items[head & m_mask] = T();
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Get number of items (exact only if called from one of sides, while another one is idle)
+	 */
+	size_t  size() const {
+		const size_t  head = m_head.load(std::memory_order_acquire);
+		return m_tail.load(std::memory_order_acquire) - head;
+	}
+
+	bool  empty() const { return this->size() == 0; }
+	size_t  capacity() const { return m_mask + 1; }
+
+private:
+	std::vector<T>  m_items;
+	size_t  m_mask;
+
+	alignas(64) std::atomic<size_t>  m_head; ///< Written by the consumer
+	alignas(64) std::atomic<size_t>  m_tail; ///< Written by the producer
+	alignas(64) size_t  m_cached_head; ///< Producer's copy of m_head
+	alignas(64) size_t  m_cached_tail; ///< Consumer's copy of m_tail
+};
+
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ipc.hpp"
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+class mock_server;
+struct synthetic_node_t;
+
+/**
+ * @brief Parameters of a synthetic tree
+ */
+struct synthetic_tree_params_t {
+	uint32_t  seed = 1; ///< Seed of the generator. Same parameters give the same tree and events
+	uint32_t  outputs = 1; ///< Number of outputs (placed side by side)
+	uint32_t  workspaces_per_output = 4; ///< Number of workspaces on each output
+	uint32_t  windows = 100; ///< Number of windows (tiling and floating)
+	uint32_t  max_depth = 3; ///< Maximal nesting of split containers inside a workspace
+	double  floating_ratio = 0.05; ///< Share of floating windows
+	double  tabbed_ratio = 0.2; ///< Share of split containers with tabbed layout
+	double  stacked_ratio = 0.1; ///< Share of split containers with stacked layout
+	uint32_t  output_width = 1920; ///< Width of an output
+	uint32_t  output_height = 1080; ///< Height of an output
+};
+
+/**
+ * @brief An event of a synthetic stream
+ */
+struct synthetic_event_t {
+	EventType  type; ///< ET_WINDOW or ET_WORKSPACE
+	std::string  payload; ///< JSON payload as i3 sends it
+};
+
+/**
+ * @brief Generator of realistic i3 trees and matching streams of events
+ *
+ * Builds a tree like i3 has: root, outputs (and the "__i3" one with the scratchpad), content containers,
+ * workspaces with nested splith/splitv/tabbed/stacked containers and floating containers. Containers have
+ * consistent rect, window_rect, deco_rect, percent, focus arrays and window_properties. The generated
+ * events (focus, title, new, close, move, floating of windows and focus of workspaces) are applied to the
+ * tree, so get_tree_json() after them describes the state i3 would have.
+ *
+ * Example (scaling of a parser):
+ * @code{.cpp}
+ * i3ipc::synthetic_tree_params_t  params;
+ * params.outputs = 10;
+ * params.windows = 5000;
+ * i3ipc::synthetic_tree  tree(params);
+ * i3ipc::mock_server  server;
+ * tree.install(server);
+ * i3ipc::connection  conn(server.get_socket_path());
+ * auto  root = conn.get_tree();
+ * @endcode
+ */
+class synthetic_tree {
+public:
+	/**
+	 * Generate a tree
+	 */
+	explicit synthetic_tree(const synthetic_tree_params_t&  params = synthetic_tree_params_t());
+	~synthetic_tree();
+
+	synthetic_tree(const synthetic_tree&) = delete;
+	synthetic_tree&  operator=(const synthetic_tree&) = delete;
+
+	/**
+	 * Get a GET_TREE reply
+	 */
+	std::string  get_tree_json() const;
+
+	/**
+	 * Get a GET_WORKSPACES reply
+	 */
+	std::string  get_workspaces_json() const;
+
+	/**
+	 * Get a GET_OUTPUTS reply
+	 */
+	std::string  get_outputs_json() const;
+
+	/**
+	 * Set replies of GET_TREE, GET_WORKSPACES and GET_OUTPUTS of a mock server to the current state
+	 */
+	void  install(mock_server&  server) const;
+
+	/**
+	 * Generate events and apply them to the tree
+	 * @param  count number of events (a window focus, that changes the focused workspace, is preceded by a workspace event, which is counted too)
+	 * @return the events in order
+	 */
+	std::vector<synthetic_event_t>  generate_events(const size_t  count);
+
+	/**
+	 * Get number of containers in the tree (including root, outputs and workspaces)
+	 */
+	size_t  containers() const;
+
+	/**
+	 * Get number of windows
+	 */
+	size_t  windows() const { return m_windows.size(); }
+
+	/**
+	 * Get ID of the focused window (0 if there is no windows)
+	 */
+	uint64_t  focused_window() const;
+
+private:
+	typedef synthetic_node_t  node_t;
+
+	node_t*  add_node(node_t*  parent, const std::string&  type, const bool  floating);
+	node_t*  add_window(node_t*  parent, const bool  floating);
+	node_t*  attach(node_t*  parent, std::unique_ptr<node_t>  node, const bool  floating);
+	std::unique_ptr<node_t>  detach(node_t*  node);
+	void  build_split(node_t*  parent, const size_t  windows, const uint32_t  depth);
+	void  layout(node_t*  node);
+	void  focus(node_t*  window);
+	node_t*  workspace_of(node_t*  node) const;
+	node_t*  output_of(node_t*  node) const;
+	node_t*  random_window();
+	node_t*  random_workspace();
+	std::string  workspace_event(const std::string&  change, node_t*  current, node_t*  old) const;
+	std::string  window_event(const std::string&  change, node_t*  window) const;
+
+	const synthetic_tree_params_t  m_params;
+	std::mt19937  m_random;
+	std::unique_ptr<node_t>  m_root;
+	std::vector<node_t*>  m_workspaces;
+	std::vector<node_t*>  m_windows;
+	node_t*  m_focused;
+	uint64_t  m_next_id;
+	uint64_t  m_next_xid;
+};
+
+}
+
+/**
+ * @}
+ */
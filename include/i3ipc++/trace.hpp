@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @addtogroup i3ipc i3 IPC C++ binding
+ * @{
+ */
+namespace i3ipc {
+
+/**
+ * @brief A finished span
+ */
+struct trace_event_t {
+	const char*  name; ///< Name of the span (e.g. "i3_send", "parse_json", "dispatch")
+	int64_t  start; ///< Start in nanoseconds since the start of tracing
+	int64_t  duration; ///< Duration in nanoseconds
+	uint32_t  thread_id; ///< Kernel ID of the thread
+	uint32_t  type; ///< Type of the message (as in header_t::type, events have the highest bit set)
+	size_t  bytes; ///< Size of the message with the header. 0 - no message
+};
+
+/**
+ * @brief Receives finished spans
+ *
+ * Called from the thread of the span under a lock, so one span at a time. Must not start spans itself
+ */
+typedef std::function<void(const trace_event_t&  event)>  trace_sink_t;
+
+/**
+ * @brief Is tracing enabled (don't use directly)
+ */
+extern std::atomic<bool>  g_trace_enabled;
+
+/**
+ * @brief Is tracing enabled
+ *
+ * Checked by trace_span, so spans cost a relaxed load and a branch if tracing is disabled
+ */
+inline bool  trace_enabled() {
+	return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Start tracing to a file in the Chrome trace event format
+ *
+ * The file can be opened with chrome://tracing or https://ui.perfetto.dev. A previous trace is stopped.
+ * Spans are written as complete ("X") events with the type and the size of the message in arguments.
+ * @param  path path of the file
+ */
+void  start_trace(const std::string&  path);
+
+/**
+ * @brief Start tracing to a sink
+ *
+ * A previous trace is stopped
+ * @param  sink the sink
+ */
+void  start_trace(trace_sink_t  sink);
+
+/**
+ * @brief Stop tracing
+ *
+ * Spans, that are running now, are dropped. A trace file is completed and closed
+ */
+void  stop_trace();
+
+
+/**
+ * @brief A span of the tracing
+ *
+ * Measures the time from the construction to the destruction. Used by i3_send(), i3_recv(), i3_msg(), the JSON
+ * parsing, the tree parsing and the event dispatching, and can be used by an application for its own spans.
+ *
+ * Example:
+ * @code{.cpp}
+ * {
+ * 	i3ipc::trace_span  span("redraw");
+ * 	redraw();
+ * }
+ * @endcode
+ */
+class trace_span {
+public:
+	/**
+	 * @param  name  name of the span. Must be a static string
+	 * @param  type  type of the message
+	 * @param  bytes size of the message with the header. 0 - no message
+	 */
+	explicit trace_span(const char*  name, const uint32_t  type = 0, const size_t  bytes = 0) :
+		m_name(name),
+		m_type(type),
+		m_bytes(bytes),
+		m_start(trace_enabled() ? now() : -1)
+	{}
+
+	~trace_span() {
+		if (m_start >= 0)
+			this->finish();
+	}
+
+	trace_span(const trace_span&) = delete;
+	trace_span&  operator=(const trace_span&) = delete;
+
+	/**
+	 * Set the message of the span (e.g. when it becomes known after reading)
+	 */
+	void  set_message(const uint32_t  type, const size_t  bytes) {
+		m_type = type;
+		m_bytes = bytes;
+	}
+
+private:
+	/**
+	 * Current time of steady_clock in nanoseconds
+	 */
+	static int64_t  now();
+
+	void  finish();
+
+	const char*  m_name;
+	uint32_t  m_type;
+	size_t  m_bytes;
+	int64_t  m_start; ///< -1 - tracing was disabled
+};
+
+}
+
+/**
+ * @}
+ */
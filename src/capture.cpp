@@ -0,0 +1,275 @@
+extern "C" {
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+}
+
+#include <cstring>
+#include <optional>
+
+#include <auss.hpp>
+
+#include "log.hpp"
+#include "capture.hpp"
+#include "mock-server.hpp"
+
+namespace i3ipc {
+
+static const char  g_capture_magic[8] = { 'i', '3', 'i', 'p', 'c', 'c', 'a', 'p' };
+static const uint32_t  g_capture_version = 1;
+
+
+capture_recorder::capture_recorder(const std::string&  path) :
+	m_start(clock::now()),
+	m_out(path, std::ios::binary | std::ios::trunc),
+	m_records(0)
+{
+	if (!m_out) {
+		throw errno_error("Failed to create capture file " + path);
+	}
+	m_out.write(g_capture_magic, sizeof(g_capture_magic));
+	m_out.write(reinterpret_cast<const char*>(&g_capture_version), sizeof(g_capture_version));
+}
+
+
+void  capture_recorder::write(const CaptureChannel  channel, const buf_t&  buf, const clock::time_point  when) {
+	capture_record_header_t  header;
+	memset(&header, 0, sizeof(header));
+	header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(when - m_start).count();
+	header.channel = static_cast<uint8_t>(channel);
+	header.type = buf.header->type;
+	header.size = buf.header->size;
+
+	std::lock_guard<std::mutex>  lock(m_mutex);
+	m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_out.write(buf.payload, buf.header->size);
+	if (!m_out) {
+		throw errno_error("Failed to write capture file");
+	}
+	m_records++;
+}
+
+
+void  capture_recorder::flush() {
+	std::lock_guard<std::mutex>  lock(m_mutex);
+	m_out.flush();
+}
+
+
+uint64_t  capture_recorder::records() const {
+	std::lock_guard<std::mutex>  lock(m_mutex);
+	return m_records;
+}
+
+
+capture_reader::capture_reader(const std::string&  path) : m_in(path, std::ios::binary) {
+	if (!m_in) {
+		throw errno_error("Failed to open capture file " + path);
+	}
+	char  magic[sizeof(g_capture_magic)];
+	uint32_t  version = 0;
+	m_in.read(magic, sizeof(magic));
+	m_in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!m_in || memcmp(magic, g_capture_magic, sizeof(magic)) != 0) {
+		throw invalid_header_error("Not a capture file: " + path);
+	}
+	if (version != g_capture_version) {
+		throw invalid_header_error(auss_t() << "Unsupported version of capture file: " << version);
+	}
+}
+
+
+bool  capture_reader::next(capture_record_t&  record) {
+	capture_record_header_t  header;
+	m_in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (m_in.gcount() == 0) {
+		return false;
+	}
+	if (m_in.gcount() != sizeof(header)) {
+		throw eof_error("Truncated capture file");
+	}
+
+	const uint32_t  size = header.size;
+	record.time = std::chrono::nanoseconds(header.time);
+	record.channel = static_cast<CaptureChannel>(header.channel);
+	record.buf = std::make_shared<buf_t>(size);
+	record.buf->header->type = header.type;
+	m_in.read(record.buf->payload, size);
+	if (static_cast<uint32_t>(m_in.gcount()) != size) {
+		throw eof_error("Truncated capture file");
+	}
+	return true;
+}
+
+
+capture_replayer::capture_replayer(const std::string&  path, const double  speed) :
+	m_speed(speed),
+	m_subscriptions(0),
+	m_main_fd(-1),
+	m_event_fd(-1),
+	m_stop_fd(-1),
+	m_sent(0),
+	m_finished(false)
+{
+	capture_reader  reader(path);
+	capture_record_t  record;
+	while (reader.next(record)) {
+		if (record.channel == CaptureChannel::EVENT) {
+			m_events.push_back(std::move(record));
+		} else {
+			m_replies[record.buf->header->type].push_back(std::move(record.buf));
+		}
+	}
+
+	int  main_pair[2];
+	int  event_pair[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, main_pair) == -1) {
+		throw errno_error("Failed to create a socket pair");
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, event_pair) == -1) {
+		close(main_pair[0]);
+		close(main_pair[1]);
+		throw errno_error("Failed to create a socket pair");
+	}
+	m_main_fd = main_pair[1];
+	m_event_fd = event_pair[1];
+	m_stop_fd = eventfd(0, EFD_CLOEXEC);
+	m_conn.reset(new connection(main_pair[0], event_pair[0]));
+
+	m_thread = std::thread(&capture_replayer::run, this);
+}
+
+capture_replayer::~capture_replayer() {
+	const uint64_t  one = 1;
+	(void)!::write(m_stop_fd, &one, sizeof(one));
+	m_thread.join();
+	m_conn.reset();
+	close(m_main_fd);
+	close(m_event_fd);
+	close(m_stop_fd);
+}
+
+
+/**
+ * Read a request and queue a reply into out
+ * @return false if the peer has closed the socket
+ */
+bool  capture_replayer::serve_request(const int32_t  fd, std::vector<uint8_t>&  out) {
+	std::shared_ptr<buf_t>  request;
+	try {
+		request = i3_recv(fd, false); // Requests are accounted by the sending connection
+	} catch (const ipc_error&) {
+		return false;
+	}
+
+	const uint32_t  type = request->header->type;
+	std::shared_ptr<buf_t>  reply;
+	if (fd == m_event_fd) {
+		if (type == static_cast<uint32_t>(ClientMessageType::SUBSCRIBE)) {
+			m_subscriptions |= parse_subscription_payload(std::string_view(request->payload, request->header->size));
+			reply = i3_pack(ClientMessageType::SUBSCRIBE, "{\"success\":true}");
+		}
+	} else {
+		auto  replies = m_replies.find(type);
+		if (replies != m_replies.end()) {
+			size_t&  next = m_next_reply[type];
+			reply = replies->second[std::min(next, replies->second.size() - 1)];
+			next++;
+		}
+	}
+	if (!reply) {
+		I3IPC_WARN("Replayer: no captured reply to a request of type " << type)
+		reply = i3_pack(static_cast<ClientMessageType>(type), "[]");
+	}
+	out.insert(out.end(), reply->data.begin(), reply->data.end());
+	return true;
+}
+
+
+void  capture_replayer::run() {
+	std::optional<clock::time_point>  start; ///< When the first SUBSCRIBE arrived
+	size_t  next = 0;
+	std::vector<uint8_t>  main_out;
+	std::vector<uint8_t>  event_out;
+	size_t  event_out_pos = 0;
+	bool  main_open = true;
+	bool  event_open = true;
+
+	while (event_open || main_open) {
+		int  timeout = -1;
+		if (start && event_open) {
+			const clock::time_point  now = clock::now();
+			while (next < m_events.size() && event_out.size() - event_out_pos < 65536) {
+				const capture_record_t&  record = m_events[next];
+				if (!(m_subscriptions & (1 << (record.buf->header->type & 0x7f)))) {
+					next++;
+					continue;
+				}
+				if (m_speed > 0) {
+					const auto  due = *start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::nano>(record.time.count() / m_speed));
+					if (due > now) {
+						timeout = std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count() + 1;
+						break;
+					}
+				}
+				event_out.insert(event_out.end(), record.buf->data.begin(), record.buf->data.end());
+				next++;
+				m_sent.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (next == m_events.size() && event_out_pos == event_out.size()) {
+				shutdown(m_event_fd, SHUT_WR);
+				event_open = false;
+				m_finished.store(true);
+			}
+		}
+
+		struct pollfd  fds[3] = {
+			{ m_stop_fd, POLLIN, 0 },
+			{ main_open ? m_main_fd : -1, POLLIN, 0 },
+			{ event_open ? m_event_fd : -1, static_cast<short>(POLLIN | (event_out_pos < event_out.size() ? POLLOUT : 0)), 0 },
+		};
+		if (poll(fds, 3, timeout) == -1) {
+			if (errno == EINTR)
+				continue;
+			I3IPC_ERR("Replayer: poll failed: " << strerror(errno))
+			break;
+		}
+		if (fds[0].revents)
+			break;
+
+		if (fds[1].revents) {
+			main_out.clear();
+			// The client waits for the reply, so a blocking write is fine
+			main_open = this->serve_request(m_main_fd, main_out) && send(m_main_fd, main_out.data(), main_out.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(main_out.size());
+		}
+
+		if (fds[2].revents & POLLIN) {
+			if (!this->serve_request(m_event_fd, event_out)) {
+				event_open = false;
+				continue;
+			}
+			if (!start && m_subscriptions) {
+				start = clock::now();
+			}
+		}
+		if (fds[2].revents & POLLOUT) {
+			// The client may not read events, while it waits for a reply on the main socket: never block here
+			const ssize_t  n = send(m_event_fd, event_out.data() + event_out_pos, event_out.size() - event_out_pos, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (n > 0) {
+				event_out_pos += n;
+				if (event_out_pos == event_out.size()) {
+					event_out.clear();
+					event_out_pos = 0;
+				}
+			} else if (n == -1 && errno != EAGAIN && errno != EINTR) {
+				event_open = false;
+			}
+		} else if (fds[2].revents & (POLLHUP | POLLERR)) {
+			event_open = false;
+		}
+	}
+}
+
+}
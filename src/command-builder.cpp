@@ -0,0 +1,289 @@
+#include <charconv>
+
+#include "command-builder.hpp"
+
+namespace i3ipc {
+
+static constexpr std::string_view  g_verbs[] = {
+	"exec",
+	"focus",
+	"move",
+	"resize",
+	"kill",
+	"mark",
+	"unmark",
+	"layout",
+	"split",
+	"floating",
+	"fullscreen",
+	"sticky",
+	"border",
+	"title_format",
+	"scratchpad",
+	"workspace",
+	"rename",
+	"mode",
+	"swap",
+	"nop",
+	"reload",
+	"restart",
+};
+static_assert(sizeof(g_verbs) / sizeof(g_verbs[0]) == static_cast<size_t>(CommandVerb::RESTART) + 1, "A verb without text");
+
+static constexpr std::string_view  g_options[] = {
+	"container",
+	"window",
+	"workspace",
+	"output",
+	"mark",
+	"to",
+	"left",
+	"right",
+	"up",
+	"down",
+	"parent",
+	"child",
+	"next",
+	"prev",
+	"current",
+	"back_and_forth",
+	"number",
+	"position",
+	"center",
+	"mouse",
+	"absolute",
+	"grow",
+	"shrink",
+	"set",
+	"width",
+	"height",
+	"px",
+	"ppt",
+	"or",
+	"enable",
+	"disable",
+	"toggle",
+	"global",
+	"default",
+	"tabbed",
+	"stacking",
+	"splith",
+	"splitv",
+	"horizontal",
+	"vertical",
+	"tiling",
+	"mode_toggle",
+	"show",
+	"normal",
+	"pixel",
+	"none",
+	"--add",
+	"--replace",
+	"--toggle",
+	"--no-auto-back-and-forth",
+	"--no-startup-id",
+};
+static_assert(sizeof(g_options) / sizeof(g_options[0]) == static_cast<size_t>(CommandOption::NO_STARTUP_ID) + 1, "An option without text");
+
+
+std::string_view  to_string(const CommandVerb  verb) {
+	return g_verbs[static_cast<size_t>(verb)];
+}
+
+std::string_view  to_string(const CommandOption  option) {
+	return g_options[static_cast<size_t>(option)];
+}
+
+
+command_builder::command_builder() : m_buf(0), m_state(State::EMPTY), m_chained(false) {
+	m_buf.header->type = static_cast<uint32_t>(ClientMessageType::COMMAND);
+}
+
+
+void  command_builder::clear() {
+	m_buf.data.resize(sizeof(header_t));
+	m_state = State::EMPTY;
+	m_chained = false;
+	m_results.clear();
+}
+
+
+void  command_builder::append(const std::string_view  s) {
+	m_buf.data.insert(m_buf.data.end(), s.begin(), s.end());
+}
+
+
+void  command_builder::append_quoted(const std::string_view  s) {
+	m_buf.data.push_back('"');
+	for (char  c : s) {
+		if (c == '"' || c == '\\')
+			m_buf.data.push_back('\\');
+		m_buf.data.push_back(c);
+	}
+	m_buf.data.push_back('"');
+}
+
+
+/**
+ * Start a command, if nothing of it is added yet
+ */
+void  command_builder::begin() {
+	if (m_state != State::EMPTY)
+		return;
+	if (m_chained && !m_results.empty()) {
+		m_results.back()++;
+	} else {
+		m_results.push_back(1);
+	}
+	m_chained = false;
+}
+
+
+void  command_builder::criterion(const std::string_view  name) {
+	if (m_state == State::BODY) {
+		this->next();
+	}
+	if (m_state == State::EMPTY) {
+		this->begin();
+		m_buf.data.push_back('[');
+		m_state = State::CRITERIA;
+	} else {
+		m_buf.data.push_back(' ');
+	}
+	this->append(name);
+}
+
+
+command_builder&  command_builder::con_id(const uint64_t  id) {
+	this->criterion("con_id=");
+	char  s[24];
+	auto  r = std::to_chars(std::begin(s), std::end(s), id);
+	this->append(std::string_view(s, r.ptr - s));
+	return *this;
+}
+
+command_builder&  command_builder::window_id(const uint64_t  id) {
+	this->criterion("id=");
+	char  s[24];
+	auto  r = std::to_chars(std::begin(s), std::end(s), id);
+	this->append(std::string_view(s, r.ptr - s));
+	return *this;
+}
+
+command_builder&  command_builder::window_class(const std::string_view  regex) {
+	this->criterion("class=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::instance(const std::string_view  regex) {
+	this->criterion("instance=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::window_role(const std::string_view  regex) {
+	this->criterion("window_role=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::title(const std::string_view  regex) {
+	this->criterion("title=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::con_mark(const std::string_view  regex) {
+	this->criterion("con_mark=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::workspace(const std::string_view  regex) {
+	this->criterion("workspace=");
+	this->append_quoted(regex);
+	return *this;
+}
+
+command_builder&  command_builder::floating() {
+	this->criterion("floating");
+	return *this;
+}
+
+command_builder&  command_builder::tiling() {
+	this->criterion("tiling");
+	return *this;
+}
+
+
+command_builder&  command_builder::verb(const CommandVerb  verb) {
+	if (m_state == State::CRITERIA) {
+		this->append("] ");
+	} else if (m_state == State::BODY) {
+		m_buf.data.push_back(' ');
+	} else {
+		this->begin();
+	}
+	m_state = State::BODY;
+	this->append(to_string(verb));
+	return *this;
+}
+
+
+command_builder&  command_builder::option(const CommandOption  option) {
+	m_buf.data.push_back(' ');
+	this->append(to_string(option));
+	return *this;
+}
+
+
+command_builder&  command_builder::arg(const std::string_view  value) {
+	m_buf.data.push_back(' ');
+	this->append_quoted(value);
+	return *this;
+}
+
+
+command_builder&  command_builder::arg(const int64_t  value) {
+	char  s[24];
+	auto  r = std::to_chars(std::begin(s), std::end(s), value);
+	m_buf.data.push_back(' ');
+	this->append(std::string_view(s, r.ptr - s));
+	return *this;
+}
+
+
+command_builder&  command_builder::next() {
+	if (m_state != State::EMPTY) {
+		m_buf.data.push_back(';');
+		m_state = State::EMPTY;
+	}
+	m_chained = false;
+	return *this;
+}
+
+
+command_builder&  command_builder::chain() {
+	if (m_state != State::EMPTY) {
+		m_buf.data.push_back(',');
+		m_state = State::EMPTY;
+		m_chained = true;
+	}
+	return *this;
+}
+
+
+std::string_view  command_builder::str() const {
+	return std::string_view(reinterpret_cast<const char*>(m_buf.data.data()) + sizeof(header_t), m_buf.data.size() - sizeof(header_t));
+}
+
+
+const buf_t&  command_builder::message() {
+	m_buf.header = reinterpret_cast<header_t*>(m_buf.data.data());
+	m_buf.payload = reinterpret_cast<char*>(m_buf.data.data() + sizeof(header_t));
+	m_buf.header->size = m_buf.data.size() - sizeof(header_t);
+	return m_buf;
+}
+
+}
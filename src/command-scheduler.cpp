@@ -0,0 +1,194 @@
+#include <cctype>
+#include <set>
+#include <vector>
+
+#include "command-scheduler.hpp"
+
+namespace i3ipc {
+
+/**
+ * Keywords of i3 commands, that select a subcommand. Units ("px", "ppt") are not keywords
+ */
+static const std::set<std::string>  g_command_keywords = {
+	"absolute", "all", "back_and_forth", "bottom", "center", "child", "client", "container", "current",
+	"cursor", "default", "disable", "dock", "down", "enable", "floating", "global", "grow", "h", "height",
+	"hide", "horizontal", "id", "inner", "invisible", "left", "mark", "minus", "mode_toggle", "mouse",
+	"next", "next_on_output", "none", "normal", "number", "outer", "output", "parent", "pixel", "plus",
+	"pointer", "position", "prev", "prev_on_output", "right", "scratchpad", "set", "show", "shrink",
+	"sibling", "split", "splith", "splitv", "stacked", "stacking", "t", "tabbed", "tiling", "to", "toggle",
+	"top", "up", "v", "vertical", "width", "window", "with", "workspace",
+};
+
+
+bool  get_command_key(const std::string&  command, std::pair<std::string, std::string>&  key) {
+	size_t  i = 0;
+	const size_t  n = command.size();
+	auto  skip_spaces = [&]() {
+		while (i < n && isspace(static_cast<unsigned char>(command[i])))
+			i++;
+	};
+	// Skip a quoted string, that starts at i
+	auto  skip_quoted = [&]() {
+		for (i++; i < n && command[i] != '"'; i++) {
+			if (command[i] == '\\')
+				i++;
+		}
+	};
+
+	skip_spaces();
+	key.first.clear();
+	if (i < n && command[i] == '[') {
+		const size_t  start = ++i;
+		while (i < n && command[i] != ']') {
+			if (command[i] == '"')
+				skip_quoted();
+			i++;
+		}
+		key.first.assign(command, start, std::min(i, n) - start);
+		i++;
+		skip_spaces();
+	}
+
+	// The verb and the keywords after it, up to the first argument. The rest is scanned for a list only
+	key.second.clear();
+	bool  in_key = true;
+	std::string  word;
+	while (i < n) {
+		if (command[i] == ',' || command[i] == ';') {
+			return false;
+		}
+		if (isspace(static_cast<unsigned char>(command[i]))) {
+			i++;
+			continue;
+		}
+		if (command[i] == '"') {
+			skip_quoted();
+			i++;
+			in_key = false;
+			continue;
+		}
+		const size_t  start = i;
+		while (i < n && !isspace(static_cast<unsigned char>(command[i])) && command[i] != ',' && command[i] != ';' && command[i] != '"')
+			i++;
+		if (!in_key)
+			continue;
+		word.assign(command, start, i - start);
+		if (word.compare(0, 2, "--") == 0)
+			continue; // An option (e.g. "--no-auto-back-and-forth")
+		if (!key.second.empty() && !g_command_keywords.count(word)) {
+			in_key = false;
+			continue;
+		}
+		if (!key.second.empty())
+			key.second.push_back(' ');
+		key.second.append(word);
+	}
+	return !key.second.empty();
+}
+
+
+command_scheduler::command_scheduler(connection&  conn, const clock::duration  window, const double  max_rate) :
+	m_conn(conn),
+	m_window(window),
+	m_min_interval(0),
+	m_superseding(),
+	m_first(),
+	m_stats()
+{
+	this->set_max_rate(max_rate);
+}
+
+
+void  command_scheduler::set_max_rate(const double  max_rate) {
+	if (max_rate > 0) {
+		m_min_interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1 / max_rate));
+	} else {
+		m_min_interval = clock::duration::zero();
+	}
+}
+
+
+void  command_scheduler::set_superseding(const std::string&  subcommand, const bool  enabled) {
+	if (enabled) {
+		m_superseding.insert(subcommand);
+	} else {
+		m_superseding.erase(subcommand);
+	}
+}
+
+
+void  command_scheduler::schedule(const std::string&  command, const clock::time_point  now) {
+	m_stats.scheduled++;
+	if (m_queue.empty()) {
+		m_first = now;
+	}
+
+	scheduled_t  item = { command, std::nullopt };
+	key_t  key;
+	// Commands without criteria act on the focused window, which depends on the previous commands
+	if (!m_superseding.empty() && get_command_key(command, key) && !key.first.empty() && m_superseding.count(key.second)) {
+		auto  it = m_index.find(key);
+		if (it != m_index.end()) {
+			m_queue.erase(it->second);
+			m_index.erase(it);
+			m_stats.superseded++;
+		}
+		item.key = std::move(key);
+	}
+	m_queue.push_back(std::move(item));
+	if (m_queue.back().key) {
+		m_index.emplace(*m_queue.back().key, std::prev(m_queue.end()));
+	}
+
+	this->run(now);
+}
+
+
+bool  command_scheduler::run(const clock::time_point  now) {
+	auto  deadline = this->next_deadline();
+	if (!deadline || *deadline > now)
+		return false;
+	this->send(now);
+	return true;
+}
+
+
+void  command_scheduler::flush() {
+	if (!m_queue.empty())
+		this->send(clock::now());
+}
+
+
+std::optional<command_scheduler::clock::time_point>  command_scheduler::next_deadline() const {
+	if (m_queue.empty())
+		return std::nullopt;
+	clock::time_point  deadline = m_first + m_window;
+	if (m_last_sent && *m_last_sent + m_min_interval > deadline) {
+		deadline = *m_last_sent + m_min_interval;
+	}
+	return deadline;
+}
+
+
+void  command_scheduler::send(const clock::time_point  now) {
+	std::vector<std::string>  commands;
+	commands.reserve(m_queue.size());
+	for (auto&  item : m_queue) {
+		commands.push_back(std::move(item.command));
+	}
+	m_queue.clear();
+	m_index.clear();
+	m_last_sent = now;
+
+	auto  results = m_conn.send_commands(commands);
+	m_stats.sent += commands.size();
+	m_stats.batches++;
+	for (size_t  i = 0; i < results.size(); i++) {
+		if (!results[i].success) {
+			m_stats.failed++;
+			signal_command_error.emit(commands[i], results[i]);
+		}
+	}
+}
+
+}
@@ -0,0 +1,262 @@
+extern "C" {
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+}
+
+#include <algorithm>
+
+#include "log.hpp"
+#include "ipc-util.hpp"
+#include "event-bus.hpp"
+
+namespace i3ipc {
+
+static size_t  round_up_pow2(const size_t  n) {
+	size_t  r = 1;
+	while (r < n)
+		r <<= 1;
+	return r;
+}
+
+
+event_bus::consumer::consumer(event_bus&  bus, const int32_t  events) :
+	m_bus(bus),
+	m_events(events),
+	m_eventfd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	m_cursor(bus.published()),
+	m_waiting(false),
+	m_skipped(0),
+	m_taken(0)
+{
+	if (m_eventfd == -1) {
+		throw errno_error("Failed to create an eventfd");
+	}
+}
+
+event_bus::consumer::~consumer() {
+	m_bus.detach(this);
+	this->stop_waiting();
+	close(m_eventfd);
+}
+
+
+bool  event_bus::consumer::stop_waiting() {
+	if (m_waiting.load(std::memory_order_relaxed) && m_waiting.exchange(false)) {
+		m_bus.m_waiting_consumers.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+
+bool  event_bus::consumer::try_next(std::shared_ptr<const event_t>&  ev) {
+	while (true) {
+		const uint64_t  cursor = m_cursor.load(std::memory_order_relaxed);
+		const uint64_t  published = m_bus.m_published.load(std::memory_order_acquire);
+		if (cursor >= published) {
+			if (m_waiting.load(std::memory_order_relaxed)) {
+				return false;
+			}
+			// Arm the eventfd and check again, so a publish between the check and arming isn't missed
+			uint64_t  counter;
+			(void)!read(m_eventfd, &counter, sizeof(counter));
+			// Seq_cst with publish(): either the publisher sees the waiting consumer, or we see its event
+			m_waiting.store(true);
+			m_bus.m_waiting_consumers.fetch_add(1);
+			if (m_bus.m_published.load() > cursor) {
+				this->stop_waiting();
+				continue;
+			}
+			if (m_bus.m_failed.load(std::memory_order_acquire)) {
+				std::rethrow_exception(m_bus.m_error);
+			}
+			return false;
+		}
+		this->stop_waiting();
+
+		// Only events of the consumer's types are copied (their reference counts are touched)
+		const uint64_t  seq = cursor + 1;
+		slot_t&  slot = m_bus.m_slots[seq & m_bus.m_mask];
+		std::shared_ptr<const event_t>  candidate;
+		slot.lock();
+		const uint64_t  slot_seq = slot.seq;
+		if (slot_seq == seq && slot.ev && (slot.ev->type & m_events)) {
+			candidate = slot.ev;
+		}
+		slot.unlock();
+
+		if (slot_seq != seq) {
+			// Overwritten: jump right before the oldest event, that is still in the ring
+			const uint64_t  latest = m_bus.m_published.load(std::memory_order_acquire);
+			const uint64_t  new_cursor = std::max(latest > m_bus.m_mask ? latest - m_bus.m_mask - 1 : 0, seq);
+			m_skipped += new_cursor - cursor;
+			m_cursor.store(new_cursor, std::memory_order_relaxed);
+			continue;
+		}
+
+		m_cursor.store(seq, std::memory_order_relaxed);
+		if (candidate) {
+			ev = std::move(candidate);
+			m_taken++;
+			return true;
+		}
+	}
+}
+
+
+bool  event_bus::consumer::next(std::shared_ptr<const event_t>&  ev, const std::chrono::milliseconds  timeout) {
+	const auto  deadline = std::chrono::steady_clock::now() + timeout;
+	while (true) {
+		if (this->try_next(ev))
+			return true;
+		if (m_bus.m_stop.load())
+			return false;
+
+		int  wait = -1;
+		if (timeout.count() >= 0) {
+			auto  left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (left <= 0)
+				return false;
+			wait = static_cast<int>(left);
+		}
+		struct pollfd  pfd = { m_eventfd, POLLIN, 0 };
+		if (poll(&pfd, 1, wait) == -1 && errno != EINTR) {
+			throw errno_error("Failed to poll an eventfd of event_bus consumer");
+		}
+	}
+}
+
+
+void  event_bus::consumer::skip_to_latest() {
+	const uint64_t  published = m_bus.published();
+	const uint64_t  cursor = m_cursor.load(std::memory_order_relaxed);
+	if (published > cursor) {
+		m_skipped += published - cursor;
+		m_cursor.store(published, std::memory_order_relaxed);
+	}
+}
+
+
+uint64_t  event_bus::consumer::lag() const {
+	return m_bus.published() - m_cursor.load(std::memory_order_relaxed);
+}
+
+
+event_bus::event_bus(const std::string&  socket_path, const int32_t  events, const size_t  capacity, const int32_t  predecode) :
+	m_conn(new connection(socket_path)),
+	m_predecode(predecode),
+	m_slots(round_up_pow2(std::max<size_t>(capacity, 2))),
+	m_mask(m_slots.size() - 1),
+	m_published(0),
+	m_waiting_consumers(0),
+	m_stop(false),
+	m_failed(false)
+{
+	m_conn->signal_event.connect([this](EventType  type, const std::shared_ptr<const buf_t>&  buf) {
+		auto  ev = std::make_shared<event_t>();
+		ev->type = type;
+		ev->buf = buf;
+		if (m_predecode & type) {
+			try {
+				decode_event(*ev);
+			} catch (const ipc_error&  e) {
+				I3IPC_WARN("event_bus: failed to decode an event: " << e.what())
+			}
+		}
+		this->publish(std::move(ev));
+	});
+	m_conn->subscribe(events);
+	m_conn->connect_event_socket();
+
+	m_thread = std::thread(&event_bus::run, this);
+}
+
+event_bus::~event_bus() {
+	this->stop();
+}
+
+
+void  event_bus::stop() {
+	if (m_stop.exchange(true))
+		return;
+	shutdown(m_conn->get_event_socket_fd(), SHUT_RDWR); // Unblock the reader
+	if (m_thread.joinable())
+		m_thread.join();
+	this->wake_consumers(true);
+}
+
+
+void  event_bus::run() {
+	try {
+		while (!m_stop.load(std::memory_order_relaxed)) {
+			m_conn->handle_event();
+		}
+	} catch (...) {
+		if (!m_stop.load()) {
+			m_error = std::current_exception();
+			m_failed.store(true, std::memory_order_release);
+			this->wake_consumers(true);
+		}
+	}
+}
+
+
+void  event_bus::publish(std::shared_ptr<const event_t>  ev) {
+	const uint64_t  seq = m_published.load(std::memory_order_relaxed) + 1;
+	slot_t&  slot = m_slots[seq & m_mask];
+
+	// The overwritten event is released out of the lock
+	std::shared_ptr<const event_t>  old;
+	slot.lock();
+	old = std::move(slot.ev);
+	slot.ev = std::move(ev);
+	slot.seq = seq;
+	slot.unlock();
+	m_published.store(seq, std::memory_order_seq_cst);
+
+	// Without waiting consumers the list of consumers isn't locked
+	if (m_waiting_consumers.load() > 0) {
+		this->wake_consumers(false);
+	}
+}
+
+
+void  event_bus::wake_consumers(const bool  all) {
+	const uint64_t  one = 1;
+	std::lock_guard<std::mutex>  lock(m_consumers_mutex);
+	for (consumer*  c : m_consumers) {
+		if (c->stop_waiting() || all) {
+			(void)!write(c->m_eventfd, &one, sizeof(one));
+		}
+	}
+}
+
+
+std::shared_ptr<event_bus::consumer>  event_bus::subscribe(const int32_t  events) {
+	std::shared_ptr<consumer>  c(new consumer(*this, events));
+	std::lock_guard<std::mutex>  lock(m_consumers_mutex);
+	m_consumers.push_back(c.get());
+	return c;
+}
+
+
+void  event_bus::detach(consumer*  c) {
+	std::lock_guard<std::mutex>  lock(m_consumers_mutex);
+	m_consumers.remove(c);
+}
+
+
+size_t  event_bus::count_slow_consumers(uint64_t  threshold) const {
+	if (threshold == 0) {
+		threshold = (m_mask + 1) / 2;
+	}
+	std::lock_guard<std::mutex>  lock(m_consumers_mutex);
+	return std::count_if(m_consumers.begin(), m_consumers.end(), [threshold](const consumer*  c) {
+		return c->lag() > threshold;
+	});
+}
+
+}
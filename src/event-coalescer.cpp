@@ -0,0 +1,119 @@
+#include <tuple>
+
+#include "event-coalescer.hpp"
+
+namespace i3ipc {
+
+bool  event_coalescer::key_t::operator<(const key_t&  other) const {
+	return std::tie(type, id, change) < std::tie(other.type, other.id, other.change);
+}
+
+
+uint64_t  scan_event_object_id(const EventType  type, const buf_t&  buf) {
+	const char*  object = nullptr;
+	if (type == ET_WINDOW) {
+		object = "container";
+	} else if (type == ET_WORKSPACE) {
+		object = "current";
+	} else {
+		return 0;
+	}
+
+	uint64_t  id = 0;
+	size_t  pos = i3_payload_find_member(buf, object, "id");
+	if (!i3_payload_read_uint(buf, pos, id)) {
+		return 0;
+	}
+	return id;
+}
+
+
+event_coalescer::event_coalescer() : m_stats() {}
+
+
+void  event_coalescer::set_interval(const EventType  type, const std::string&  change, const clock::duration  interval) {
+	if (interval <= clock::duration::zero()) {
+		m_intervals.erase({type, change});
+	} else {
+		m_intervals[{type, change}] = interval;
+	}
+}
+
+
+void  event_coalescer::push(const event_t&  ev, const clock::time_point  now, std::vector<event_t>&  out) {
+	std::string_view  change;
+	const size_t  change_pos = i3_payload_find_key(*ev.buf, "change");
+	if (change_pos != std::string_view::npos) {
+		i3_payload_read_string(*ev.buf, change_pos, change);
+	}
+
+	key_t  key = { ev.type, std::string(change), scan_event_object_id(ev.type, *ev.buf) };
+	auto  interval = m_intervals.find({key.type, key.change});
+
+	if (interval == m_intervals.end()) {
+		// Pass through, but keep the order of events of the same container
+		if (key.id != 0) {
+			for (auto  it = m_held.begin(); it != m_held.end();) {
+				if (it->key.type == key.type && it->key.id == key.id) {
+					out.push_back(std::move(it->ev));
+					m_index.erase(it->key);
+					it = m_held.erase(it);
+					m_stats.delivered++;
+				} else {
+					++it;
+				}
+			}
+		}
+		out.push_back(ev);
+		m_stats.passed++;
+		return;
+	}
+
+	auto  held = m_index.find(key);
+	if (held != m_index.end()) {
+		held->second->ev = ev;
+		m_stats.merged++;
+		return;
+	}
+
+	m_held.push_back({ key, ev, now + interval->second });
+	m_index.emplace(std::move(key), std::prev(m_held.end()));
+	m_stats.held++;
+}
+
+
+void  event_coalescer::pop_due(const clock::time_point  now, std::vector<event_t>&  out) {
+	for (auto  it = m_held.begin(); it != m_held.end();) {
+		if (it->deadline <= now) {
+			out.push_back(std::move(it->ev));
+			m_index.erase(it->key);
+			it = m_held.erase(it);
+			m_stats.delivered++;
+		} else {
+			++it;
+		}
+	}
+}
+
+
+void  event_coalescer::flush(std::vector<event_t>&  out) {
+	for (auto&  h : m_held) {
+		out.push_back(std::move(h.ev));
+		m_stats.delivered++;
+	}
+	m_held.clear();
+	m_index.clear();
+}
+
+
+std::optional<event_coalescer::clock::time_point>  event_coalescer::next_deadline() const {
+	std::optional<clock::time_point>  deadline;
+	for (auto&  h : m_held) {
+		if (!deadline || h.deadline < *deadline) {
+			deadline = h.deadline;
+		}
+	}
+	return deadline;
+}
+
+}
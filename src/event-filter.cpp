@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include "event-filter.hpp"
+
+namespace i3ipc {
+
+event_filter_set::event_filter_set() : m_events(0), m_next_id(1), m_discarded(0) {}
+
+
+uint32_t  event_filter_set::add(const event_filter_t&  filter) {
+	const uint32_t  id = m_next_id++;
+	m_filters.emplace(id, filter);
+	m_events |= filter.events;
+	return id;
+}
+
+
+void  event_filter_set::remove(const uint32_t  id) {
+	m_filters.erase(id);
+	m_events = 0;
+	for (auto&  f : m_filters) {
+		m_events |= f.second.events;
+	}
+}
+
+
+void  event_filter_set::clear() {
+	m_filters.clear();
+	m_events = 0;
+}
+
+
+bool  event_filter_set::accepts(const EventType  type, const buf_t&  buf) const {
+	if (!(m_events & type))
+		return true;
+
+	// Scan lazily: each field only once and only if some filter needs it
+	bool  change_scanned = false, id_scanned = false, workspace_scanned = false;
+	std::string_view  change, workspace;
+	uint64_t  id = 0;
+	const char*  object = (type == ET_WINDOW ? "container" : "current");
+
+	for (auto&  it : m_filters) {
+		const event_filter_t&  f = it.second;
+		if (!(f.events & type))
+			continue;
+
+		if (!f.changes.empty()) {
+			if (!change_scanned) {
+				i3_payload_read_string(buf, i3_payload_find_key(buf, "change"), change);
+				change_scanned = true;
+			}
+			if (std::find(f.changes.begin(), f.changes.end(), change) == f.changes.end())
+				continue;
+		}
+		if (f.id != 0) {
+			if (type != ET_WINDOW && type != ET_WORKSPACE)
+				continue;
+			if (!id_scanned) {
+				i3_payload_read_uint(buf, i3_payload_find_member(buf, object, "id"), id);
+				id_scanned = true;
+			}
+			if (id != f.id)
+				continue;
+		}
+		if (!f.workspace.empty()) {
+			if (type != ET_WORKSPACE)
+				continue;
+			if (!workspace_scanned) {
+				i3_payload_read_string(buf, i3_payload_find_member(buf, "current", "name"), workspace);
+				workspace_scanned = true;
+			}
+			if (workspace != f.workspace)
+				continue;
+		}
+		return true;
+	}
+	return false;
+}
+
+
+bool  event_filter_set::check(const EventType  type, const buf_t&  buf) {
+	if (this->accepts(type, buf))
+		return true;
+	m_discarded++;
+	return false;
+}
+
+}
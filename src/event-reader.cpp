@@ -0,0 +1,265 @@
+extern "C" {
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+}
+
+#include <algorithm>
+
+#include "ipc-util.hpp"
+#include "event-coalescer.hpp"
+#include "event-reader.hpp"
+
+namespace i3ipc {
+
+event_reader::event_reader(const int32_t  sockfd, const size_t  capacity, const int32_t  predecode, const OverflowPolicy  overflow) :
+	m_sockfd(sockfd),
+	m_predecode(predecode),
+	m_overflow(overflow),
+	m_eventfd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	m_room_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+	m_ring(capacity),
+	m_stop(false),
+	m_waiting(true),
+	m_producer_waiting(false),
+	m_failed(false),
+	m_enqueued(0),
+	m_max_depth(0),
+	m_backlog_depth(0),
+	m_overflows(0),
+	m_dropped(0),
+	m_coalesced(0),
+	m_dequeued(0),
+	m_last_queue_time(clock::duration::zero()),
+	m_max_queue_time(clock::duration::zero()),
+	m_total_queue_time(clock::duration::zero())
+{
+	if (m_eventfd == -1 || m_room_fd == -1) {
+		const errno_error  error("Failed to create an eventfd");
+		close(m_eventfd);
+		close(m_room_fd);
+		throw error;
+	}
+	m_thread = std::thread(&event_reader::run, this);
+}
+
+event_reader::~event_reader() {
+	m_stop.store(true);
+	shutdown(m_sockfd, SHUT_RDWR); // Unblock i3_recv() of the thread
+	const uint64_t  one = 1;
+	(void)!write(m_room_fd, &one, sizeof(one)); // Unblock waiting for a room in the queue
+	m_thread.join();
+	close(m_eventfd);
+	close(m_room_fd);
+}
+
+
+void  event_reader::run() {
+	try {
+		while (!m_stop.load(std::memory_order_relaxed)) {
+			if (!m_backlog.empty() && !this->flush_backlog()) {
+				// Keep draining the socket, but flush the backlog as soon as the consumer takes an event
+				if (!this->wait_for_room(true))
+					continue;
+			}
+
+			std::shared_ptr<buf_t>  buf = i3_recv(m_sockfd);
+			item_t  item = { { static_cast<EventType>(1 << (buf->header->type & 0x7f)), buf }, clock::now() };
+			item.ev.received = item.enqueued;
+			if (m_predecode & item.ev.type) {
+				try {
+					decode_event(item.ev);
+				} catch (const ipc_error&) {
+					// Let the consumer decode (and fail) it, as if it was not predecoded
+				}
+				item.ev.decode_time = clock::now() - item.enqueued;
+			}
+			this->enqueue(std::move(item));
+		}
+	} catch (...) {
+		if (!m_stop.load()) {
+			m_error = std::current_exception();
+			m_failed.store(true, std::memory_order_release);
+			this->wake();
+		}
+	}
+}
+
+
+void  event_reader::enqueue(item_t&&  item) {
+	if (m_backlog.empty() && m_ring.push(std::move(item))) {
+		const size_t  depth = m_ring.size();
+		size_t  max_depth = m_max_depth.load(std::memory_order_relaxed);
+		while (depth > max_depth && !m_max_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {}
+		m_enqueued.fetch_add(1, std::memory_order_relaxed);
+		this->notify();
+		return;
+	}
+
+	m_overflows.fetch_add(1, std::memory_order_relaxed);
+	if (m_overflow != OverflowPolicy::BLOCK) {
+		this->hold(std::move(item));
+		return;
+	}
+	while (!m_ring.push(std::move(item))) {
+		if (m_stop.load(std::memory_order_relaxed))
+			return;
+		this->wait_for_room(false);
+	}
+	m_max_depth.store(m_ring.capacity(), std::memory_order_relaxed);
+	m_enqueued.fetch_add(1, std::memory_order_relaxed);
+	this->notify();
+}
+
+
+void  event_reader::hold(item_t&&  item) {
+	held_t  held = { std::move(item), 0, std::string() };
+	if (m_overflow == OverflowPolicy::COALESCE) {
+		const buf_t&  buf = *held.item.ev.buf;
+		held.id = scan_event_object_id(held.item.ev.type, buf);
+		std::string_view  change;
+		i3_payload_read_string(buf, i3_payload_find_key(buf, "change"), change);
+		held.change = std::string(change);
+
+		if (held.id != 0) {
+			// The newer state goes after the events, that came between, so the order of changes is kept
+			auto  it = std::find_if(m_backlog.begin(), m_backlog.end(), [&held](const held_t&  it) {
+				return it.id == held.id && it.item.ev.type == held.item.ev.type && it.change == held.change;
+			});
+			if (it != m_backlog.end()) {
+				m_backlog.erase(it);
+				m_coalesced.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	if (m_backlog.size() >= m_ring.capacity()) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		if (m_overflow == OverflowPolicy::DROP_NEWEST)
+			return;
+		m_backlog.pop_front();
+	}
+	m_backlog.push_back(std::move(held));
+	m_backlog_depth.store(m_backlog.size(), std::memory_order_relaxed);
+}
+
+
+bool  event_reader::flush_backlog() {
+	size_t  n = 0;
+	while (!m_backlog.empty() && m_ring.push(std::move(m_backlog.front().item))) {
+		m_backlog.pop_front();
+		n++;
+	}
+	if (n > 0) {
+		m_max_depth.store(m_ring.capacity(), std::memory_order_relaxed);
+		m_enqueued.fetch_add(n, std::memory_order_relaxed);
+		m_backlog_depth.store(m_backlog.size(), std::memory_order_relaxed);
+		this->notify();
+	}
+	return m_backlog.empty();
+}
+
+
+/**
+ * Wait until the consumer takes an event from the full queue (or the reader is stopped)
+ * @param  socket also wait until the socket is readable
+ * @return true if the socket is readable
+ */
+bool  event_reader::wait_for_room(const bool  socket) {
+	uint64_t  counter;
+	(void)!read(m_room_fd, &counter, sizeof(counter));
+
+	m_producer_waiting.store(true);
+	std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in pop()
+	if (m_ring.size() < m_ring.capacity() || m_stop.load()) {
+		m_producer_waiting.store(false);
+		return false;
+	}
+
+	struct pollfd  fds[2] = {
+		{ m_room_fd, POLLIN, 0 },
+		{ socket ? m_sockfd : -1, POLLIN, 0 },
+	};
+	const int  ret = poll(fds, 2, -1);
+	m_producer_waiting.store(false);
+	if (ret == -1) {
+		if (errno == EINTR)
+			return false;
+		throw errno_error("Failed to poll the event socket");
+	}
+	return fds[1].revents != 0;
+}
+
+
+void  event_reader::notify() {
+	if (m_waiting.exchange(false)) {
+		this->wake();
+	}
+}
+
+
+void  event_reader::wake() {
+	const uint64_t  one = 1;
+	(void)!write(m_eventfd, &one, sizeof(one));
+}
+
+
+bool  event_reader::pop(event_t&  ev) {
+	item_t  item;
+	if (!m_ring.pop(item)) {
+		if (m_failed.load(std::memory_order_acquire)) {
+			std::rethrow_exception(m_error);
+		}
+		return false;
+	}
+
+	std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in wait_for_room()
+	if (m_producer_waiting.load(std::memory_order_relaxed) && m_producer_waiting.exchange(false)) {
+		const uint64_t  one = 1;
+		(void)!write(m_room_fd, &one, sizeof(one));
+	}
+
+	ev = std::move(item.ev);
+	m_last_queue_time = clock::now() - item.enqueued;
+	m_max_queue_time = std::max(m_max_queue_time, m_last_queue_time);
+	m_total_queue_time += m_last_queue_time;
+	m_dequeued++;
+	return true;
+}
+
+
+bool  event_reader::prepare_to_wait() {
+	uint64_t  counter;
+	(void)!read(m_eventfd, &counter, sizeof(counter));
+
+	m_waiting.store(true);
+	if (!m_ring.empty() || m_failed.load()) {
+		// Don't sleep. If the thread has already taken the flag, the eventfd just stays readable
+		m_waiting.store(false);
+		return false;
+	}
+	return true;
+}
+
+
+event_reader_stats_t  event_reader::stats() const {
+	return {
+		.policy = m_overflow,
+		.capacity = m_ring.capacity(),
+		.depth = m_ring.size(),
+		.max_depth = m_max_depth.load(std::memory_order_relaxed),
+		.backlog = m_backlog_depth.load(std::memory_order_relaxed),
+		.enqueued = m_enqueued.load(std::memory_order_relaxed),
+		.dequeued = m_dequeued,
+		.overflows = m_overflows.load(std::memory_order_relaxed),
+		.dropped = m_dropped.load(std::memory_order_relaxed),
+		.coalesced = m_coalesced.load(std::memory_order_relaxed),
+		.last_queue_time = std::chrono::duration_cast<std::chrono::nanoseconds>(m_last_queue_time),
+		.max_queue_time = std::chrono::duration_cast<std::chrono::nanoseconds>(m_max_queue_time),
+		.total_queue_time = std::chrono::duration_cast<std::chrono::nanoseconds>(m_total_queue_time),
+	};
+}
+
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+
+#include "ipc-util.hpp"
+#include "focus-tracker.hpp"
+
+namespace i3ipc {
+
+focus_tracker::focus_tracker(connection&  conn) {
+	if (!conn.subscribe(ET_WINDOW | ET_WORKSPACE)) {
+		throw ipc_error("Failed to subscribe to window and workspace events");
+	}
+	m_window_connection = conn.signal_window_event.connect([this](const window_event_t&  ev) {
+		this->on_window_event(ev);
+	});
+	m_workspace_connection = conn.signal_workspace_event.connect([this](const workspace_event_t&  ev) {
+		this->on_workspace_event(ev);
+	});
+
+	auto  root = conn.get_tree();
+	if (root) {
+		this->seed(*root, nullptr);
+	}
+	if (!m_workspaces.empty()) {
+		m_focused_workspace = m_workspaces.items().front();
+	}
+}
+
+focus_tracker::~focus_tracker() {
+	m_window_connection.disconnect();
+	m_workspace_connection.disconnect();
+}
+
+
+/**
+ * Walk the tree in focus order, so the items are appended from the most to the least recently focused
+ */
+void  focus_tracker::seed(const container_t&  node, const std::string*  workspace) {
+	if (node.type == "output" && node.name.compare(0, 2, "__") == 0) {
+		return; // i3's internal output with the scratchpad
+	}
+	if (node.type == "workspace") {
+		workspace = &node.name;
+		m_workspace_names[node.id] = node.name;
+		m_workspaces.append(node.name);
+		m_workspace_windows[node.name];
+	}
+
+	if (node.nodes.empty() && node.floating_nodes.empty()) {
+		if (node.xwindow_id != 0 && workspace) {
+			m_windows.append(node.id);
+			m_workspace_windows[*workspace].append(node.id);
+			m_window_workspace[node.id] = *workspace;
+		}
+		return;
+	}
+
+	auto  find_child = [&node](const uint64_t  id) -> const container_t* {
+		for (auto&  lst : { &node.nodes, &node.floating_nodes }) {
+			for (auto&  n : *lst) {
+				if (n && n->id == id)
+					return n.get();
+			}
+		}
+		return nullptr;
+	};
+	for (uint64_t  id : node.focus) {
+		if (const container_t*  child = find_child(id)) {
+			this->seed(*child, workspace);
+		}
+	}
+	// Children, that have never been focused, are not always in "focus"
+	for (auto&  lst : { &node.nodes, &node.floating_nodes }) {
+		for (auto&  n : *lst) {
+			if (n && std::find(node.focus.begin(), node.focus.end(), n->id) == node.focus.end()) {
+				this->seed(*n, workspace);
+			}
+		}
+	}
+}
+
+
+void  focus_tracker::on_window_event(const window_event_t&  ev) {
+	if (!ev.container)
+		return;
+	const uint64_t  id = ev.container->id;
+
+	switch (ev.type) {
+	case WindowEventType::FOCUS:
+		m_windows.touch(id);
+		if (!m_focused_workspace.empty()) {
+			this->attribute_window(id, m_focused_workspace);
+			m_workspace_windows[m_focused_workspace].touch(id);
+		}
+		break;
+	case WindowEventType::NEW:
+		m_windows.append(id);
+		if (!m_focused_workspace.empty()) {
+			this->attribute_window(id, m_focused_workspace);
+		}
+		break;
+	case WindowEventType::MOVE:
+		// The event doesn't tell the destination: the workspace is unknown until the window is focused
+		this->detach_window(id);
+		break;
+	case WindowEventType::CLOSE:
+		this->forget_window(id);
+		break;
+	default:
+		break;
+	}
+}
+
+
+void  focus_tracker::on_workspace_event(const workspace_event_t&  ev) {
+	if (!ev.current)
+		return;
+	// Names of workspaces are looked up by their IDs, as a rename event has only the new name
+	std::string  old_name;
+	if (ev.current->id != 0) {
+		auto&  name = m_workspace_names[ev.current->id];
+		old_name = name;
+		name = ev.current->name;
+	}
+
+	switch (ev.type) {
+	case WorkspaceEventType::FOCUS:
+		m_focused_workspace = ev.current->name;
+		m_workspaces.touch(m_focused_workspace);
+		break;
+	case WorkspaceEventType::INIT:
+		m_workspaces.append(ev.current->name);
+		break;
+	case WorkspaceEventType::RENAME:
+		if (!old_name.empty() && old_name != ev.current->name) {
+			this->rename_workspace(old_name, ev.current->name);
+		}
+		break;
+	case WorkspaceEventType::EMPTY: {
+		auto  ws = m_workspace_windows.find(ev.current->name);
+		if (ws != m_workspace_windows.end()) {
+			// Remaining windows were moved out, they will be attributed again on focus
+			for (uint64_t  id : ws->second.items()) {
+				m_window_workspace.erase(id);
+			}
+			m_workspace_windows.erase(ws);
+		}
+		m_workspaces.erase(ev.current->name);
+		m_workspace_names.erase(ev.current->id);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+
+/**
+ * Move a window to the list of a workspace (to its back, if it isn't there yet)
+ */
+void  focus_tracker::attribute_window(const uint64_t  id, const std::string&  workspace) {
+	auto  it = m_window_workspace.find(id);
+	if (it != m_window_workspace.end()) {
+		if (it->second == workspace)
+			return;
+		auto  ws = m_workspace_windows.find(it->second);
+		if (ws != m_workspace_windows.end())
+			ws->second.erase(id);
+	}
+	m_workspace_windows[workspace].append(id);
+	m_window_workspace[id] = workspace;
+}
+
+
+/**
+ * Remove a window from the list of its workspace
+ */
+void  focus_tracker::detach_window(const uint64_t  id) {
+	auto  it = m_window_workspace.find(id);
+	if (it != m_window_workspace.end()) {
+		auto  ws = m_workspace_windows.find(it->second);
+		if (ws != m_workspace_windows.end())
+			ws->second.erase(id);
+		m_window_workspace.erase(it);
+	}
+}
+
+
+void  focus_tracker::rename_workspace(const std::string&  old_name, const std::string&  new_name) {
+	m_workspaces.replace(old_name, new_name);
+	auto  ws = m_workspace_windows.find(old_name);
+	if (ws != m_workspace_windows.end()) {
+		for (uint64_t  id : ws->second.items()) {
+			m_window_workspace[id] = new_name;
+		}
+		auto  node = m_workspace_windows.extract(ws);
+		node.key() = new_name;
+		m_workspace_windows.insert(std::move(node));
+	}
+	if (m_focused_workspace == old_name) {
+		m_focused_workspace = new_name;
+	}
+}
+
+
+void  focus_tracker::forget_window(const uint64_t  id) {
+	m_windows.erase(id);
+	this->detach_window(id);
+}
+
+
+std::list<uint64_t>  focus_tracker::windows(const std::string&  workspace) const {
+	auto  ws = m_workspace_windows.find(workspace);
+	if (ws == m_workspace_windows.end())
+		return {};
+	return ws->second.items();
+}
+
+
+uint64_t  focus_tracker::focused_window() const {
+	return m_windows.empty() ? 0 : m_windows.items().front();
+}
+
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <limits>
+
+#include "histogram.hpp"
+
+namespace i3ipc {
+
+uint64_t  histogram_snapshot_t::percentile(const double  q) const {
+	if (count == 0)
+		return 0;
+	const double  clamped = std::min(std::max(q, 0.0), 1.0);
+	const uint64_t  rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped * count + 0.5));
+	uint64_t  seen = 0;
+	for (size_t  i = 0; i < buckets.size(); i++) {
+		seen += buckets[i];
+		if (seen >= rank)
+			return std::min(log_histogram::bucket_upper_bound(i), max);
+	}
+	return max;
+}
+
+
+log_histogram::log_histogram() {
+	this->reset();
+}
+
+
+size_t  log_histogram::bucket_of(const uint64_t  value) {
+	if (value < SUB_BUCKETS)
+		return value;
+	const size_t  msb = 63 - __builtin_clzll(value);
+	const size_t  shift = msb - 3;
+	return (msb - 2) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+
+uint64_t  log_histogram::bucket_upper_bound(const size_t  bucket) {
+	if (bucket < SUB_BUCKETS)
+		return bucket;
+	const size_t  msb = bucket / SUB_BUCKETS + 2;
+	const uint64_t  lower = (SUB_BUCKETS + bucket % SUB_BUCKETS) << (msb - 3);
+	return lower + ((uint64_t(1) << (msb - 3)) - 1);
+}
+
+
+void  log_histogram::record(const uint64_t  value) {
+	m_buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(value, std::memory_order_relaxed);
+
+	uint64_t  min = m_min.load(std::memory_order_relaxed);
+	while (value < min && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+	uint64_t  max = m_max.load(std::memory_order_relaxed);
+	while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+
+histogram_snapshot_t  log_histogram::snapshot() const {
+	histogram_snapshot_t  s;
+	s.count = 0;
+	s.buckets.resize(BUCKETS);
+	for (size_t  i = 0; i < BUCKETS; i++) {
+		s.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+		s.count += s.buckets[i];
+	}
+	s.sum = m_sum.load(std::memory_order_relaxed);
+	s.min = s.count ? m_min.load(std::memory_order_relaxed) : 0;
+	s.max = m_max.load(std::memory_order_relaxed);
+	return s;
+}
+
+
+void  log_histogram::reset() {
+	for (auto&  bucket : m_buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	m_sum.store(0, std::memory_order_relaxed);
+	m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+}
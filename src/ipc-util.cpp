@@ -9,12 +9,15 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <ios>
 
 #include <auss.hpp>
 
 #include "ipc-util.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 
 namespace i3ipc {
 
@@ -26,8 +29,21 @@ static std::string  format_errno(const std::string&  msg = std::string()) {
 	return a;
 }
 
-errno_error::errno_error() : ipc_error(format_errno()) {}
-errno_error::errno_error(const std::string&  msg) : ipc_error(format_errno(msg)) {}
+errno_error::errno_error() : ipc_error(format_errno()) {
+	get_metrics().on_error(ErrorClass::ERRNO_ERROR);
+}
+errno_error::errno_error(const std::string&  msg) : ipc_error(format_errno(msg)) {
+	get_metrics().on_error(ErrorClass::ERRNO_ERROR);
+}
+invalid_header_error::invalid_header_error(const std::string&  msg) : ipc_error(msg) {
+	get_metrics().on_error(ErrorClass::INVALID_HEADER_ERROR);
+}
+eof_error::eof_error(const std::string&  msg) : ipc_error(msg) {
+	get_metrics().on_error(ErrorClass::EOF_ERROR);
+}
+invalid_reply_payload_error::invalid_reply_payload_error(const std::string&  msg) : ipc_error(msg) {
+	get_metrics().on_error(ErrorClass::INVALID_REPLY_PAYLOAD_ERROR);
+}
 
 static const std::string  g_i3_ipc_magic = "i3-ipc";
 
@@ -109,10 +125,13 @@ ssize_t  swrite(int  fd, const uint8_t*  buf, size_t  count) {
 }
 
 void   i3_send(const int32_t  sockfd, const buf_t&  buff) {
+	trace_span  span("i3_send", buff.header->type, buff.data.size());
 	swrite(sockfd, buff.data.data(), buff.data.size());
+	get_metrics().on_send(buff.data.size());
 }
 
-std::shared_ptr<buf_t>   i3_recv(const int32_t  sockfd) {
+std::shared_ptr<buf_t>   i3_recv(const int32_t  sockfd, const bool  accounted) {
+	trace_span  span("i3_recv");
 	auto buff{std::make_shared<buf_t>(0)};
 	const uint32_t  header_size = sizeof(header_t);
 
@@ -152,18 +171,87 @@ std::shared_ptr<buf_t>   i3_recv(const int32_t  sockfd) {
 		}
 	}
 
+	if (accounted) {
+		get_metrics().on_receive(buff->header->type, buff->data.size());
+	}
+	span.set_message(buff->header->type, buff->data.size());
 	return buff;
 }
 
 
 std::shared_ptr<buf_t>  i3_msg(const int32_t  sockfd, const ClientMessageType  type, const std::string&  payload) {
-	auto  send_buff = i3_pack(type, payload);
-	i3_send(sockfd, *send_buff);
+	return i3_msg(sockfd, *i3_pack(type, payload));
+}
+
+
+std::shared_ptr<buf_t>  i3_msg(const int32_t  sockfd, const buf_t&  request) {
+	trace_span  span("i3_msg", request.header->type, request.data.size());
+	const bool  timed = get_metrics().enabled();
+	const auto  start = timed ? metrics_registry::clock::now() : metrics_registry::clock::time_point();
+	i3_send(sockfd, request);
 	auto  recv_buff = i3_recv(sockfd);
-	if (send_buff->header->type != recv_buff->header->type) {
-		throw invalid_header_error(auss_t() << "Invalid reply type: Expected 0x" << std::hex << send_buff->header->type << ", got 0x" << recv_buff->header->type);
+	if (request.header->type != recv_buff->header->type) {
+		throw invalid_header_error(auss_t() << "Invalid reply type: Expected 0x" << std::hex << request.header->type << ", got 0x" << recv_buff->header->type);
+	}
+	if (timed) {
+		get_metrics().on_reply(request.header->type, metrics_registry::clock::now() - start);
 	}
 	return recv_buff;
 }
 
+
+size_t  i3_payload_find_key(const buf_t&  buff, const std::string_view  key, const size_t  from) {
+	const std::string_view  payload(buff.payload, buff.header->size);
+	size_t  pos = from;
+	while ((pos = payload.find(key, pos)) != std::string_view::npos) {
+		const size_t  end = pos + key.size();
+		if (pos > 0 && payload[pos - 1] == '"' && end < payload.size() && payload[end] == '"') {
+			size_t  i = end + 1;
+			while (i < payload.size() && isspace(static_cast<unsigned char>(payload[i])))
+				i++;
+			if (i < payload.size() && payload[i] == ':') {
+				i++;
+				while (i < payload.size() && isspace(static_cast<unsigned char>(payload[i])))
+					i++;
+				return i;
+			}
+		}
+		pos = end;
+	}
+	return std::string_view::npos;
+}
+
+bool  i3_payload_read_string(const buf_t&  buff, const size_t  pos, std::string_view&  value) {
+	const std::string_view  payload(buff.payload, buff.header->size);
+	if (pos >= payload.size() || payload[pos] != '"')
+		return false;
+	for (size_t  i = pos + 1; i < payload.size(); i++) {
+		if (payload[i] == '\\') {
+			i++;
+		} else if (payload[i] == '"') {
+			value = payload.substr(pos + 1, i - pos - 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool  i3_payload_read_uint(const buf_t&  buff, const size_t  pos, uint64_t&  value) {
+	const std::string_view  payload(buff.payload, buff.header->size);
+	if (pos >= payload.size() || !isdigit(static_cast<unsigned char>(payload[pos])))
+		return false;
+	value = 0;
+	for (size_t  i = pos; i < payload.size() && isdigit(static_cast<unsigned char>(payload[i])); i++) {
+		value = value * 10 + (payload[i] - '0');
+	}
+	return true;
+}
+
+size_t  i3_payload_find_member(const buf_t&  buff, const std::string_view  object, const std::string_view  key) {
+	size_t  pos = i3_payload_find_key(buff, object);
+	if (pos == std::string_view::npos || pos >= buff.header->size || buff.payload[pos] != '{')
+		return std::string_view::npos;
+	return i3_payload_find_key(buff, key, pos);
+}
+
 }
@@ -1,5 +1,12 @@
+extern "C" {
+#include <poll.h>
+#include <errno.h>
+}
+
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <exception>
 #include <stdexcept>
 #include <iostream>
 #include <memory>
@@ -10,25 +17,31 @@
 #include "log.hpp"
 #include "ipc-util.hpp"
 #include "ipc.hpp"
+#include "capture.hpp"
+#include "command-builder.hpp"
+#include "event-coalescer.hpp"
+#include "event-filter.hpp"
+#include "event-reader.hpp"
+#include "latency-probe.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 
 namespace i3ipc {
 
-// For log.hpp
-std::vector<std::ostream*>  g_logging_outs = {
-	&std::cout,
-};
-std::vector<std::ostream*>  g_logging_err_outs = {
-	&std::cerr,
-};
-
 #define IPC_JSON_READ(ROOT) \
 	{ \
+		trace_span  parse_span("parse_json", buf->header->type, buf->data.size()); \
+		const bool  parse_timed = get_metrics().enabled(); \
+		const auto  parse_start = parse_timed ? metrics_registry::clock::now() : metrics_registry::clock::time_point(); \
 		Json::CharReaderBuilder builder; \
 		std::unique_ptr<Json::CharReader>  reader{builder.newCharReader()}; \
 		std::string error;\
 		if (!reader->parse(buf->payload, buf->payload + buf->header->size, &ROOT, &error)) { \
 			throw invalid_reply_payload_error(auss_t() << "Failed to parse reply on \"" i3IPC_TYPE_STR "\": " << error); \
 		} \
+		if (parse_timed) { \
+			get_metrics().on_parse(metrics_registry::clock::now() - parse_start); \
+		} \
 	}
 
 #define IPC_JSON_ASSERT_TYPE(OBJ, OBJ_DESCR, TYPE_CHECK, TYPE_NAME) \
@@ -167,6 +180,24 @@ static std::shared_ptr<container_t>  parse_container_from_json(const Json::Value
 		}
 	}
 
+	Json::Value  focus = o["focus"];
+	if (!focus.isNull()) {
+		IPC_JSON_ASSERT_TYPE_ARRAY(focus, "focus")
+		container->focus.reserve(focus.size());
+		for (Json::ArrayIndex  i = 0; i < focus.size(); i++) {
+			container->focus.push_back(focus[i].asUInt64());
+		}
+	}
+
+	Json::Value  marks = o["marks"];
+	if (!marks.isNull()) {
+		IPC_JSON_ASSERT_TYPE_ARRAY(marks, "marks")
+		container->marks.reserve(marks.size());
+		for (Json::ArrayIndex  i = 0; i < marks.size(); i++) {
+			container->marks.push_back(marks[i].asString());
+		}
+	}
+
 	container->window_properties = parse_window_props_from_json(o["window_properties"]);
 
 	return container;
@@ -185,6 +216,7 @@ static std::shared_ptr<workspace_t>  parse_workspace_from_json(const Json::Value
 	Json::Value  output = value["output"];
 
 	auto  p{std::make_shared<workspace_t>()};
+	p->id = value["id"].asUInt64();
 	p->num = num.asInt();
 	p->name = name.asString();
 	p->visible = visible.asBool();
@@ -304,6 +336,156 @@ static std::shared_ptr<bar_config_t>  parse_bar_config_from_json(const Json::Val
 #undef i3IPC_TYPE_STR
 }
 
+static std::shared_ptr<workspace_event_t>  parse_workspace_event_from_json(const Json::Value&  root) {
+	auto  ev{std::make_shared<workspace_event_t>()};
+	std::string  change = root["change"].asString();
+	if (change == "focus") {
+		ev->type = WorkspaceEventType::FOCUS;
+	} else if (change == "init") {
+		ev->type = WorkspaceEventType::INIT;
+	} else if (change == "empty") {
+		ev->type = WorkspaceEventType::EMPTY;
+	} else if (change == "urgent") {
+		ev->type = WorkspaceEventType::URGENT;
+	} else if (change == "rename") {
+		ev->type = WorkspaceEventType::RENAME;
+	} else if (change == "reload") {
+		ev->type = WorkspaceEventType::RELOAD;
+	} else if (change == "restored") {
+		ev->type = WorkspaceEventType::RESTORED;
+	} else {
+		I3IPC_WARN("Unknown workspace event type " << change)
+		return nullptr;
+	}
+	I3IPC_DEBUG("WORKSPACE " << change)
+
+	Json::Value  current = root["current"];
+	Json::Value  old = root["old"];
+
+	if (!current.isNull()) {
+		ev->current = parse_workspace_from_json(current);
+	}
+	if (!old.isNull()) {
+		ev->old = parse_workspace_from_json(old);
+	}
+	return ev;
+}
+
+static std::shared_ptr<window_event_t>  parse_window_event_from_json(const Json::Value&  root) {
+	auto  ev{std::make_shared<window_event_t>()};
+	std::string  change = root["change"].asString();
+	if (change == "new") {
+		ev->type = WindowEventType::NEW;
+	} else if (change == "close") {
+		ev->type = WindowEventType::CLOSE;
+	} else if (change == "focus") {
+		ev->type = WindowEventType::FOCUS;
+	} else if (change == "title") {
+		ev->type = WindowEventType::TITLE;
+	} else if (change == "fullscreen_mode") {
+		ev->type = WindowEventType::FULLSCREEN_MODE;
+	} else if (change == "move") {
+		ev->type = WindowEventType::MOVE;
+	} else if (change == "floating") {
+		ev->type = WindowEventType::FLOATING;
+	} else if (change == "urgent") {
+		ev->type = WindowEventType::URGENT;
+	} else if (change == "mark") {
+		ev->type = WindowEventType::MARK;
+	}
+	I3IPC_DEBUG("WINDOW " << change)
+
+	Json::Value  container = root["container"];
+	if (!container.isNull()) {
+		ev->container = parse_container_from_json(container);
+	}
+	return ev;
+}
+
+static std::shared_ptr<binding_t>  parse_binding_event_from_json(const Json::Value&  root) {
+	std::string  change = root["change"].asString();
+	if (change != "run") {
+		I3IPC_WARN("Got \"" << change << "\" in field \"change\" of binding_event. Expected \"run\"")
+	}
+
+	Json::Value  binding_json = root["binding"];
+	std::shared_ptr<binding_t>  bptr;
+	if (!binding_json.isNull()) {
+		bptr = parse_binding_from_json(binding_json);
+	}
+
+	if (!bptr) {
+		I3IPC_ERR("Failed to parse field \"binding\" from binding_event")
+	} else {
+		I3IPC_DEBUG("BINDING " << bptr->symbol);
+	}
+	return bptr;
+}
+
+static std::shared_ptr<tick_event_t>  parse_tick_event_from_json(const Json::Value&  root) {
+	auto  ev = std::make_shared<tick_event_t>();
+	ev->first = root["first"].asBool();
+	ev->payload = root["payload"].asString();
+	I3IPC_DEBUG("TICK " << ev->payload)
+	return ev;
+}
+
+/**
+ * Get a type of an event message
+ */
+static inline EventType  event_type_of(const buf_t&  buf) {
+	return static_cast<EventType>(1 << (buf.header->type & 0x7f));
+}
+
+void  decode_event(event_t&  ev) {
+#define i3IPC_TYPE_STR "i3's event"
+	const buf_t*  buf = ev.buf.get();
+	switch (ev.type) {
+	case ET_WORKSPACE: {
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.workspace = parse_workspace_event_from_json(root);
+		break;
+	}
+	case ET_MODE: {
+		I3IPC_DEBUG("MODE")
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.mode = parse_mode_from_json(root);
+		break;
+	}
+	case ET_WINDOW: {
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.window = parse_window_event_from_json(root);
+		break;
+	}
+	case ET_BARCONFIG_UPDATE: {
+		I3IPC_DEBUG("BARCONFIG_UPDATE")
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.bar_config = parse_bar_config_from_json(root);
+		break;
+	}
+	case ET_BINDING: {
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.binding = parse_binding_event_from_json(root);
+		break;
+	}
+	case ET_TICK: {
+		Json::Value  root;
+		IPC_JSON_READ(root);
+		ev.tick = parse_tick_event_from_json(root);
+		break;
+	}
+	default:
+		break;
+	};
+	ev.decoded = true;
+#undef i3IPC_TYPE_STR
+}
+
 std::string  get_socketpath() {
 	const char*  envsock{std::getenv("I3SOCK")};
 	if (envsock) {
@@ -332,46 +514,52 @@ std::string  get_socketpath() {
 }
 
 
-connection::connection(const std::string&  socket_path) : m_main_socket(i3_connect(socket_path)), m_event_socket(-1), m_subscriptions(0), m_socket_path(socket_path) {
-#define i3IPC_TYPE_STR "i3's event"
+connection::connection(const std::string&  socket_path) : connection(i3_connect(socket_path), -1, socket_path) {}
+
+connection::connection(const int32_t  main_socket, const int32_t  event_socket) : connection(main_socket, event_socket, std::string()) {}
+
+connection::connection(const int32_t  main_socket, const int32_t  event_socket, const std::string&  socket_path) :
+	m_main_socket(main_socket),
+	m_event_socket(event_socket),
+	m_subscriptions(0),
+	m_socket_path(socket_path),
+	m_coalescer(new event_coalescer()),
+	m_filters(new event_filter_set()),
+	m_reported_drops(0),
+	m_dispatching(nullptr),
+	m_capture_main(false),
+	m_probe(new latency_probe()),
+	m_timing(false),
+	m_last_timing(),
+	m_timing_current(nullptr),
+	m_max_pending_commands(64)
+{
+	// Typed signals are decoded only if there are slots connected to them, and only once for all of slots
 	signal_event.connect([this](EventType  event_type, const std::shared_ptr<const buf_t>&  buf) {
-		switch (event_type) {
-		case ET_WORKSPACE: {
-			workspace_event_t  ev;
-			Json::Value  root;
-			IPC_JSON_READ(root);
-			std::string  change = root["change"].asString();
-			if (change == "focus") {
-				ev.type = WorkspaceEventType::FOCUS;
-			} else if (change == "init") {
-				ev.type = WorkspaceEventType::INIT;
-			} else if (change == "empty") {
-				ev.type = WorkspaceEventType::EMPTY;
-			} else if (change == "urgent") {
-				ev.type = WorkspaceEventType::URGENT;
-			} else if (change == "rename") {
-				ev.type = WorkspaceEventType::RENAME;
-			} else if (change == "reload") {
-				ev.type = WorkspaceEventType::RELOAD;
-			} else if (change == "restored") {
-				ev.type = WorkspaceEventType::RESTORED;
+		event_t  storage;
+		auto  decoded = [&]() -> const event_t& {
+			if (m_dispatching && m_dispatching->buf == buf && m_dispatching->decoded) {
+				return *m_dispatching; // Predecoded by the event reader thread
+			}
+			storage = { event_type, buf };
+			if (m_timing_current) {
+				auto  start = std::chrono::steady_clock::now();
+				decode_event(storage);
+				m_timing_current->parse += std::chrono::steady_clock::now() - start;
 			} else {
-				I3IPC_WARN("Unknown workspace event type " << change)
-				break;
+				decode_event(storage);
 			}
-			I3IPC_DEBUG("WORKSPACE " << change)
-
-			Json::Value  current = root["current"];
-			Json::Value  old = root["old"];
+			return storage;
+		};
 
-			if (!current.isNull()) {
-				ev.current = parse_workspace_from_json(current);
-			}
-			if (!old.isNull()) {
-				ev.old = parse_workspace_from_json(old);
+		switch (event_type) {
+		case ET_WORKSPACE: {
+			if (signal_workspace_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.workspace) {
+				signal_workspace_event.emit(*ev.workspace);
 			}
-
-			signal_workspace_event.emit(ev);
 			break;
 		}
 		case ET_OUTPUT:
@@ -379,80 +567,59 @@ connection::connection(const std::string&  socket_path) : m_main_socket(i3_conne
 			signal_output_event.emit();
 			break;
 		case ET_MODE: {
-			I3IPC_DEBUG("MODE")
-			Json::Value  root;
-			IPC_JSON_READ(root);
-			std::shared_ptr<mode_t>  mode_data = parse_mode_from_json(root);
-			signal_mode_event.emit(*mode_data);
+			if (signal_mode_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.mode) {
+				signal_mode_event.emit(*ev.mode);
+			}
 			break;
 		}
 		case ET_WINDOW: {
-			window_event_t  ev;
-			Json::Value  root;
-			IPC_JSON_READ(root);
-			std::string  change = root["change"].asString();
-			if (change == "new") {
-				ev.type = WindowEventType::NEW;
-			} else if (change == "close") {
-				ev.type = WindowEventType::CLOSE;
-			} else if (change == "focus") {
-				ev.type = WindowEventType::FOCUS;
-			} else if (change == "title") {
-				ev.type = WindowEventType::TITLE;
-			} else if (change == "fullscreen_mode") {
-				ev.type = WindowEventType::FULLSCREEN_MODE;
-			} else if (change == "move") {
-				ev.type = WindowEventType::MOVE;
-			} else if (change == "floating") {
-				ev.type = WindowEventType::FLOATING;
-			} else if (change == "urgent") {
-				ev.type = WindowEventType::URGENT;
-			}
-			I3IPC_DEBUG("WINDOW " << change)
-
-			Json::Value  container = root["container"];
-			if (!container.isNull()) {
-				ev.container = parse_container_from_json(container);
+			if (signal_window_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.window) {
+				signal_window_event.emit(*ev.window);
 			}
-
-			signal_window_event.emit(ev);
 			break;
 		}
 		case ET_BARCONFIG_UPDATE: {
-			I3IPC_DEBUG("BARCONFIG_UPDATE")
-			Json::Value  root;
-			IPC_JSON_READ(root);
-			std::shared_ptr<bar_config_t>  barconf = parse_bar_config_from_json(root);
-			signal_barconfig_update_event.emit(*barconf);
+			if (signal_barconfig_update_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.bar_config) {
+				signal_barconfig_update_event.emit(*ev.bar_config);
+			}
 			break;
 		}
 		case ET_BINDING: {
-			Json::Value  root;
-			IPC_JSON_READ(root);
-			std::string  change = root["change"].asString();
-			if (change != "run") {
-				I3IPC_WARN("Got \"" << change << "\" in field \"change\" of binding_event. Expected \"run\"")
-			}
-
-			Json::Value  binding_json = root["binding"];
-			std::shared_ptr<binding_t>  bptr;
-			if (!binding_json.isNull()) {
-				bptr = parse_binding_from_json(binding_json);
+			if (signal_binding_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.binding) {
+				signal_binding_event.emit(*ev.binding);
 			}
-
-			if (!bptr) {
-				I3IPC_ERR("Failed to parse field \"binding\" from binding_event")
-			} else {
-				I3IPC_DEBUG("BINDING " << bptr->symbol);
-				signal_binding_event.emit(*bptr);
+			break;
+		}
+		case ET_SHUTDOWN:
+			I3IPC_DEBUG("SHUTDOWN")
+			signal_shutdown_event.emit();
+			break;
+		case ET_TICK: {
+			if (signal_tick_event.empty())
+				break;
+			const event_t&  ev = decoded();
+			if (ev.tick) {
+				signal_tick_event.emit(*ev.tick);
 			}
 			break;
 		}
 		};
 	});
-#undef i3IPC_TYPE_STR
 }
 connection::~connection() {
+	m_reader.reset();
 	i3_disconnect(m_main_socket);
 	if (m_event_socket > 0)
 		this->disconnect_event_socket();
@@ -478,22 +645,253 @@ void  connection::disconnect_event_socket() {
 		I3IPC_WARN("Trying to disconnect non-connected event socket")
 		return;
 	}
+	if (m_reader) {
+		I3IPC_WARN("Disconnecting event socket, while the event reader is running. Stopping the reader")
+		m_reader.reset();
+	}
 	i3_disconnect(m_event_socket);
+	m_event_socket = -1;
+}
+
+
+/**
+ * Wait until the fd is readable or the nearest deadline of held events is over
+ * @return Is the fd readable
+ */
+bool  connection::wait_for_event(const int32_t  fd) {
+	auto  deadline = m_coalescer->next_deadline();
+	auto  probe_deadline = m_probe->next_deadline();
+	if (probe_deadline && (!deadline || *probe_deadline < *deadline)) {
+		deadline = probe_deadline;
+	}
+	if (!deadline && !m_reader) {
+		return true; // Just block in i3_recv()
+	}
+
+	int  timeout = -1;
+	if (deadline) {
+		auto  left = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - event_coalescer::clock::now()).count() + 1;
+		timeout = std::max<int>(0, left);
+	}
+	struct pollfd  pfd = { fd, POLLIN, 0 };
+	int  n = poll(&pfd, 1, timeout);
+	if (n == -1) {
+		if (errno == EINTR)
+			return false;
+		throw errno_error("Failed to poll for events");
+	}
+	return n > 0;
+}
+
+
+/**
+ * Pass an event through filters and the coalescing stage
+ * @param  ready  events to dispatch after, if the coalescing stage is active
+ */
+void  connection::process_event(event_t&&  ev, std::vector<event_t>&  ready) {
+	if (m_capture) {
+		m_capture->write(CaptureChannel::EVENT, *ev.buf, ev.received);
+	}
+	if (ev.type == ET_TICK && m_probe->enabled() && m_probe->on_tick(*ev.buf, latency_probe::clock::now()))
+		return;
+	if (!m_filters->check(ev.type, *ev.buf))
+		return;
+	if (m_coalescer->enabled() || m_coalescer->size() > 0) {
+		m_coalescer->push(ev, event_coalescer::clock::now(), ready);
+	} else {
+		this->dispatch_event(ev);
+	}
+}
+
+
+void  connection::dispatch_event(const event_t&  ev) {
+	trace_span  span("dispatch", ev.buf->header->type, ev.buf->data.size());
+	if (m_timing) {
+		this->dispatch_timed_event(ev);
+		return;
+	}
+	const event_t*  previous = m_dispatching;
+	m_dispatching = &ev;
+	try {
+		this->signal_event.emit(ev.type, ev.buf);
+	} catch (...) {
+		m_dispatching = previous;
+		throw;
+	}
+	m_dispatching = previous;
+}
+
+
+/**
+ * Dispatch an event, measuring its timing
+ */
+void  connection::dispatch_timed_event(const event_t&  ev) {
+	event_timing_t  timing;
+	timing.type = ev.type;
+	timing.bytes = ev.buf->data.size();
+	timing.received = ev.received;
+	timing.parse = ev.decode_time;
+	timing.predecoded = ev.decoded;
+
+	const event_t*  previous = m_dispatching;
+	event_timing_t*  previous_timing = m_timing_current;
+	m_dispatching = &ev;
+	m_timing_current = &timing;
+	timing.dispatched = std::chrono::steady_clock::now();
+	try {
+		this->signal_event.emit(ev.type, ev.buf);
+	} catch (...) {
+		m_dispatching = previous;
+		m_timing_current = previous_timing;
+		throw;
+	}
+	const auto  total = std::chrono::steady_clock::now() - timing.dispatched;
+	m_dispatching = previous;
+	m_timing_current = previous_timing;
+
+	timing.dispatch = std::chrono::duration_cast<std::chrono::nanoseconds>(total) - (timing.parse - ev.decode_time);
+	m_last_timing = timing;
+	this->signal_event_timing.emit(timing);
 }
 
 
 void  connection::handle_event() {
+	this->run_latency_probe();
+	if (m_reader) {
+		this->wait_for_event(m_reader->get_fd());
+		this->dispatch_queued_events();
+		return;
+	}
+	if (m_event_socket <= 0) {
+		this->connect_event_socket();
+	}
+
+	std::vector<event_t>  ready;
+	if (this->wait_for_event(m_event_socket)) {
+		std::shared_ptr<const buf_t>  buf = i3_recv(m_event_socket);
+		event_t  ev = { event_type_of(*buf), buf };
+		if (m_timing || m_capture) {
+			ev.received = std::chrono::steady_clock::now();
+		}
+		this->process_event(std::move(ev), ready);
+	}
+	if (m_coalescer->size() > 0) {
+		m_coalescer->pop_due(event_coalescer::clock::now(), ready);
+	}
+	for (auto&  ev : ready) {
+		this->dispatch_event(ev);
+	}
+}
+
+
+void  connection::flush_coalesced_events() {
+	std::vector<event_t>  ready;
+	m_coalescer->flush(ready);
+	for (auto&  ev : ready) {
+		this->dispatch_event(ev);
+	}
+}
+
+
+void  connection::start_event_reader(const size_t  capacity, const int32_t  predecode, const OverflowPolicy  overflow) {
+	if (m_reader) {
+		I3IPC_ERR("Trying to start event reader secondary")
+		return;
+	}
 	if (m_event_socket <= 0) {
 		this->connect_event_socket();
 	}
-	auto  buf = i3_recv(m_event_socket);
+	m_reader.reset(new event_reader(m_event_socket, capacity, predecode, overflow));
+	m_reported_drops = 0;
+}
+
 
-	this->signal_event.emit(static_cast<EventType>(1 << (buf->header->type & 0x7f)), std::static_pointer_cast<const buf_t>(buf));
+void  connection::stop_event_reader() {
+	if (!m_reader) {
+		I3IPC_WARN("Trying to stop non-running event reader")
+		return;
+	}
+	m_reader.reset();
+	// The reader has shut down the socket
+	this->disconnect_event_socket();
+}
+
+
+int32_t  connection::get_event_reader_fd() const {
+	return m_reader ? m_reader->get_fd() : -1;
+}
+
+
+size_t  connection::dispatch_queued_events() {
+	if (!m_reader)
+		return 0;
+	this->run_latency_probe();
+
+	const size_t  max = m_reader->stats().capacity;
+	std::vector<event_t>  ready;
+	size_t  n = 0;
+	// An error of the reader thread is rethrown after the events, that were taken before it, are dispatched
+	std::exception_ptr  reader_error;
+	auto  pop = [this, &reader_error](event_t&  ev) {
+		try {
+			return m_reader->pop(ev);
+		} catch (...) {
+			reader_error = std::current_exception();
+			return false;
+		}
+	};
+	do {
+		event_t  ev;
+		while (n < max && pop(ev)) {
+			n++;
+			this->process_event(std::move(ev), ready);
+		}
+		if (reader_error) {
+			m_coalescer->flush(ready);
+			break;
+		}
+		if (n >= max) {
+			// Don't starve the consumer's loop, but keep the eventfd readable
+			m_reader->wake();
+			break;
+		}
+	} while (!m_reader->prepare_to_wait());
+
+	if (m_coalescer->size() > 0) {
+		m_coalescer->pop_due(event_coalescer::clock::now(), ready);
+	}
+	for (auto&  ev : ready) {
+		this->dispatch_event(ev);
+	}
+
+	const uint64_t  dropped = m_reader ? m_reader->dropped() : m_reported_drops; // A slot may have stopped the reader
+	if (dropped != m_reported_drops) {
+		const uint64_t  lost = dropped - m_reported_drops;
+		m_reported_drops = dropped;
+		I3IPC_WARN("Event reader has dropped " << lost << " events")
+		this->signal_resync_needed.emit(lost);
+	}
+	if (reader_error) {
+		std::rethrow_exception(reader_error);
+	}
+	return n;
+}
+
+
+event_reader_stats_t  connection::get_event_reader_stats() const {
+	return m_reader ? m_reader->stats() : event_reader_stats_t();
 }
 
 
 bool  connection::subscribe(const int32_t  events) {
 #define i3IPC_TYPE_STR "SUBSCRIBE"
+	if (m_reader) {
+		if ((events & ~m_subscriptions) == 0) {
+			return true;
+		}
+		I3IPC_ERR("Can't subscribe, while the event reader is running")
+		return false;
+	}
 	if (m_event_socket <= 0) {
 		m_subscriptions |= events;
 		return true;
@@ -519,6 +917,12 @@ bool  connection::subscribe(const int32_t  events) {
 		if (events & static_cast<int32_t>(ET_BINDING)) {
 			payload_auss << "\"binding\",";
 		}
+		if (events & static_cast<int32_t>(ET_SHUTDOWN)) {
+			payload_auss << "\"shutdown\",";
+		}
+		if (events & static_cast<int32_t>(ET_TICK)) {
+			payload_auss << "\"tick\",";
+		}
 		payload = payload_auss;
 		if (payload.empty()) {
 			return true;
@@ -538,9 +942,43 @@ bool  connection::subscribe(const int32_t  events) {
 }
 
 
+void  connection::start_capture(const std::string&  path, const bool  main_socket) {
+	m_capture.reset(new capture_recorder(path));
+	m_capture_main = main_socket;
+}
+
+
+void  connection::stop_capture() {
+	if (!m_capture) {
+		I3IPC_WARN("Trying to stop non-running capture")
+		return;
+	}
+	m_capture->flush();
+	m_capture.reset();
+}
+
+
+std::shared_ptr<buf_t>  connection::request(const ClientMessageType  type, const std::string&  payload) const {
+	return this->request(*i3_pack(type, payload));
+}
+
+
+std::shared_ptr<buf_t>  connection::request(const buf_t&  message) const {
+	// Replies of asynchronous commands come first
+	while (!m_pending_commands.empty()) {
+		this->read_command_reply();
+	}
+	auto  buf = i3_msg(m_main_socket, message);
+	if (m_capture && m_capture_main) {
+		m_capture->write(CaptureChannel::MAIN, *buf);
+	}
+	return buf;
+}
+
+
 version_t  connection::get_version() const {
 #define i3IPC_TYPE_STR "GET_VERSION"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_VERSION);
+	auto  buf = this->request(ClientMessageType::GET_VERSION);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	IPC_JSON_ASSERT_TYPE_OBJECT(root, "root")
@@ -558,9 +996,10 @@ version_t  connection::get_version() const {
 
 std::shared_ptr<container_t>  connection::get_tree() const {
 #define i3IPC_TYPE_STR "GET_TREE"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_TREE);
+	auto  buf = this->request(ClientMessageType::GET_TREE);
 	Json::Value  root;
 	IPC_JSON_READ(root);
+	trace_span  span("parse_tree", buf->header->type, buf->data.size());
 	return parse_container_from_json(root);
 #undef i3IPC_TYPE_STR
 }
@@ -568,7 +1007,7 @@ std::shared_ptr<container_t>  connection::get_tree() const {
 
 std::vector< std::shared_ptr<output_t> >  connection::get_outputs() const {
 #define i3IPC_TYPE_STR "GET_OUTPUTS"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_OUTPUTS);
+	auto  buf = this->request(ClientMessageType::GET_OUTPUTS);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
@@ -586,7 +1025,7 @@ std::vector< std::shared_ptr<output_t> >  connection::get_outputs() const {
 
 std::vector< std::shared_ptr<workspace_t> >  connection::get_workspaces() const {
 #define i3IPC_TYPE_STR "GET_WORKSPACES"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_WORKSPACES);
+	auto  buf = this->request(ClientMessageType::GET_WORKSPACES);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
@@ -604,7 +1043,7 @@ std::vector< std::shared_ptr<workspace_t> >  connection::get_workspaces() const
 
 std::vector<std::string>  connection::get_bar_configs_list() const {
 #define i3IPC_TYPE_STR "GET_BAR_CONFIG (get_bar_configs_list)"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_BAR_CONFIG);
+	auto  buf = this->request(ClientMessageType::GET_BAR_CONFIG);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
@@ -620,9 +1059,26 @@ std::vector<std::string>  connection::get_bar_configs_list() const {
 }
 
 
+std::vector<std::string>  connection::get_marks() const {
+#define i3IPC_TYPE_STR "GET_MARKS"
+	auto  buf = this->request(ClientMessageType::GET_MARKS);
+	Json::Value  root;
+	IPC_JSON_READ(root)
+	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
+
+	std::vector<std::string>  marks;
+	marks.reserve(root.size());
+	for (auto&  m : root) {
+		marks.push_back(m.asString());
+	}
+	return marks;
+#undef i3IPC_TYPE_STR
+}
+
+
 std::shared_ptr<bar_config_t>  connection::get_bar_config(const std::string&  name) const {
 #define i3IPC_TYPE_STR "GET_BAR_CONFIG"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::GET_BAR_CONFIG, name);
+	auto  buf = this->request(ClientMessageType::GET_BAR_CONFIG, name);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	return parse_bar_config_from_json(root);
@@ -632,7 +1088,7 @@ std::shared_ptr<bar_config_t>  connection::get_bar_config(const std::string&  na
 
 bool  connection::send_command(const std::string&  command) const {
 #define i3IPC_TYPE_STR "COMMAND"
-	auto  buf = i3_msg(m_main_socket, ClientMessageType::COMMAND, command);
+	auto  buf = this->request(ClientMessageType::COMMAND, command);
 	Json::Value  root;
 	IPC_JSON_READ(root)
 	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
@@ -651,6 +1107,217 @@ bool  connection::send_command(const std::string&  command) const {
 #undef i3IPC_TYPE_STR
 }
 
+
+/**
+ * Count results, that i3 replies on a command: one per command of its list, separated by ',' or ';' out of
+ * criteria and quoted strings. Empty commands have no results
+ */
+static size_t  count_command_results(const std::string&  command) {
+	size_t  results = 0;
+	bool  content = false;
+	bool  quoted = false;
+	bool  escaped = false;
+	uint32_t  brackets = 0;
+	for (char  c : command) {
+		if (quoted) {
+			if (escaped) {
+				escaped = false;
+			} else if (c == '\\') {
+				escaped = true;
+			} else if (c == '"') {
+				quoted = false;
+			}
+			continue;
+		}
+		if (c == '"') {
+			quoted = true;
+		} else if (c == '[') {
+			brackets++;
+		} else if (c == ']' && brackets > 0) {
+			brackets--;
+		} else if ((c == ';' || c == ',') && brackets == 0) {
+			results += content;
+			content = false;
+			continue;
+		}
+		content = content || !isspace(static_cast<unsigned char>(c));
+	}
+	return results + content;
+}
+
+/**
+ * Map results of a reply of COMMAND to the commands
+ * @param  count_of number of results of a command by its index
+ */
+template<typename CountOf>
+static std::vector<command_result_t>  parse_command_results(const buf_t*  buf, const size_t  commands_count, const CountOf&  count_of) {
+#define i3IPC_TYPE_STR "COMMAND"
+	Json::Value  root;
+	IPC_JSON_READ(root)
+	IPC_JSON_ASSERT_TYPE_ARRAY(root, "root")
+
+	std::vector<command_result_t>  results;
+	results.reserve(commands_count);
+	Json::ArrayIndex  i = 0;
+	for (size_t  c = 0; c < commands_count; c++) {
+		command_result_t  result = { true, std::string() };
+		const size_t  n = count_of(c);
+		for (size_t  k = 0; k < n; k++, i++) {
+			if (i >= root.size()) {
+				if (result.success)
+					result = { false, "Not executed" };
+				break;
+			}
+			const Json::Value&  item = root[i];
+			IPC_JSON_ASSERT_TYPE_OBJECT(item, "item of root")
+			if (!item["success"].asBool() && result.success) {
+				result.success = false;
+				result.error = item["error"].asString();
+			}
+		}
+		results.push_back(std::move(result));
+	}
+	if (i < root.size()) {
+		I3IPC_WARN("Got " << root.size() << " results of " << i << " commands: results may be matched to wrong commands")
+	}
+	return results;
+#undef i3IPC_TYPE_STR
+}
+
+std::vector<command_result_t>  connection::send_commands(const std::vector<std::string>&  commands) const {
+	if (commands.empty())
+		return {};
+	size_t  size = 0;
+	for (auto&  command : commands) {
+		size += command.size() + 1;
+	}
+	std::string  payload;
+	payload.reserve(size);
+	for (auto&  command : commands) {
+		if (!payload.empty())
+			payload.push_back(';');
+		payload.append(command);
+	}
+
+	auto  buf = this->request(ClientMessageType::COMMAND, payload);
+	return parse_command_results(buf.get(), commands.size(), [&commands](const size_t  c) {
+		return count_command_results(commands[c]);
+	});
+}
+
+
+std::vector<command_result_t>  connection::send_commands(command_builder&  commands) const {
+	if (commands.size() == 0)
+		return {};
+	auto  buf = this->request(commands.message());
+	return parse_command_results(buf.get(), commands.size(), [&commands](const size_t  c) {
+		return commands.results_of(c);
+	});
+}
+
+
+void  connection::send_command_async(const std::string&  command, command_callback_t  callback) {
+	while (m_pending_commands.size() >= m_max_pending_commands) {
+		this->read_command_reply();
+	}
+	auto  buf = i3_pack(ClientMessageType::COMMAND, command);
+	i3_send(m_main_socket, *buf);
+	const bool  timed = get_metrics().enabled();
+	m_pending_commands.push_back({ command, std::move(callback), timed ? metrics_registry::clock::now() : metrics_registry::clock::time_point() });
+}
+
+
+size_t  connection::process_command_replies() {
+	size_t  n = 0;
+	while (!m_pending_commands.empty()) {
+		struct pollfd  pfd = { m_main_socket, POLLIN, 0 };
+		const int  ready = poll(&pfd, 1, 0);
+		if (ready == -1 && errno != EINTR)
+			throw errno_error("Failed to poll the main socket");
+		if (ready <= 0)
+			break;
+		this->read_command_reply();
+		n++;
+	}
+	return n;
+}
+
+
+void  connection::wait_command_replies() {
+	while (!m_pending_commands.empty()) {
+		this->read_command_reply();
+	}
+}
+
+
+void  connection::set_max_pending_commands(const size_t  max) {
+	m_max_pending_commands = std::max<size_t>(1, max);
+}
+
+
+/**
+ * Read the reply of the oldest asynchronous command
+ */
+void  connection::read_command_reply() const {
+	auto  buf = i3_recv(m_main_socket);
+	if (buf->header->type != static_cast<uint32_t>(ClientMessageType::COMMAND)) {
+		throw invalid_header_error(auss_t() << "Invalid reply type: Expected 0x0 (COMMAND), got 0x" << std::hex << buf->header->type);
+	}
+	if (m_capture && m_capture_main) {
+		m_capture->write(CaptureChannel::MAIN, *buf);
+	}
+	pending_command_t  pending = std::move(m_pending_commands.front());
+	m_pending_commands.pop_front();
+	if (pending.sent != metrics_registry::clock::time_point()) {
+		get_metrics().on_reply(buf->header->type, metrics_registry::clock::now() - pending.sent);
+	}
+
+	const command_result_t  result = parse_command_results(buf.get(), 1, [&pending](const size_t) {
+		return count_command_results(pending.command);
+	})[0];
+	if (!result.success) {
+		signal_command_error.emit(pending.command, result);
+	}
+	if (pending.callback) {
+		pending.callback(result);
+	}
+}
+
+bool  connection::send_tick(const std::string&  payload) const {
+#define i3IPC_TYPE_STR "SEND_TICK"
+	auto  buf = this->request(ClientMessageType::SEND_TICK, payload);
+	Json::Value  root;
+	IPC_JSON_READ(root)
+	IPC_JSON_ASSERT_TYPE_OBJECT(root, "root")
+	return root["success"].asBool();
+#undef i3IPC_TYPE_STR
+}
+
+
+void  connection::set_latency_probe_interval(const std::chrono::milliseconds  interval) {
+	if (interval.count() > 0 && !this->subscribe(ET_TICK)) {
+		throw ipc_error("Failed to subscribe to tick events for the latency probe");
+	}
+	m_probe->set_interval(interval);
+}
+
+
+/**
+ * Send a tick of the latency probe, if it is time
+ */
+void  connection::run_latency_probe() {
+	auto  deadline = m_probe->next_deadline();
+	if (!deadline)
+		return;
+	auto  now = latency_probe::clock::now();
+	if (now < *deadline)
+		return;
+	const std::string  payload = m_probe->start(now);
+	if (this->send_tick(payload)) {
+		m_probe->on_reply(latency_probe::clock::now() - now);
+	}
+}
+
 int32_t  connection::get_main_socket_fd() { return m_main_socket; }
 
 int32_t  connection::get_event_socket_fd() { return m_event_socket; }
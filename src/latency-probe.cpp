@@ -0,0 +1,69 @@
+extern "C" {
+#include <unistd.h>
+}
+
+#include <cstdlib>
+
+#include <auss.hpp>
+
+#include "latency-probe.hpp"
+
+namespace i3ipc {
+
+/// Max number of ticks waiting for their events
+static const size_t  g_max_pending = 64;
+
+latency_probe::latency_probe() :
+	m_interval(clock::duration::zero()),
+	m_prefix(auss_t() << "i3ipc++ probe " << getpid() << ':' << reinterpret_cast<uintptr_t>(this) << ':'),
+	m_seq(0),
+	m_sent(0),
+	m_received(0),
+	m_lost(0)
+{}
+
+
+void  latency_probe::set_interval(const clock::duration  interval) {
+	m_interval = interval;
+	m_next = clock::now();
+}
+
+
+std::optional<latency_probe::clock::time_point>  latency_probe::next_deadline() const {
+	if (!this->enabled())
+		return std::nullopt;
+	return m_next;
+}
+
+
+std::string  latency_probe::start(const clock::time_point  now) {
+	m_next = now + m_interval;
+	if (m_pending.size() >= g_max_pending) {
+		m_pending.erase(m_pending.begin());
+		m_lost++;
+	}
+	const uint64_t  seq = ++m_seq;
+	m_pending[seq] = now;
+	m_sent++;
+	return auss_t() << m_prefix << seq;
+}
+
+
+bool  latency_probe::on_tick(const buf_t&  buf, const clock::time_point  now) {
+	std::string_view  payload;
+	if (!i3_payload_read_string(buf, i3_payload_find_key(buf, "payload"), payload))
+		return false;
+	if (payload.substr(0, m_prefix.size()) != m_prefix)
+		return false;
+
+	const uint64_t  seq = std::strtoull(std::string(payload.substr(m_prefix.size())).c_str(), nullptr, 10);
+	auto  it = m_pending.find(seq);
+	if (it != m_pending.end()) {
+		m_event_delay.record(now - it->second);
+		m_received++;
+		m_pending.erase(it);
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,416 @@
+extern "C" {
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+}
+
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "log.hpp"
+
+namespace i3ipc {
+
+std::vector<std::ostream*>  g_logging_outs = {
+	&std::cout,
+};
+std::vector<std::ostream*>  g_logging_err_outs = {
+	&std::cerr,
+};
+
+#ifdef DEBUG
+std::atomic<uint8_t>  g_log_level(static_cast<uint8_t>(LogLevel::VERBOSE));
+#else
+std::atomic<uint8_t>  g_log_level(static_cast<uint8_t>(LogLevel::INFO));
+#endif
+
+static std::atomic<uint32_t>  g_rate_messages(10);
+static std::atomic<int64_t>  g_rate_interval(1000000000); ///< Nanoseconds
+static std::atomic<uint64_t>  g_dropped(0);
+
+static const size_t  g_max_queued = 8192;
+
+static int64_t  now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+bool  log_site::allow() {
+	const uint32_t  limit = g_rate_messages.load(std::memory_order_relaxed);
+	if (!limit)
+		return true;
+
+	const int64_t  now = now_ns();
+	int64_t  start = m_window_start.load(std::memory_order_relaxed);
+	if (now - start >= g_rate_interval.load(std::memory_order_relaxed) && m_window_start.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+		m_count.store(0, std::memory_order_relaxed);
+	}
+	if (m_count.fetch_add(1, std::memory_order_relaxed) < limit)
+		return true;
+	m_suppressed.fetch_add(1, std::memory_order_relaxed);
+	g_dropped.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+static void  default_sink(const LogLevel  level, const std::string&  message) {
+	static const char*  prefixes[] = { "D: ", "i: ", "W: ", "E: " };
+	for (auto  out : (level == LogLevel::INFO ? g_logging_outs : g_logging_err_outs)) {
+		*out << prefixes[static_cast<uint8_t>(level) & 3] << message << '\n';
+	}
+}
+
+static void  flush_default_sink() {
+	for (auto  out : g_logging_outs)
+		out->flush();
+	for (auto  out : g_logging_err_outs)
+		out->flush();
+}
+
+
+/**
+ * @brief Background writer of log messages
+ *
+ * Producers push records into an intrusive lock-free MPSC queue (Vyukov's) and wake the thread through
+ * an eventfd only if it sleeps. The thread deduplicates repeated messages of a site and calls the sink.
+ * The thread is started by the first message and stopped at exit, after that messages are written synchronously.
+ */
+class logger {
+public:
+	struct record_t {
+		std::atomic<record_t*>  next;
+		LogLevel  level;
+		log_site*  site;
+		uint32_t  suppressed;
+		std::string  message;
+	};
+
+	logger() :
+		m_head(&m_stub),
+		m_tail(&m_stub),
+		m_queued(0),
+		m_pushed(0),
+		m_written(0),
+		m_waiting(false),
+		m_running(false),
+		m_stop(false),
+		m_wake_fd(-1)
+	{
+		m_stub.next.store(nullptr, std::memory_order_relaxed);
+	}
+
+	void  push(const LogLevel  level, log_site*  site, std::string&&  message) {
+		if (m_queued.load(std::memory_order_relaxed) >= g_max_queued) {
+			g_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		std::call_once(m_start_flag, [this]() { this->start(); });
+
+		record_t*  record = new record_t();
+		record->next.store(nullptr, std::memory_order_relaxed);
+		record->level = level;
+		record->site = site;
+		record->suppressed = site ? site->take_suppressed() : 0;
+		record->message = std::move(message);
+
+		if (!m_running.load(std::memory_order_acquire)) {
+			// No thread (at exit)
+			std::lock_guard<std::mutex>  lock(m_sink_mutex);
+			this->write(*record);
+			this->flush_repeats();
+			this->flush_sink();
+			delete record;
+			return;
+		}
+
+		m_queued.fetch_add(1, std::memory_order_relaxed);
+		record_t*  prev = m_head.exchange(record, std::memory_order_acq_rel);
+		prev->next.store(record, std::memory_order_release);
+		m_pushed.fetch_add(1);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_waiting.exchange(false)) {
+			const uint64_t  one = 1;
+			(void)!::write(m_wake_fd, &one, sizeof(one));
+		}
+	}
+
+	void  set_sink(log_sink_t  sink) {
+		std::lock_guard<std::mutex>  lock(m_sink_mutex);
+		this->flush_repeats();
+		m_sink = std::move(sink);
+	}
+
+	void  flush() {
+		if (!m_running.load(std::memory_order_acquire))
+			return;
+		const uint64_t  target = m_pushed.load();
+		std::unique_lock<std::mutex>  lock(m_flush_mutex);
+		m_flush_target = std::max(m_flush_target, target);
+		const uint64_t  ticket = ++m_flush_requested;
+		const uint64_t  one = 1;
+		(void)!::write(m_wake_fd, &one, sizeof(one));
+		m_flushed.wait(lock, [this, ticket]() { return m_flush_completed >= ticket || !m_running.load(); });
+	}
+
+	void  stop() {
+		if (!m_running.load())
+			return;
+		m_stop.store(true);
+		const uint64_t  one = 1;
+		(void)!::write(m_wake_fd, &one, sizeof(one));
+		m_thread.join();
+		m_running.store(false, std::memory_order_release);
+		m_flushed.notify_all();
+	}
+
+private:
+	void  start() {
+		m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (m_wake_fd == -1)
+			return; // Messages are written synchronously
+		m_thread = std::thread(&logger::run, this);
+		m_running.store(true, std::memory_order_release);
+		std::atexit([]() { get().stop(); });
+	}
+
+	/**
+	 * Take the next record (the single consumer)
+	 */
+	record_t*  pop() {
+		record_t*  tail = m_tail;
+		record_t*  next = tail->next.load(std::memory_order_acquire);
+		if (!next)
+			return nullptr;
+		// The next record becomes the stub: move its content into the old one
+		m_tail = next;
+		if (tail == &m_stub) {
+			record_t*  result = new record_t();
+			result->level = next->level;
+			result->site = next->site;
+			result->suppressed = next->suppressed;
+			result->message = std::move(next->message);
+			return result;
+		}
+		tail->level = next->level;
+		tail->site = next->site;
+		tail->suppressed = next->suppressed;
+		tail->message = std::move(next->message);
+		return tail;
+	}
+
+	void  run() {
+		while (true) {
+			// Requests of flush, that are made before the draining, are completed by it
+			uint64_t  requested, target;
+			{
+				std::lock_guard<std::mutex>  flush_lock(m_flush_mutex);
+				requested = m_flush_requested;
+				target = m_flush_target;
+			}
+
+			size_t  n = 0;
+			bool  completed = false;
+			{
+				std::lock_guard<std::mutex>  lock(m_sink_mutex);
+				while (record_t*  record = this->pop()) {
+					this->write(*record);
+					delete record;
+					n++;
+				}
+				m_queued.fetch_sub(n, std::memory_order_relaxed);
+
+				// Records of other threads may be still in flight, so wait for all of pushed before the request
+				completed = (requested > m_flush_completed && m_written + n >= target);
+				const bool  reported = this->flush_repeats(completed || m_stop.load());
+				if (n || reported || completed) {
+					this->flush_sink();
+				}
+			}
+			if (n || completed) {
+				std::lock_guard<std::mutex>  lock(m_flush_mutex);
+				m_written += n;
+				if (completed)
+					m_flush_completed = requested;
+			}
+			m_flushed.notify_all();
+
+			if (m_stop.load() && !m_tail->next.load(std::memory_order_acquire))
+				break;
+			if (n)
+				continue;
+
+			m_waiting.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_tail->next.load(std::memory_order_acquire) || m_stop.load()) {
+				m_waiting.store(false);
+				continue;
+			}
+			// Wake up later to report pending repeats
+			int  timeout = -1;
+			for (auto&  it : m_repeats) {
+				if (it.second.count)
+					timeout = static_cast<int>(g_rate_interval.load(std::memory_order_relaxed) / 1000000) + 1;
+			}
+			struct pollfd  pfd = { m_wake_fd, POLLIN, 0 };
+			poll(&pfd, 1, timeout);
+			uint64_t  counter;
+			(void)!::read(m_wake_fd, &counter, sizeof(counter));
+			m_waiting.store(false);
+		}
+	}
+
+	/**
+	 * Pass a record to the sink, collapsing repeats. Called with m_sink_mutex
+	 */
+	void  write(record_t&  record) {
+		if (record.site && g_rate_messages.load(std::memory_order_relaxed)) {
+			auto  it = m_repeats.find(record.site);
+			const int64_t  now = now_ns();
+			if (it != m_repeats.end()) {
+				repeat_t&  r = it->second;
+				if (r.message == record.message && now - r.since < g_rate_interval.load(std::memory_order_relaxed)) {
+					r.count += 1 + record.suppressed;
+					return;
+				}
+				this->report_repeats(r);
+				r.message = record.message;
+				r.level = record.level;
+				r.since = now;
+				r.count = 0;
+			} else {
+				m_repeats.emplace(record.site, repeat_t{ record.message, record.level, now, 0 });
+			}
+		}
+
+		if (record.suppressed) {
+			record.message += " (" + std::to_string(record.suppressed) + " similar messages suppressed)";
+		}
+		this->sink(record.level, record.message);
+	}
+
+	struct repeat_t {
+		std::string  message;
+		LogLevel  level;
+		int64_t  since;
+		uint32_t  count;
+	};
+
+	void  report_repeats(repeat_t&  r) {
+		if (r.count) {
+			this->sink(r.level, "message repeated " + std::to_string(r.count) + " times: " + r.message);
+			r.count = 0;
+		}
+	}
+
+	/**
+	 * Report repeats, that are over the interval (or all)
+	 * @return true if something is reported
+	 */
+	bool  flush_repeats(const bool  all = true) {
+		const int64_t  now = now_ns();
+		const int64_t  interval = g_rate_interval.load(std::memory_order_relaxed);
+		bool  reported = false;
+		for (auto  it = m_repeats.begin(); it != m_repeats.end(); ) {
+			if (all || now - it->second.since >= interval) {
+				reported = reported || it->second.count;
+				this->report_repeats(it->second);
+				it = m_repeats.erase(it);
+			} else {
+				++it;
+			}
+		}
+		return reported;
+	}
+
+	void  sink(const LogLevel  level, const std::string&  message) {
+		if (m_sink) {
+			try {
+				m_sink(level, message);
+			} catch (...) {
+				// A failing sink must not kill the logger
+			}
+		} else {
+			default_sink(level, message);
+		}
+	}
+
+	void  flush_sink() {
+		if (!m_sink)
+			flush_default_sink();
+	}
+
+public:
+	static logger&  get() {
+		// Never destroyed: messages may be logged by destructors of other static objects
+		static logger*  instance = new logger();
+		return *instance;
+	}
+
+private:
+	record_t  m_stub;
+	std::atomic<record_t*>  m_head; ///< The last pushed record
+	record_t*  m_tail; ///< The stub record before the next one to pop. Used only by the consumer
+	std::atomic<size_t>  m_queued;
+	std::atomic<uint64_t>  m_pushed;
+
+	std::mutex  m_flush_mutex;
+	std::condition_variable  m_flushed;
+	uint64_t  m_written;
+	uint64_t  m_flush_target = 0; ///< Number of records pushed before the last request of flush
+	uint64_t  m_flush_requested = 0;
+	uint64_t  m_flush_completed = 0;
+
+	std::mutex  m_sink_mutex;
+	log_sink_t  m_sink;
+	std::unordered_map<log_site*, repeat_t>  m_repeats; ///< The last message of each site
+
+	std::atomic<bool>  m_waiting;
+	std::atomic<bool>  m_running;
+	std::atomic<bool>  m_stop;
+	std::once_flag  m_start_flag;
+	int32_t  m_wake_fd;
+	std::thread  m_thread;
+};
+
+
+void  log_message(const LogLevel  level, log_site*  site, std::string  message) {
+	logger::get().push(level, site, std::move(message));
+}
+
+
+void  set_log_level(const LogLevel  level) {
+	g_log_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel  get_log_level() {
+	return static_cast<LogLevel>(g_log_level.load(std::memory_order_relaxed));
+}
+
+
+void  set_log_sink(log_sink_t  sink) {
+	logger::get().flush();
+	logger::get().set_sink(std::move(sink));
+}
+
+
+void  set_log_rate_limit(const uint32_t  messages, const std::chrono::milliseconds  interval) {
+	g_rate_messages.store(messages, std::memory_order_relaxed);
+	g_rate_interval.store(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count(), std::memory_order_relaxed);
+}
+
+
+void  flush_log() {
+	logger::get().flush();
+}
+
+
+uint64_t  get_log_dropped() {
+	return g_dropped.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "ipc-util.hpp"
+#include "mark-index.hpp"
+
+namespace i3ipc {
+
+mark_index::mark_index(connection&  conn) : m_conn(conn) {
+	if (!conn.subscribe(ET_WINDOW)) {
+		throw ipc_error("Failed to subscribe to window events");
+	}
+	m_window_connection = conn.signal_window_event.connect([this](const window_event_t&  ev) {
+		this->on_window_event(ev);
+	});
+	this->reseed();
+}
+
+mark_index::~mark_index() {
+	m_window_connection.disconnect();
+}
+
+
+void  mark_index::reseed() {
+	m_containers.clear();
+	m_marks.clear();
+	auto  root = m_conn.get_tree();
+	if (root) {
+		this->seed(*root);
+	}
+}
+
+
+void  mark_index::seed(const container_t&  node) {
+	if (!node.marks.empty()) {
+		this->set_marks(node.id, node.marks);
+	}
+	for (auto&  lst : { &node.nodes, &node.floating_nodes }) {
+		for (auto&  n : *lst) {
+			if (n)
+				this->seed(*n);
+		}
+	}
+}
+
+
+void  mark_index::on_window_event(const window_event_t&  ev) {
+	if (!ev.container)
+		return;
+	switch (ev.type) {
+	case WindowEventType::MARK:
+		this->set_marks(ev.container->id, ev.container->marks);
+		break;
+	case WindowEventType::CLOSE:
+		this->forget_container(ev.container->id);
+		break;
+	default:
+		break;
+	}
+}
+
+
+void  mark_index::set_marks(const uint64_t  id, const std::vector<std::string>&  marks) {
+	this->forget_container(id);
+	if (marks.empty())
+		return;
+	for (auto&  mark : marks) {
+		auto  it = m_containers.find(mark);
+		if (it != m_containers.end()) {
+			// The mark has been moved from another container
+			auto  owner = m_marks.find(it->second);
+			if (owner != m_marks.end()) {
+				auto&  owner_marks = owner->second;
+				owner_marks.erase(std::remove(owner_marks.begin(), owner_marks.end(), mark), owner_marks.end());
+				if (owner_marks.empty())
+					m_marks.erase(owner);
+			}
+			it->second = id;
+		} else {
+			m_containers.emplace(mark, id);
+		}
+	}
+	m_marks[id] = marks;
+}
+
+
+void  mark_index::forget_container(const uint64_t  id) {
+	auto  it = m_marks.find(id);
+	if (it == m_marks.end())
+		return;
+	for (auto&  mark : it->second) {
+		m_containers.erase(mark);
+	}
+	m_marks.erase(it);
+}
+
+
+uint64_t  mark_index::find(const std::string&  mark) const {
+	auto  it = m_containers.find(mark);
+	return it == m_containers.end() ? 0 : it->second;
+}
+
+
+const std::vector<std::string>&  mark_index::marks(const uint64_t  id) const {
+	static const std::vector<std::string>  empty;
+	auto  it = m_marks.find(id);
+	return it == m_marks.end() ? empty : it->second;
+}
+
+}
@@ -0,0 +1,234 @@
+#include <json/json.h>
+
+#include <auss.hpp>
+
+#include "metrics.hpp"
+
+namespace i3ipc {
+
+static const char*  g_request_names[] = {
+	"COMMAND",
+	"GET_WORKSPACES",
+	"SUBSCRIBE",
+	"GET_OUTPUTS",
+	"GET_TREE",
+	"GET_MARKS",
+	"GET_BAR_CONFIG",
+	"GET_VERSION",
+	"GET_BINDING_MODES",
+	"GET_CONFIG",
+	"SEND_TICK",
+	"SYNC",
+};
+
+static const char*  g_event_names[] = {
+	"workspace",
+	"output",
+	"mode",
+	"window",
+	"barconfig_update",
+	"binding",
+	"shutdown",
+	"tick",
+};
+
+static const char*  g_error_names[] = {
+	"errno_error",
+	"eof_error",
+	"invalid_header_error",
+	"invalid_reply_payload_error",
+};
+
+template<size_t  N>
+static std::string  name_of(const char* (&names)[N], const size_t  i) {
+	if (i < N)
+		return names[i];
+	return std::to_string(i);
+}
+
+
+metrics_registry::metrics_registry() : m_enabled(true) {
+	this->reset();
+}
+
+
+void  metrics_registry::on_send(const size_t  bytes) {
+	if (!this->enabled())
+		return;
+	m_frames_sent.fetch_add(1, std::memory_order_relaxed);
+	m_bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void  metrics_registry::on_receive(const uint32_t  type, const size_t  bytes) {
+	if (!this->enabled())
+		return;
+	m_frames_received.fetch_add(1, std::memory_order_relaxed);
+	m_bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+	if (type & 0x80000000) {
+		const uint32_t  event = type & 0x7f;
+		if (event < MAX_EVENT_TYPES)
+			m_events[event].fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+void  metrics_registry::on_reply(const uint32_t  type, const clock::duration  latency) {
+	if (!this->enabled() || type >= MAX_REQUEST_TYPES)
+		return;
+	m_requests[type].fetch_add(1, std::memory_order_relaxed);
+	m_request_latency[type].record(latency);
+}
+
+
+void  metrics_registry::on_parse(const clock::duration  duration) {
+	if (!this->enabled())
+		return;
+	m_parse_time.record(duration);
+}
+
+
+void  metrics_registry::on_error(const ErrorClass  error_class) {
+	if (!this->enabled())
+		return;
+	m_errors[static_cast<size_t>(error_class)].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+metrics_snapshot_t  metrics_registry::snapshot() const {
+	metrics_snapshot_t  s;
+	s.period = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch() - clock::duration(m_since.load(std::memory_order_relaxed)));
+	s.frames_sent = m_frames_sent.load(std::memory_order_relaxed);
+	s.frames_received = m_frames_received.load(std::memory_order_relaxed);
+	s.bytes_sent = m_bytes_sent.load(std::memory_order_relaxed);
+	s.bytes_received = m_bytes_received.load(std::memory_order_relaxed);
+	for (size_t  i = 0; i < MAX_REQUEST_TYPES; i++) {
+		const uint64_t  count = m_requests[i].load(std::memory_order_relaxed);
+		if (count > 0) {
+			s.requests[message_type_name(i)] = { count, m_request_latency[i].snapshot() };
+		}
+	}
+	for (size_t  i = 0; i < MAX_EVENT_TYPES; i++) {
+		const uint64_t  count = m_events[i].load(std::memory_order_relaxed);
+		if (count > 0) {
+			s.events[message_type_name(0x80000000 | i)] = count;
+		}
+	}
+	for (size_t  i = 0; i < MAX_ERROR_CLASSES; i++) {
+		const uint64_t  count = m_errors[i].load(std::memory_order_relaxed);
+		if (count > 0) {
+			s.errors[name_of(g_error_names, i)] = count;
+		}
+	}
+	s.parse_time = m_parse_time.snapshot();
+	return s;
+}
+
+
+void  metrics_registry::reset() {
+	m_since.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+	m_frames_sent.store(0, std::memory_order_relaxed);
+	m_frames_received.store(0, std::memory_order_relaxed);
+	m_bytes_sent.store(0, std::memory_order_relaxed);
+	m_bytes_received.store(0, std::memory_order_relaxed);
+	for (size_t  i = 0; i < MAX_REQUEST_TYPES; i++) {
+		m_requests[i].store(0, std::memory_order_relaxed);
+		m_request_latency[i].reset();
+	}
+	for (auto&  counter : m_events) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+	for (auto&  counter : m_errors) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+	m_parse_time.reset();
+}
+
+
+static const double  g_quantiles[] = { 0.5, 0.9, 0.99, 1.0 };
+
+static void  format_summary(auss_t&  out, const std::string&  name, const std::string&  labels, const histogram_snapshot_t&  h) {
+	const std::string  sep = labels.empty() ? "" : ",";
+	for (double  q : g_quantiles) {
+		out << name << '{' << labels << sep << "quantile=\"" << q << "\"} " << h.percentile(q) << '\n';
+	}
+	out << name << "_sum" << (labels.empty() ? "" : "{" + labels + "}") << ' ' << h.sum << '\n';
+	out << name << "_count" << (labels.empty() ? "" : "{" + labels + "}") << ' ' << h.count << '\n';
+}
+
+std::string  metrics_snapshot_t::to_text(const std::string&  prefix) const {
+	auss_t  out;
+	out << prefix << "frames_sent_total " << frames_sent << '\n';
+	out << prefix << "frames_received_total " << frames_received << '\n';
+	out << prefix << "bytes_sent_total " << bytes_sent << '\n';
+	out << prefix << "bytes_received_total " << bytes_received << '\n';
+	for (auto&  it : requests) {
+		out << prefix << "requests_total{type=\"" << it.first << "\"} " << it.second.count << '\n';
+		format_summary(out, prefix + "request_latency_ns", "type=\"" + it.first + "\"", it.second.latency);
+	}
+	for (auto&  it : events) {
+		out << prefix << "events_total{type=\"" << it.first << "\"} " << it.second << '\n';
+	}
+	for (auto&  it : errors) {
+		out << prefix << "errors_total{class=\"" << it.first << "\"} " << it.second << '\n';
+	}
+	format_summary(out, prefix + "parse_time_ns", "", parse_time);
+	return out;
+}
+
+
+static Json::Value  histogram_to_json(const histogram_snapshot_t&  h) {
+	Json::Value  v(Json::objectValue);
+	v["count"] = Json::UInt64(h.count);
+	v["sum"] = Json::UInt64(h.sum);
+	v["min"] = Json::UInt64(h.min);
+	v["max"] = Json::UInt64(h.max);
+	v["mean"] = h.mean();
+	v["p50"] = Json::UInt64(h.percentile(0.5));
+	v["p90"] = Json::UInt64(h.percentile(0.9));
+	v["p99"] = Json::UInt64(h.percentile(0.99));
+	return v;
+}
+
+std::string  metrics_snapshot_t::to_json() const {
+	Json::Value  root(Json::objectValue);
+	root["period_ns"] = Json::Int64(period.count());
+	root["frames_sent"] = Json::UInt64(frames_sent);
+	root["frames_received"] = Json::UInt64(frames_received);
+	root["bytes_sent"] = Json::UInt64(bytes_sent);
+	root["bytes_received"] = Json::UInt64(bytes_received);
+
+	Json::Value&  requests_json = root["requests"] = Json::Value(Json::objectValue);
+	for (auto&  it : requests) {
+		requests_json[it.first]["count"] = Json::UInt64(it.second.count);
+		requests_json[it.first]["latency_ns"] = histogram_to_json(it.second.latency);
+	}
+	Json::Value&  events_json = root["events"] = Json::Value(Json::objectValue);
+	for (auto&  it : events) {
+		events_json[it.first] = Json::UInt64(it.second);
+	}
+	Json::Value&  errors_json = root["errors"] = Json::Value(Json::objectValue);
+	for (auto&  it : errors) {
+		errors_json[it.first] = Json::UInt64(it.second);
+	}
+	root["parse_time_ns"] = histogram_to_json(parse_time);
+
+	Json::StreamWriterBuilder  builder;
+	builder["indentation"] = "";
+	return Json::writeString(builder, root);
+}
+
+
+metrics_registry&  get_metrics() {
+	static metrics_registry  registry;
+	return registry;
+}
+
+
+std::string  message_type_name(const uint32_t  type) {
+	if (type & 0x80000000)
+		return name_of(g_event_names, type & 0x7f);
+	return name_of(g_request_names, type);
+}
+
+}
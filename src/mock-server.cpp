@@ -0,0 +1,441 @@
+extern "C" {
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+}
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <auss.hpp>
+
+#include "log.hpp"
+#include "mock-server.hpp"
+
+namespace i3ipc {
+
+/// Don't queue more events to a client, which has so many unwritten bytes
+static const size_t  g_max_client_backlog = 1 << 20;
+
+static const std::string  g_default_tree = "{\"id\":1,\"name\":\"root\",\"type\":\"root\",\"border\":\"normal\",\"current_border_width\":0,"
+	"\"layout\":\"splith\",\"percent\":null,\"rect\":{\"x\":0,\"y\":0,\"width\":1920,\"height\":1080},"
+	"\"window_rect\":{\"x\":0,\"y\":0,\"width\":0,\"height\":0},\"deco_rect\":{\"x\":0,\"y\":0,\"width\":0,\"height\":0},"
+	"\"geometry\":{\"x\":0,\"y\":0,\"width\":0,\"height\":0},\"window\":null,\"urgent\":false,\"focused\":false,"
+	"\"focus\":[],\"nodes\":[],\"floating_nodes\":[]}";
+
+
+int32_t  parse_subscription_payload(const std::string_view  payload) {
+	static const std::pair<const char*, EventType>  names[] = {
+		{ "\"workspace\"", ET_WORKSPACE },
+		{ "\"output\"", ET_OUTPUT },
+		{ "\"mode\"", ET_MODE },
+		{ "\"window\"", ET_WINDOW },
+		{ "\"barconfig_update\"", ET_BARCONFIG_UPDATE },
+		{ "\"binding\"", ET_BINDING },
+		{ "\"shutdown\"", ET_SHUTDOWN },
+		{ "\"tick\"", ET_TICK },
+	};
+	int32_t  events = 0;
+	for (auto&  name : names) {
+		if (payload.find(name.first) != std::string_view::npos)
+			events |= name.second;
+	}
+	return events;
+}
+
+
+static std::string  json_escape(const std::string&  s) {
+	auss_t  out;
+	out << '"';
+	for (char  c : s) {
+		switch (c) {
+		case '"': out << "\\\""; break;
+		case '\\': out << "\\\\"; break;
+		case '\n': out << "\\n"; break;
+		case '\t': out << "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char  code[8];
+				snprintf(code, sizeof(code), "\\u%04x", c);
+				out << code;
+			} else {
+				out << c;
+			}
+		}
+	}
+	out << '"';
+	return out;
+}
+
+
+/**
+ * Get the type in the i3 IPC header of an event
+ */
+static uint32_t  event_message_type(const EventType  type) {
+	return 0x80000000 | static_cast<uint32_t>(__builtin_ctz(static_cast<uint32_t>(type)));
+}
+
+
+static void  append_frame(std::vector<uint8_t>&  out, const uint32_t  type, const std::string&  payload) {
+	header_t  header;
+	memcpy(header.magic, "i3-ipc", sizeof(header.magic));
+	header.size = payload.size();
+	header.type = type;
+	const uint8_t*  h = reinterpret_cast<const uint8_t*>(&header);
+	out.insert(out.end(), h, h + sizeof(header));
+	out.insert(out.end(), payload.begin(), payload.end());
+}
+
+
+mock_server::mock_server() :
+	m_listen_fd(-1),
+	m_wake_fd(-1),
+	m_busy(false),
+	m_sent_events(0),
+	m_clients_count(0),
+	m_stop(false)
+{
+	for (auto&  counter : m_requests) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+
+	const char*  tmpdir = getenv("TMPDIR");
+	std::string  dir_template = std::string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/i3ipc++-mock-XXXXXX";
+	std::vector<char>  dir(dir_template.begin(), dir_template.end());
+	dir.push_back('\0');
+	if (!mkdtemp(dir.data())) {
+		throw errno_error("Failed to create a directory for the mock socket");
+	}
+	m_dir = dir.data();
+	m_socket_path = m_dir + "/ipc.sock";
+
+	m_listen_fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (m_listen_fd == -1) {
+		rmdir(m_dir.c_str());
+		throw errno_error("Could not create a socket");
+	}
+	struct sockaddr_un  addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_LOCAL;
+	strncpy(addr.sun_path, m_socket_path.c_str(), sizeof(addr.sun_path) - 1);
+	if (bind(m_listen_fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == -1 || listen(m_listen_fd, 16) == -1) {
+		close(m_listen_fd);
+		rmdir(m_dir.c_str());
+		throw errno_error("Failed to listen on " + m_socket_path);
+	}
+
+	m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_wake_fd == -1) {
+		close(m_listen_fd);
+		unlink(m_socket_path.c_str());
+		rmdir(m_dir.c_str());
+		throw errno_error("Failed to create an eventfd");
+	}
+
+	m_thread = std::thread(&mock_server::run, this);
+}
+
+mock_server::~mock_server() {
+	m_stop.store(true);
+	this->wake();
+	m_thread.join();
+	for (auto&  client : m_clients) {
+		close(client.fd);
+	}
+	close(m_wake_fd);
+	close(m_listen_fd);
+	unlink(m_socket_path.c_str());
+	rmdir(m_dir.c_str());
+}
+
+
+void  mock_server::set_reply(const ClientMessageType  type, const std::string&  payload) {
+	std::lock_guard<std::mutex>  lock(m_mutex);
+	m_replies[static_cast<uint32_t>(type)] = payload;
+}
+
+
+void  mock_server::set_handler(const ClientMessageType  type, handler_t  handler) {
+	std::lock_guard<std::mutex>  lock(m_mutex);
+	m_handlers[static_cast<uint32_t>(type)] = std::move(handler);
+}
+
+
+void  mock_server::send_event(const EventType  type, const std::string&  payload) {
+	this->send_events(type, { payload }, 0);
+}
+
+
+void  mock_server::send_events(const EventType  type, const std::vector<std::string>&  payloads, const double  rate) {
+	const clock::time_point  now = clock::now();
+	{
+		std::lock_guard<std::mutex>  lock(m_mutex);
+		clock::time_point  due = now;
+		if (!m_events.empty() && m_events.back().due > due) {
+			due = m_events.back().due; // A stream after a stream
+		}
+		const clock::time_point  start = due;
+		for (size_t  i = 0; i < payloads.size(); i++) {
+			if (rate > 0) {
+				due = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(i / rate));
+			}
+			m_events.push_back({ due, event_message_type(type), payloads[i] });
+		}
+		m_busy = true;
+	}
+	this->wake();
+}
+
+
+bool  mock_server::wait_idle(const std::chrono::milliseconds  timeout) {
+	std::unique_lock<std::mutex>  lock(m_mutex);
+	return m_idle.wait_for(lock, timeout, [this]() { return !m_busy; });
+}
+
+
+uint64_t  mock_server::requests(const ClientMessageType  type) const {
+	const uint32_t  i = static_cast<uint32_t>(type);
+	return i < 16 ? m_requests[i].load(std::memory_order_relaxed) : 0;
+}
+
+
+void  mock_server::wake() {
+	const uint64_t  one = 1;
+	(void)!write(m_wake_fd, &one, sizeof(one));
+}
+
+
+void  mock_server::broadcast(const uint32_t  type, const std::string&  payload, const int32_t  mask) {
+	for (auto&  client : m_clients) {
+		if (client.subscriptions & mask) {
+			append_frame(client.out, type, payload);
+			m_sent_events.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+
+std::string  mock_server::reply_to(client_t&  client, const uint32_t  type, const std::string&  payload) {
+	if (type < 16) {
+		m_requests[type].fetch_add(1, std::memory_order_relaxed);
+	}
+	if (type == static_cast<uint32_t>(ClientMessageType::SUBSCRIBE)) {
+		client.subscriptions |= parse_subscription_payload(payload);
+	}
+
+	handler_t  handler;
+	{
+		std::lock_guard<std::mutex>  lock(m_mutex);
+		auto  h = m_handlers.find(type);
+		if (h != m_handlers.end()) {
+			handler = h->second;
+		} else {
+			auto  r = m_replies.find(type);
+			if (r != m_replies.end())
+				return r->second;
+		}
+	}
+	if (handler) {
+		return handler(payload); // Without the lock, so the handler may reconfigure the server
+	}
+
+	switch (static_cast<ClientMessageType>(type)) {
+	case ClientMessageType::COMMAND:
+		return "[{\"success\":true}]";
+	case ClientMessageType::GET_TREE:
+		return g_default_tree;
+	case ClientMessageType::GET_VERSION:
+		return "{\"major\":4,\"minor\":22,\"patch\":0,\"human_readable\":\"4.22 (i3ipc++ mock)\",\"loaded_config_file_name\":\"\"}";
+	case ClientMessageType::GET_BINDING_MODES:
+		return "[\"default\"]";
+	case ClientMessageType::GET_CONFIG:
+		return "{\"config\":\"\"}";
+	case ClientMessageType::SUBSCRIBE:
+	case ClientMessageType::SEND_TICK:
+	case ClientMessageType::SYNC:
+		return "{\"success\":true}";
+	default:
+		return "[]";
+	}
+}
+
+
+void  mock_server::accept_client() {
+	int  fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (fd == -1) {
+		return;
+	}
+	m_clients.push_back({ fd, {}, {}, 0, 0 });
+	m_clients_count.store(m_clients.size(), std::memory_order_relaxed);
+}
+
+
+/**
+ * Read requests of a client and queue replies
+ * @return false if the client has gone
+ */
+bool  mock_server::read_client(client_t&  client) {
+	uint8_t  chunk[4096];
+	while (true) {
+		const ssize_t  n = read(client.fd, chunk, sizeof(chunk));
+		if (n == 0)
+			return false;
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return false;
+		}
+		client.in.insert(client.in.end(), chunk, chunk + n);
+	}
+
+	size_t  pos = 0;
+	while (client.in.size() - pos >= sizeof(header_t)) {
+		header_t  header;
+		memcpy(&header, client.in.data() + pos, sizeof(header));
+		if (memcmp(header.magic, "i3-ipc", sizeof(header.magic)) != 0) {
+			I3IPC_WARN("Mock server: invalid magic from a client")
+			return false;
+		}
+		if (client.in.size() - pos - sizeof(header) < header.size)
+			break;
+		const std::string  payload(reinterpret_cast<const char*>(client.in.data() + pos + sizeof(header)), header.size);
+		pos += sizeof(header) + header.size;
+
+		const int32_t  subscriptions = client.subscriptions;
+		append_frame(client.out, header.type, this->reply_to(client, header.type, payload));
+
+		if (header.type == static_cast<uint32_t>(ClientMessageType::SUBSCRIBE) && (client.subscriptions & ~subscriptions & ET_TICK)) {
+			append_frame(client.out, event_message_type(ET_TICK), "{\"first\":true,\"payload\":\"\"}");
+			m_sent_events.fetch_add(1, std::memory_order_relaxed);
+		} else if (header.type == static_cast<uint32_t>(ClientMessageType::SEND_TICK)) {
+			this->broadcast(event_message_type(ET_TICK), "{\"first\":false,\"payload\":" + json_escape(payload) + "}", ET_TICK);
+		}
+	}
+	client.in.erase(client.in.begin(), client.in.begin() + pos);
+	return true;
+}
+
+
+/**
+ * Write queued data of a client
+ * @return false if the client has gone
+ */
+bool  mock_server::write_client(client_t&  client) {
+	while (client.out_pos < client.out.size()) {
+		const ssize_t  n = send(client.fd, client.out.data() + client.out_pos, client.out.size() - client.out_pos, MSG_NOSIGNAL);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return false;
+		}
+		client.out_pos += n;
+	}
+	if (client.out_pos == client.out.size()) {
+		client.out.clear();
+		client.out_pos = 0;
+	}
+	return true;
+}
+
+
+void  mock_server::run() {
+	std::vector<struct pollfd>  fds;
+	while (!m_stop.load()) {
+		struct timespec  timeout_ts;
+		struct timespec*  timeout = nullptr;
+		{
+			std::lock_guard<std::mutex>  lock(m_mutex);
+			size_t  backlog = 0;
+			for (auto&  client : m_clients) {
+				backlog = std::max(backlog, client.out.size() - client.out_pos);
+			}
+
+			const clock::time_point  now = clock::now();
+			while (!m_events.empty() && m_events.front().due <= now && backlog < g_max_client_backlog) {
+				const pending_event_t&  ev = m_events.front();
+				this->broadcast(ev.type, ev.payload, 1 << (ev.type & 0x7f));
+				m_events.pop_front();
+				for (auto&  client : m_clients) {
+					backlog = std::max(backlog, client.out.size() - client.out_pos);
+				}
+			}
+
+			// Write before reporting idle
+			backlog = 0;
+			for (auto&  client : m_clients) {
+				this->write_client(client);
+				backlog = std::max(backlog, client.out.size() - client.out_pos);
+			}
+
+			// The backlog may have been written right away: then the next events are to be sent without waiting for POLLOUT
+			if (!m_events.empty() && backlog < g_max_client_backlog) {
+				const auto  left = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(m_events.front().due - now).count());
+				timeout_ts.tv_sec = left / 1000000000;
+				timeout_ts.tv_nsec = left % 1000000000;
+				timeout = &timeout_ts;
+			}
+			bool  busy = !m_events.empty();
+			for (auto&  client : m_clients) {
+				busy = busy || client.out_pos < client.out.size();
+			}
+			m_busy = busy;
+			if (!busy) {
+				m_idle.notify_all();
+			}
+		}
+
+		fds.clear();
+		fds.push_back({ m_wake_fd, POLLIN, 0 });
+		fds.push_back({ m_listen_fd, POLLIN, 0 });
+		for (auto&  client : m_clients) {
+			fds.push_back({ client.fd, static_cast<short>(POLLIN | (client.out_pos < client.out.size() ? POLLOUT : 0)), 0 });
+		}
+		if (ppoll(fds.data(), fds.size(), timeout, nullptr) == -1) {
+			if (errno == EINTR)
+				continue;
+			I3IPC_ERR("Mock server: poll failed: " << strerror(errno))
+			return;
+		}
+
+		if (fds[0].revents) {
+			uint64_t  counter;
+			(void)!read(m_wake_fd, &counter, sizeof(counter));
+		}
+
+		// Clients, that are accepted now, are not in fds
+		const size_t  polled = fds.size() - 2;
+		std::vector<bool>  gone(polled, false);
+		for (size_t  i = 0; i < polled; i++) {
+			const short  revents = fds[i + 2].revents;
+			if (revents & (POLLIN | POLLHUP | POLLERR)) {
+				gone[i] = !this->read_client(m_clients[i]);
+			}
+			if (!gone[i] && (revents & POLLOUT)) {
+				gone[i] = !this->write_client(m_clients[i]);
+			}
+		}
+		for (size_t  i = polled; i-- > 0;) {
+			if (gone[i]) {
+				close(m_clients[i].fd);
+				m_clients.erase(m_clients.begin() + i);
+			}
+		}
+		m_clients_count.store(m_clients.size(), std::memory_order_relaxed);
+
+		if (fds[1].revents & POLLIN) {
+			this->accept_client();
+		}
+	}
+}
+
+}
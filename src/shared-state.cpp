@@ -0,0 +1,661 @@
+extern "C" {
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include <auss.hpp>
+
+#include "log.hpp"
+#include "ipc-util.hpp"
+#include "shared-state.hpp"
+
+namespace i3ipc {
+
+static const char  g_magic[8] = { 'i', '3', 'i', 'p', 'c', 's', 't', '\0' };
+static const uint32_t  LAYOUT_VERSION = 2;
+static const size_t  INITIAL_CAPACITY = 256 * 1024;
+static const uint32_t  WRITER_CHECK_INTERVAL = 1024; ///< Failed reads, after which state_reader::read() checks, that the publisher is alive
+static const std::chrono::seconds  READ_TIMEOUT(1); ///< Max time of state_reader::read() with a live publisher
+
+/**
+ * Header of the segment. It is followed by the snapshot:
+ * offsets of the tree, workspaces and outputs sections (3 x uint64_t, from the start of the snapshot) and
+ * the sections. Integers are in the native byte order, strings are a uint32_t length and bytes, the tree is
+ * in preorder (a container is followed by its tiling and floating children, preceded by their counts)
+ */
+struct shared_state_header_t {
+	char  magic[8];
+	uint32_t  version; ///< LAYOUT_VERSION
+	std::atomic<uint32_t>  sequence; ///< Seqlock and futex word: odd while the snapshot is being written
+	std::atomic<uint32_t>  closed; ///< The publisher is gone
+	uint32_t  reserved;
+	std::atomic<uint64_t>  capacity; ///< Size of the segment
+	std::atomic<uint64_t>  size; ///< Size of the snapshot
+};
+static_assert(std::is_standard_layout<shared_state_header_t>::value, "The header must have a stable layout");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free, "The futex word must be a plain uint32_t");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+
+static const size_t  SNAPSHOT_OFFSET = sizeof(shared_state_header_t);
+
+
+static shared_state_header_t*  get_header(uint8_t*  data) {
+	return reinterpret_cast<shared_state_header_t*>(data);
+}
+
+static long  futex(std::atomic<uint32_t>*  word, const int  op, const uint32_t  value, const struct timespec*  timeout) {
+	return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+static size_t  round_up_page(const size_t  n) {
+	const size_t  page = sysconf(_SC_PAGESIZE);
+	return (n + page - 1) / page * page;
+}
+
+
+std::string  get_shared_state_name() {
+	return "/i3ipc-state-" + std::to_string(getuid());
+}
+
+
+/**
+ * Check, that a segment is private to the user: the name is predictable, so another user may have created it
+ * to read window titles or to feed forged snapshots
+ * @return size of the segment
+ */
+static size_t  check_segment(const int32_t  fd, const std::string&  name) {
+	struct stat  st;
+	if (fstat(fd, &st) == -1) {
+		throw errno_error(auss_t() << "Failed to stat shared memory \"" << name << '"');
+	}
+	if (st.st_uid != getuid() || (st.st_mode & 07777) != 0600) {
+		throw ipc_error(auss_t() << "Shared memory \"" << name << "\" isn't private to the user (owner " << st.st_uid << ", mode 0"
+			<< std::oct << (st.st_mode & 07777) << "), refusing to use it");
+	}
+	return st.st_size;
+}
+
+
+/**
+ * Encoder of the snapshot
+ */
+class snapshot_writer {
+public:
+	explicit snapshot_writer(std::vector<uint8_t>&  out) : m_out(out) {}
+
+	template<typename T>
+	void  put(const T  value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivial values are written as is");
+		const uint8_t*  p = reinterpret_cast<const uint8_t*>(&value);
+		m_out.insert(m_out.end(), p, p + sizeof(T));
+	}
+
+	void  put_bool(const bool  value) {
+		this->put<uint8_t>(value ? 1 : 0);
+	}
+
+	void  put_string(const std::string&  s) {
+		this->put<uint32_t>(s.size());
+		m_out.insert(m_out.end(), s.begin(), s.end());
+	}
+
+	void  put_rect(const rect_t&  r) {
+		this->put(r.x);
+		this->put(r.y);
+		this->put(r.width);
+		this->put(r.height);
+	}
+
+	void  put_container(const container_t&  c) {
+		this->put(c.id);
+		this->put(c.xwindow_id);
+		this->put_string(c.name);
+		this->put_string(c.type);
+		this->put(static_cast<char>(c.border));
+		this->put_string(c.border_raw);
+		this->put(c.current_border_width);
+		this->put(static_cast<char>(c.layout));
+		this->put_string(c.layout_raw);
+		this->put(c.percent);
+		this->put_rect(c.rect);
+		this->put_rect(c.window_rect);
+		this->put_rect(c.deco_rect);
+		this->put_rect(c.geometry);
+		this->put_bool(c.urgent);
+		this->put_bool(c.focused);
+		this->put_bool(c.workspace.has_value());
+		this->put_string(c.workspace ? *c.workspace : std::string());
+
+		this->put_string(c.window_properties.xclass);
+		this->put_string(c.window_properties.instance);
+		this->put_string(c.window_properties.window_role);
+		this->put_string(c.window_properties.title);
+		this->put(c.window_properties.transient_for);
+
+		this->put<uint32_t>(c.focus.size());
+		for (uint64_t  id : c.focus) {
+			this->put(id);
+		}
+		this->put<uint32_t>(c.marks.size());
+		for (auto&  mark : c.marks) {
+			this->put_string(mark);
+		}
+		this->put<uint32_t>(c.map.size());
+		for (auto&  kv : c.map) {
+			this->put_string(kv.first);
+			this->put_string(kv.second);
+		}
+
+		for (auto&  lst : { &c.nodes, &c.floating_nodes }) {
+			uint32_t  count = 0;
+			for (auto&  n : *lst) {
+				count += (n != nullptr);
+			}
+			this->put(count);
+			for (auto&  n : *lst) {
+				if (n)
+					this->put_container(*n);
+			}
+		}
+	}
+
+	size_t  offset() const { return m_out.size(); }
+
+	void  patch(const size_t  at, const uint64_t  value) {
+		std::memcpy(m_out.data() + at, &value, sizeof(value));
+	}
+
+private:
+	std::vector<uint8_t>&  m_out;
+};
+
+
+/**
+ * Decoder of the snapshot. Every read is bounds checked, so a broken snapshot can't make it read out of the copy
+ */
+class snapshot_reader {
+public:
+	snapshot_reader(const uint8_t*  data, const size_t  size) : m_begin(data), m_p(data), m_end(data + size) {}
+
+	template<typename T>
+	T  get() {
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivial values are read as is");
+		this->require(sizeof(T));
+		T  value;
+		std::memcpy(&value, m_p, sizeof(T));
+		m_p += sizeof(T);
+		return value;
+	}
+
+	bool  get_bool() {
+		return this->get<uint8_t>() != 0;
+	}
+
+	std::string  get_string() {
+		const uint32_t  size = this->get<uint32_t>();
+		this->require(size);
+		std::string  s(reinterpret_cast<const char*>(m_p), size);
+		m_p += size;
+		return s;
+	}
+
+	rect_t  get_rect() {
+		rect_t  r;
+		r.x = this->get<int32_t>();
+		r.y = this->get<int32_t>();
+		r.width = this->get<uint32_t>();
+		r.height = this->get<uint32_t>();
+		return r;
+	}
+
+	std::shared_ptr<container_t>  get_container() {
+		auto  c = std::make_shared<container_t>();
+		c->id = this->get<uint64_t>();
+		c->xwindow_id = this->get<uint64_t>();
+		c->name = this->get_string();
+		c->type = this->get_string();
+		c->border = static_cast<BorderStyle>(this->get<char>());
+		c->border_raw = this->get_string();
+		c->current_border_width = this->get<uint32_t>();
+		c->layout = static_cast<ContainerLayout>(this->get<char>());
+		c->layout_raw = this->get_string();
+		c->percent = this->get<float>();
+		c->rect = this->get_rect();
+		c->window_rect = this->get_rect();
+		c->deco_rect = this->get_rect();
+		c->geometry = this->get_rect();
+		c->urgent = this->get_bool();
+		c->focused = this->get_bool();
+		const bool  has_workspace = this->get_bool();
+		std::string  workspace = this->get_string();
+		if (has_workspace)
+			c->workspace = std::move(workspace);
+
+		c->window_properties.xclass = this->get_string();
+		c->window_properties.instance = this->get_string();
+		c->window_properties.window_role = this->get_string();
+		c->window_properties.title = this->get_string();
+		c->window_properties.transient_for = this->get<uint64_t>();
+
+		uint32_t  count = this->get<uint32_t>();
+		c->focus.reserve(this->at_most(count, sizeof(uint64_t)));
+		for (uint32_t  i = 0; i < count; i++) {
+			c->focus.push_back(this->get<uint64_t>());
+		}
+		count = this->get<uint32_t>();
+		c->marks.reserve(this->at_most(count, sizeof(uint32_t)));
+		for (uint32_t  i = 0; i < count; i++) {
+			c->marks.push_back(this->get_string());
+		}
+		count = this->get<uint32_t>();
+		for (uint32_t  i = 0; i < count; i++) {
+			std::string  key = this->get_string();
+			c->map[std::move(key)] = this->get_string();
+		}
+
+		for (auto  lst : { &c->nodes, &c->floating_nodes }) {
+			count = this->get<uint32_t>();
+			for (uint32_t  i = 0; i < count; i++) {
+				lst->push_back(this->get_container());
+			}
+		}
+		return c;
+	}
+
+	/**
+	 * Move to an offset from the start of the snapshot
+	 */
+	void  seek(const uint64_t  offset) {
+		if (offset > size_t(m_end - m_begin))
+			throw ipc_error(auss_t() << "Broken shared state: offset " << offset << " is out of the snapshot");
+		m_p = m_begin + offset;
+	}
+
+	/**
+	 * Limit a count of items (each one of at least item_size bytes) to what the rest of the snapshot can hold
+	 */
+	size_t  at_most(const uint32_t  count, const size_t  item_size) const {
+		return std::min<size_t>(count, (m_end - m_p) / item_size);
+	}
+
+private:
+	void  require(const size_t  n) const {
+		if (size_t(m_end - m_p) < n)
+			throw ipc_error("Broken shared state: unexpected end of the snapshot");
+	}
+
+	const uint8_t*  m_begin;
+	const uint8_t*  m_p;
+	const uint8_t*  m_end;
+};
+
+
+state_publisher::state_publisher(connection&  conn, const std::string&  name) :
+	m_conn(conn),
+	m_name(name),
+	m_fd(-1),
+	m_data(nullptr),
+	m_capacity(0)
+{
+	m_fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (m_fd != -1) {
+		(void)!fchmod(m_fd, 0600); // Not narrowed by umask, so check_segment() accepts it
+	} else if (errno == EEXIST) {
+		m_fd = shm_open(m_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+	}
+	if (m_fd == -1) {
+		throw errno_error(auss_t() << "Failed to open shared memory \"" << m_name << '"');
+	}
+	try {
+		const size_t  size = check_segment(m_fd, m_name);
+		// A single writer: the lock is held until the segment is unlinked (or the process dies)
+		if (flock(m_fd, LOCK_EX | LOCK_NB) == -1) {
+			if (errno == EWOULDBLOCK)
+				throw ipc_error(auss_t() << "Shared memory \"" << m_name << "\" is published by another process");
+			throw errno_error(auss_t() << "Failed to lock shared memory \"" << m_name << '"');
+		}
+		// Never shrink a segment, that readers may have mapped
+		this->resize(round_up_page(std::max<size_t>(INITIAL_CAPACITY, size)));
+	} catch (...) {
+		close(m_fd);
+		throw;
+	}
+
+	// A segment, left by a crashed publisher, may have readers: keep its sequence going, so they see a change
+	auto  header = get_header(m_data);
+	uint32_t  sequence = 0;
+	if (std::memcmp(header->magic, g_magic, sizeof(g_magic)) == 0 && header->version == LAYOUT_VERSION) {
+		sequence = (header->sequence.load() + 1) & ~1u;
+	} else {
+		new (header) shared_state_header_t();
+		std::memcpy(header->magic, g_magic, sizeof(g_magic));
+		header->version = LAYOUT_VERSION;
+	}
+	header->sequence.store(sequence);
+	header->closed.store(0);
+	header->capacity.store(m_capacity);
+
+	m_window_connection = conn.signal_window_event.connect([this](const window_event_t&) {
+		this->publish();
+	});
+	m_workspace_connection = conn.signal_workspace_event.connect([this](const workspace_event_t&) {
+		this->publish();
+	});
+	m_output_connection = conn.signal_output_event.connect([this]() {
+		this->publish();
+	});
+	try {
+		if (!conn.subscribe(ET_WINDOW | ET_WORKSPACE | ET_OUTPUT)) {
+			throw ipc_error("Failed to subscribe to window, workspace and output events");
+		}
+		this->publish();
+	} catch (...) {
+		m_window_connection.disconnect();
+		m_workspace_connection.disconnect();
+		m_output_connection.disconnect();
+		munmap(m_data, m_capacity);
+		close(m_fd);
+		throw;
+	}
+}
+
+state_publisher::~state_publisher() {
+	m_window_connection.disconnect();
+	m_workspace_connection.disconnect();
+	m_output_connection.disconnect();
+
+	auto  header = get_header(m_data);
+	header->closed.store(1);
+	header->sequence.fetch_add(2, std::memory_order_release);
+	futex(&header->sequence, FUTEX_WAKE, INT_MAX, nullptr);
+
+	// Unlinked before the lock is released, so a new publisher doesn't take over a segment, that is going away
+	shm_unlink(m_name.c_str());
+	munmap(m_data, m_capacity);
+	close(m_fd);
+}
+
+
+void  state_publisher::resize(const size_t  capacity) {
+	if (ftruncate(m_fd, capacity) == -1) {
+		throw errno_error(auss_t() << "Failed to resize shared memory \"" << m_name << "\" to " << capacity << " bytes");
+	}
+	void*  data;
+	if (m_data) {
+		data = mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+	} else {
+		data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	}
+	if (data == MAP_FAILED) {
+		throw errno_error(auss_t() << "Failed to map shared memory \"" << m_name << '"');
+	}
+	m_data = static_cast<uint8_t*>(data);
+	m_capacity = capacity;
+}
+
+
+void  state_publisher::publish() {
+	auto  tree = m_conn.get_tree();
+	auto  workspaces = m_conn.get_workspaces();
+	auto  outputs = m_conn.get_outputs();
+
+	m_snapshot.clear();
+	snapshot_writer  writer(m_snapshot);
+	for (int  i = 0; i < 3; i++) {
+		writer.put<uint64_t>(0);
+	}
+
+	writer.patch(0, writer.offset());
+	writer.put_bool(tree != nullptr);
+	if (tree) {
+		writer.put_container(*tree);
+	}
+
+	writer.patch(sizeof(uint64_t), writer.offset());
+	writer.put<uint32_t>(workspaces.size());
+	for (auto&  ws : workspaces) {
+		writer.put(ws->id);
+		writer.put<int32_t>(ws->num);
+		writer.put_string(ws->name);
+		writer.put_bool(ws->visible);
+		writer.put_bool(ws->focused);
+		writer.put_bool(ws->urgent);
+		writer.put_rect(ws->rect);
+		writer.put_string(ws->output);
+	}
+
+	writer.patch(2 * sizeof(uint64_t), writer.offset());
+	writer.put<uint32_t>(outputs.size());
+	for (auto&  out : outputs) {
+		writer.put_string(out->name);
+		writer.put_bool(out->active);
+		writer.put_bool(out->primary);
+		writer.put_string(out->current_workspace);
+		writer.put_rect(out->rect);
+	}
+
+	if (SNAPSHOT_OFFSET + m_snapshot.size() > m_capacity) {
+		// Readers remap, when they see the new capacity
+		this->resize(round_up_page(std::max(2 * m_capacity, SNAPSHOT_OFFSET + m_snapshot.size())));
+		get_header(m_data)->capacity.store(m_capacity, std::memory_order_release);
+	}
+
+	auto  header = get_header(m_data);
+	const uint32_t  sequence = header->sequence.load(std::memory_order_relaxed);
+	header->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(m_data + SNAPSHOT_OFFSET, m_snapshot.data(), m_snapshot.size());
+	header->size.store(m_snapshot.size(), std::memory_order_relaxed);
+	header->sequence.store(sequence + 2, std::memory_order_release);
+	futex(&header->sequence, FUTEX_WAKE, INT_MAX, nullptr);
+	I3IPC_DEBUG("Published shared state " << sequence + 2 << " (" << m_snapshot.size() << " bytes)")
+}
+
+
+uint32_t  state_publisher::sequence() const {
+	return get_header(m_data)->sequence.load();
+}
+
+
+state_reader::state_reader(const std::string&  name) :
+	m_name(name),
+	m_fd(-1),
+	m_data(nullptr),
+	m_mapped(0)
+{
+	m_fd = shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+	if (m_fd == -1) {
+		throw errno_error(auss_t() << "Failed to open shared memory \"" << m_name << '"');
+	}
+	try {
+		const size_t  size = check_segment(m_fd, m_name);
+		if (size < SNAPSHOT_OFFSET) {
+			throw ipc_error(auss_t() << "Shared memory \"" << m_name << "\" is too small for a state");
+		}
+		this->map(size);
+		auto  header = get_header(m_data);
+		if (std::memcmp(header->magic, g_magic, sizeof(g_magic)) != 0 || header->version != LAYOUT_VERSION) {
+			throw ipc_error(auss_t() << "Shared memory \"" << m_name << "\" isn't a state of this version of i3ipc++");
+		}
+	} catch (...) {
+		if (m_data)
+			munmap(m_data, m_mapped);
+		close(m_fd);
+		throw;
+	}
+}
+
+state_reader::~state_reader() {
+	munmap(m_data, m_mapped);
+	close(m_fd);
+}
+
+
+void  state_reader::map(const size_t  size) {
+	void*  data = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		throw errno_error(auss_t() << "Failed to map shared memory \"" << m_name << '"');
+	}
+	if (m_data)
+		munmap(m_data, m_mapped);
+	m_data = static_cast<uint8_t*>(data);
+	m_mapped = size;
+}
+
+
+uint32_t  state_reader::sequence() const {
+	return get_header(m_data)->sequence.load(std::memory_order_acquire);
+}
+
+
+bool  state_reader::is_closed() const {
+	return get_header(m_data)->closed.load() != 0;
+}
+
+
+bool  state_reader::wait(const uint32_t  sequence, const std::chrono::milliseconds  timeout) const {
+	auto  header = get_header(m_data);
+	const auto  deadline = std::chrono::steady_clock::now() + timeout;
+	while (true) {
+		const uint32_t  current = header->sequence.load(std::memory_order_acquire);
+		if ((current != sequence && current % 2 == 0) || header->closed.load()) {
+			return true;
+		}
+
+		struct timespec  ts;
+		struct timespec*  pts = nullptr;
+		if (timeout.count() >= 0) {
+			auto  left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (left <= 0)
+				return false;
+			ts.tv_sec = left / 1000000000;
+			ts.tv_nsec = left % 1000000000;
+			pts = &ts;
+		}
+		// Shared (not private) futex: the publisher is another process
+		if (futex(&header->sequence, FUTEX_WAIT, current, pts) == -1 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+			throw errno_error("Failed to wait for the shared state");
+		}
+	}
+}
+
+
+/**
+ * Check, that a snapshot, which is being written for long, will be finished
+ * @param  deadline deadline of the read. Set on the first check
+ */
+void  state_reader::check_writer(std::chrono::steady_clock::time_point&  deadline) const {
+	// The publisher holds an exclusive lock until it is gone, so a shared lock is granted only if it has died
+	if (flock(m_fd, LOCK_SH | LOCK_NB) == 0) {
+		flock(m_fd, LOCK_UN);
+		throw ipc_error(auss_t() << "Publisher of shared memory \"" << m_name << "\" has died while writing a state");
+	}
+	if (errno != EWOULDBLOCK) {
+		throw errno_error(auss_t() << "Failed to check the lock of shared memory \"" << m_name << '"');
+	}
+
+	const auto  now = std::chrono::steady_clock::now();
+	if (deadline == std::chrono::steady_clock::time_point()) {
+		deadline = now + READ_TIMEOUT;
+	} else if (now > deadline) {
+		throw ipc_error(auss_t() << "Timed out reading a state from shared memory \"" << m_name << '"');
+	}
+}
+
+
+uint32_t  state_reader::read(shared_state_t&  state) {
+	auto  header = get_header(m_data);
+	uint32_t  sequence;
+	uint32_t  retries = 0;
+	std::chrono::steady_clock::time_point  deadline;
+	while (true) {
+		if (retries > 0 && retries % WRITER_CHECK_INTERVAL == 0) {
+			this->check_writer(deadline);
+		}
+		retries++;
+
+		const size_t  capacity = header->capacity.load(std::memory_order_acquire);
+		if (capacity > m_mapped) {
+			this->map(capacity);
+			header = get_header(m_data);
+		}
+
+		sequence = header->sequence.load(std::memory_order_acquire);
+		if (sequence % 2 != 0) {
+			std::this_thread::yield();
+			continue;
+		}
+		const size_t  size = header->size.load(std::memory_order_relaxed);
+		if (SNAPSHOT_OFFSET + size > m_mapped) {
+			continue; // Torn read of a grown segment, the capacity is updated
+		}
+		m_copy.resize(size);
+		std::memcpy(m_copy.data(), m_data + SNAPSHOT_OFFSET, size);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->sequence.load(std::memory_order_relaxed) == sequence)
+			break;
+	}
+
+	state = shared_state_t();
+	state.sequence = sequence;
+	if (sequence == 0 || m_copy.empty()) {
+		return sequence;
+	}
+
+	snapshot_reader  reader(m_copy.data(), m_copy.size());
+	const uint64_t  tree = reader.get<uint64_t>();
+	const uint64_t  workspaces = reader.get<uint64_t>();
+	const uint64_t  outputs = reader.get<uint64_t>();
+
+	reader.seek(tree);
+	if (reader.get_bool()) {
+		state.tree = reader.get_container();
+	}
+
+	reader.seek(workspaces);
+	uint32_t  count = reader.get<uint32_t>();
+	state.workspaces.reserve(reader.at_most(count, sizeof(uint32_t)));
+	for (uint32_t  i = 0; i < count; i++) {
+		auto  ws = std::make_shared<workspace_t>();
+		ws->id = reader.get<uint64_t>();
+		ws->num = reader.get<int32_t>();
+		ws->name = reader.get_string();
+		ws->visible = reader.get_bool();
+		ws->focused = reader.get_bool();
+		ws->urgent = reader.get_bool();
+		ws->rect = reader.get_rect();
+		ws->output = reader.get_string();
+		state.workspaces.push_back(std::move(ws));
+	}
+
+	reader.seek(outputs);
+	count = reader.get<uint32_t>();
+	state.outputs.reserve(reader.at_most(count, sizeof(uint32_t)));
+	for (uint32_t  i = 0; i < count; i++) {
+		auto  out = std::make_shared<output_t>();
+		out->name = reader.get_string();
+		out->active = reader.get_bool();
+		out->primary = reader.get_bool();
+		out->current_workspace = reader.get_string();
+		out->rect = reader.get_rect();
+		state.outputs.push_back(std::move(out));
+	}
+	return sequence;
+}
+
+}
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "spatial-index.hpp"
+
+namespace i3ipc {
+
+static const uint32_t  g_min_cell_size = 64;
+static const uint32_t  g_fullscreen_z = std::numeric_limits<uint32_t>::max();
+
+static inline bool  rect_empty(const rect_t&  r) {
+	return r.width == 0 || r.height == 0;
+}
+
+static inline bool  rect_contains(const rect_t&  r, const int64_t  x, const int64_t  y) {
+	return x >= r.x && y >= r.y && x < int64_t(r.x) + r.width && y < int64_t(r.y) + r.height;
+}
+
+static inline bool  rect_intersects(const rect_t&  a, const rect_t&  b) {
+	return int64_t(a.x) < int64_t(b.x) + b.width && int64_t(b.x) < int64_t(a.x) + a.width &&
+		int64_t(a.y) < int64_t(b.y) + b.height && int64_t(b.y) < int64_t(a.y) + a.height;
+}
+
+static inline bool  is_fullscreen(const container_t&  c) {
+	auto  it = c.map.find("fullscreen_mode");
+	return it != c.map.end() && !it->second.empty() && it->second != "0";
+}
+
+/**
+ * Pick the visible one of children: the first one in focus order, that is one of candidates
+ */
+static uint64_t  visible_child_id(const container_t&  c) {
+	for (uint64_t  id : c.focus) {
+		for (auto&  n : c.nodes) {
+			if (n && n->id == id)
+				return id;
+		}
+	}
+	return c.nodes.empty() || !c.nodes.front() ? 0 : c.nodes.front()->id;
+}
+
+
+spatial_index::spatial_index(const std::shared_ptr<container_t>&  root) :
+	m_next_floating_z(0),
+	m_origin_x(0),
+	m_origin_y(0),
+	m_cell_size(g_min_cell_size),
+	m_cols(0),
+	m_rows(0)
+{
+	if (root) {
+		this->collect(root, 0);
+	}
+	this->build_grid();
+}
+
+
+void  spatial_index::add(const rect_t&  rect, const uint32_t  z, const std::shared_ptr<container_t>&  container) {
+	if (rect_empty(rect))
+		return;
+	m_entries.push_back({ rect, z, container });
+}
+
+
+void  spatial_index::collect(const std::shared_ptr<container_t>&  node, uint32_t  z) {
+	if (node->type == "output" && node->name.compare(0, 2, "__") == 0) {
+		return; // i3's internal output with the scratchpad
+	}
+	if (is_fullscreen(*node)) {
+		z = g_fullscreen_z;
+	}
+
+	if (node->nodes.empty() && node->floating_nodes.empty()) {
+		if (node->xwindow_id != 0) {
+			this->add(node->rect, z, node);
+		}
+		return;
+	}
+
+	const bool  tabs = node->layout == ContainerLayout::TABBED || node->layout == ContainerLayout::STACKED;
+	const bool  workspaces = !node->nodes.empty() && node->nodes.front() && node->nodes.front()->type == "workspace";
+	const uint64_t  visible_id = (tabs || workspaces) ? visible_child_id(*node) : 0;
+
+	for (auto&  child : node->nodes) {
+		if (!child)
+			continue;
+		if (tabs || node->type == "floating_con") {
+			// Decorations of such children are drawn on the parent and are visible even if the child is not
+			const rect_t  deco = {
+				.x = node->rect.x + child->deco_rect.x,
+				.y = node->rect.y + child->deco_rect.y,
+				.width = child->deco_rect.width,
+				.height = child->deco_rect.height,
+			};
+			this->add(deco, z, child);
+		}
+		if ((tabs || workspaces) && child->id != visible_id)
+			continue;
+		this->collect(child, z);
+	}
+
+	for (auto&  child : node->floating_nodes) {
+		if (!child)
+			continue;
+		// Floating windows are raised by appending them to the end of the list
+		this->collect(child, z == g_fullscreen_z ? z : std::max(z, ++m_next_floating_z));
+	}
+}
+
+
+void  spatial_index::build_grid() {
+	m_cell_offsets.assign(1, 0);
+	m_cell_items.clear();
+	if (m_entries.empty()) {
+		return;
+	}
+
+	int64_t  x0 = std::numeric_limits<int64_t>::max(), y0 = x0;
+	int64_t  x1 = std::numeric_limits<int64_t>::min(), y1 = x1;
+	for (auto&  e : m_entries) {
+		x0 = std::min<int64_t>(x0, e.rect.x);
+		y0 = std::min<int64_t>(y0, e.rect.y);
+		x1 = std::max<int64_t>(x1, int64_t(e.rect.x) + e.rect.width);
+		y1 = std::max<int64_t>(y1, int64_t(e.rect.y) + e.rect.height);
+	}
+
+	// About one cell per rectangle, but not too small ones
+	const double  area = double(x1 - x0) * double(y1 - y0);
+	const double  cell = std::sqrt(area / m_entries.size());
+	m_cell_size = std::max<uint32_t>(g_min_cell_size, static_cast<uint32_t>(cell));
+	m_origin_x = x0;
+	m_origin_y = y0;
+	m_cols = static_cast<uint32_t>((x1 - x0 + m_cell_size - 1) / m_cell_size);
+	m_rows = static_cast<uint32_t>((y1 - y0 + m_cell_size - 1) / m_cell_size);
+
+	// Two passes: count the items of each cell, then fill them
+	std::vector<uint32_t>  counts(size_t(m_cols) * m_rows + 1, 0);
+	uint32_t  c0, r0, c1, r1;
+	for (auto&  e : m_entries) {
+		if (!this->cell_range(e.rect, c0, r0, c1, r1))
+			continue;
+		for (uint32_t  r = r0; r <= r1; r++) {
+			for (uint32_t  c = c0; c <= c1; c++) {
+				counts[size_t(r) * m_cols + c + 1]++;
+			}
+		}
+	}
+	for (size_t  i = 1; i < counts.size(); i++) {
+		counts[i] += counts[i - 1];
+	}
+	m_cell_offsets = counts;
+	m_cell_items.resize(counts.back());
+	for (uint32_t  i = 0; i < m_entries.size(); i++) {
+		if (!this->cell_range(m_entries[i].rect, c0, r0, c1, r1))
+			continue;
+		for (uint32_t  r = r0; r <= r1; r++) {
+			for (uint32_t  c = c0; c <= c1; c++) {
+				m_cell_items[counts[size_t(r) * m_cols + c]++] = i;
+			}
+		}
+	}
+}
+
+
+bool  spatial_index::cell_range(const rect_t&  rect, uint32_t&  col0, uint32_t&  row0, uint32_t&  col1, uint32_t&  row1) const {
+	if (m_cols == 0 || m_rows == 0 || rect_empty(rect))
+		return false;
+	int64_t  x0 = (int64_t(rect.x) - m_origin_x) / m_cell_size;
+	int64_t  y0 = (int64_t(rect.y) - m_origin_y) / m_cell_size;
+	int64_t  x1 = (int64_t(rect.x) + rect.width - 1 - m_origin_x) / m_cell_size;
+	int64_t  y1 = (int64_t(rect.y) + rect.height - 1 - m_origin_y) / m_cell_size;
+	if (int64_t(rect.x) + rect.width <= m_origin_x || int64_t(rect.y) + rect.height <= m_origin_y || x0 >= m_cols || y0 >= m_rows)
+		return false;
+	col0 = static_cast<uint32_t>(std::max<int64_t>(x0, 0));
+	row0 = static_cast<uint32_t>(std::max<int64_t>(y0, 0));
+	col1 = static_cast<uint32_t>(std::min<int64_t>(x1, m_cols - 1));
+	row1 = static_cast<uint32_t>(std::min<int64_t>(y1, m_rows - 1));
+	return true;
+}
+
+
+std::shared_ptr<container_t>  spatial_index::window_at(const int32_t  x, const int32_t  y) const {
+	if (m_cols == 0 || x < m_origin_x || y < m_origin_y)
+		return nullptr;
+	const int64_t  col = (int64_t(x) - m_origin_x) / m_cell_size;
+	const int64_t  row = (int64_t(y) - m_origin_y) / m_cell_size;
+	if (col >= m_cols || row >= m_rows)
+		return nullptr;
+
+	const size_t  cell = size_t(row) * m_cols + col;
+	const entry_t*  best = nullptr;
+	for (uint32_t  i = m_cell_offsets[cell]; i < m_cell_offsets[cell + 1]; i++) {
+		const entry_t&  e = m_entries[m_cell_items[i]];
+		if (rect_contains(e.rect, x, y) && (!best || e.z >= best->z)) {
+			best = &e;
+		}
+	}
+	return best ? best->container : nullptr;
+}
+
+
+std::vector< std::shared_ptr<container_t> >  spatial_index::windows_in(const rect_t&  region) const {
+	std::vector< std::shared_ptr<container_t> >  result;
+	uint32_t  c0, r0, c1, r1;
+	if (!this->cell_range(region, c0, r0, c1, r1))
+		return result;
+
+	std::vector<uint32_t>  hits;
+	for (uint32_t  r = r0; r <= r1; r++) {
+		for (uint32_t  c = c0; c <= c1; c++) {
+			const size_t  cell = size_t(r) * m_cols + c;
+			for (uint32_t  i = m_cell_offsets[cell]; i < m_cell_offsets[cell + 1]; i++) {
+				if (rect_intersects(m_entries[m_cell_items[i]].rect, region)) {
+					hits.push_back(m_cell_items[i]);
+				}
+			}
+		}
+	}
+	std::sort(hits.begin(), hits.end());
+	hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+	std::stable_sort(hits.begin(), hits.end(), [this](uint32_t  a, uint32_t  b) {
+		return m_entries[a].z > m_entries[b].z;
+	});
+
+	for (uint32_t  i : hits) {
+		const auto&  c = m_entries[i].container;
+		if (std::find(result.begin(), result.end(), c) == result.end()) {
+			result.push_back(c);
+		}
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,644 @@
+#include <algorithm>
+
+#include <json/json.h>
+
+#include "synthetic.hpp"
+#include "mock-server.hpp"
+
+namespace i3ipc {
+
+static const uint32_t  g_deco_height = 18;
+static const uint32_t  g_border_width = 2;
+
+static const char*  g_window_classes[] = {
+	"Firefox",
+	"URxvt",
+	"Code",
+	"Emacs",
+	"Slack",
+	"Thunderbird",
+	"mpv",
+	"Zathura",
+};
+
+/**
+ * A container of a synthetic tree
+ */
+struct synthetic_node_t {
+	uint64_t  id;
+	std::string  type; ///< root, output, con, floating_con, workspace or dockarea
+	std::string  name;
+	std::string  layout;
+	std::string  border;
+	int32_t  num = -1; ///< Number of a workspace
+	double  percent = -1;
+	rect_t  rect = { 0, 0, 0, 0 };
+	rect_t  window_rect = { 0, 0, 0, 0 };
+	rect_t  deco_rect = { 0, 0, 0, 0 };
+	rect_t  geometry = { 0, 0, 0, 0 };
+	uint64_t  xid = 0; ///< X11 window ID, 0 if it isn't a window
+	std::string  window_class;
+	synthetic_node_t*  parent = nullptr;
+	bool  floating = false; ///< Is in the floating_nodes of the parent
+	std::vector<std::unique_ptr<synthetic_node_t>>  nodes;
+	std::vector<std::unique_ptr<synthetic_node_t>>  floating_nodes;
+	std::vector<uint64_t>  focus;
+};
+
+
+static uint32_t  saturating_sub(const uint32_t  a, const uint32_t  b) {
+	return a > b ? a - b : 0;
+}
+
+static Json::Value  rect_to_json(const rect_t&  rect) {
+	Json::Value  v(Json::objectValue);
+	v["x"] = rect.x;
+	v["y"] = rect.y;
+	v["width"] = rect.width;
+	v["height"] = rect.height;
+	return v;
+}
+
+static std::string  write_json(const Json::Value&  value) {
+	Json::StreamWriterBuilder  builder;
+	builder["indentation"] = "";
+	return Json::writeString(builder, value);
+}
+
+
+/**
+ * Get a uniformly distributed number in [0, n). Unlike std::uniform_int_distribution, it gives the same
+ * numbers with any standard library
+ */
+static uint32_t  uniform(std::mt19937&  random, const uint32_t  n) {
+	return n ? random() % n : 0;
+}
+
+static double  chance(std::mt19937&  random) {
+	return (random() >> 8) / double(1 << 24);
+}
+
+
+synthetic_tree::synthetic_tree(const synthetic_tree_params_t&  params) :
+	m_params(params),
+	m_random(params.seed),
+	m_focused(nullptr),
+	m_next_id(0x5555555a0000),
+	m_next_xid(0x1a00003)
+{
+	m_root.reset(new node_t());
+	m_root->id = m_next_id;
+	m_next_id += 0x400;
+	m_root->type = "root";
+	m_root->name = "root";
+	m_root->layout = "splith";
+	m_root->border = "normal";
+	m_root->rect = { 0, 0, params.output_width * params.outputs, params.output_height };
+
+	// The internal output with the scratchpad workspace
+	node_t*  i3_output = this->add_node(m_root.get(), "output", false);
+	i3_output->name = "__i3";
+	i3_output->layout = "output";
+	node_t*  i3_content = this->add_node(i3_output, "con", false);
+	i3_content->name = "content";
+	node_t*  scratch = this->add_node(i3_content, "workspace", false);
+	scratch->name = "__i3_scratch";
+
+	for (uint32_t  o = 0; o < params.outputs; o++) {
+		node_t*  output = this->add_node(m_root.get(), "output", false);
+		output->name = "DP-" + std::to_string(o + 1);
+		output->layout = "output";
+		output->rect = { static_cast<int32_t>(o * params.output_width), 0, params.output_width, params.output_height };
+		this->add_node(output, "dockarea", false)->name = "topdock";
+		node_t*  content = this->add_node(output, "con", false);
+		content->name = "content";
+		this->add_node(output, "dockarea", false)->name = "bottomdock";
+		for (uint32_t  w = 0; w < params.workspaces_per_output; w++) {
+			node_t*  workspace = this->add_node(content, "workspace", false);
+			workspace->num = o * params.workspaces_per_output + w + 1;
+			workspace->name = std::to_string(workspace->num);
+			workspace->layout = (chance(m_random) < 0.7 ? "splith" : "splitv");
+			m_workspaces.push_back(workspace);
+		}
+	}
+
+	if (!m_workspaces.empty()) {
+		const uint32_t  floating = static_cast<uint32_t>(params.windows * params.floating_ratio);
+		std::vector<size_t>  tiling(m_workspaces.size(), 0);
+		for (uint32_t  i = floating; i < params.windows; i++) {
+			tiling[uniform(m_random, tiling.size())]++;
+		}
+		for (size_t  w = 0; w < m_workspaces.size(); w++) {
+			this->build_split(m_workspaces[w], tiling[w], 0);
+		}
+		this->layout(m_root.get()); // Floating windows are placed inside rects of workspaces
+		for (uint32_t  i = 0; i < floating; i++) {
+			this->add_window(this->random_workspace(), true);
+		}
+	}
+
+	// Random focus history, then the focused window goes first along its path
+	std::vector<node_t*>  stack = { m_root.get() };
+	while (!stack.empty()) {
+		node_t*  node = stack.back();
+		stack.pop_back();
+		for (size_t  i = node->focus.size(); i > 1; i--) {
+			std::swap(node->focus[i - 1], node->focus[uniform(m_random, i)]);
+		}
+		for (auto&  child : node->nodes)
+			stack.push_back(child.get());
+		for (auto&  child : node->floating_nodes)
+			stack.push_back(child.get());
+	}
+	if (!m_windows.empty()) {
+		this->focus(this->random_window());
+	}
+
+	this->layout(m_root.get());
+}
+
+synthetic_tree::~synthetic_tree() {}
+
+
+synthetic_node_t*  synthetic_tree::add_node(node_t*  parent, const std::string&  type, const bool  floating) {
+	std::unique_ptr<node_t>  node(new node_t());
+	node->id = m_next_id;
+	m_next_id += 0x400;
+	node->type = type;
+	node->layout = (type == "dockarea" ? "dockarea" : "splith");
+	node->border = "normal";
+	return this->attach(parent, std::move(node), floating);
+}
+
+
+synthetic_node_t*  synthetic_tree::attach(node_t*  parent, std::unique_ptr<node_t>  node, const bool  floating) {
+	if (floating && node->type != "floating_con") {
+		// i3 wraps a floating window into a floating_con
+		const node_t*  workspace = this->workspace_of(parent);
+		node_t*  con = this->add_node(parent, "floating_con", true);
+		const uint32_t  width = std::min(320 + uniform(m_random, 640), workspace->rect.width);
+		const uint32_t  height = std::min(240 + uniform(m_random, 480), workspace->rect.height);
+		con->rect = {
+			workspace->rect.x + static_cast<int32_t>(uniform(m_random, saturating_sub(workspace->rect.width, width) + 1)),
+			workspace->rect.y + static_cast<int32_t>(uniform(m_random, saturating_sub(workspace->rect.height, height) + 1)),
+			width,
+			height,
+		};
+		return this->attach(con, std::move(node), false);
+	}
+
+	node_t*  result = node.get();
+	node->parent = parent;
+	node->floating = floating;
+	parent->focus.push_back(node->id);
+	(floating ? parent->floating_nodes : parent->nodes).push_back(std::move(node));
+	return result;
+}
+
+
+std::unique_ptr<synthetic_node_t>  synthetic_tree::detach(node_t*  node) {
+	node_t*  parent = node->parent;
+	parent->focus.erase(std::remove(parent->focus.begin(), parent->focus.end(), node->id), parent->focus.end());
+	auto&  siblings = (node->floating ? parent->floating_nodes : parent->nodes);
+	auto  it = std::find_if(siblings.begin(), siblings.end(), [node](const std::unique_ptr<node_t>&  n) { return n.get() == node; });
+	std::unique_ptr<node_t>  owned = std::move(*it);
+	siblings.erase(it);
+	owned->parent = nullptr;
+
+	// i3 closes split and floating containers, which became empty
+	if ((parent->type == "con" || parent->type == "floating_con") && parent->xid == 0 && parent->nodes.empty() && parent->floating_nodes.empty()) {
+		this->detach(parent);
+	}
+	return owned;
+}
+
+
+synthetic_node_t*  synthetic_tree::add_window(node_t*  parent, const bool  floating) {
+	std::unique_ptr<node_t>  window(new node_t());
+	window->id = m_next_id;
+	m_next_id += 0x400;
+	window->type = "con";
+	window->layout = "splith";
+	window->border = "normal";
+	window->xid = m_next_xid;
+	m_next_xid += 0x200000;
+	window->window_class = g_window_classes[uniform(m_random, sizeof(g_window_classes) / sizeof(g_window_classes[0]))];
+	window->name = window->window_class + " - " + std::to_string(m_windows.size() + 1);
+	window->geometry = { 0, 0, 640, 480 };
+	m_windows.push_back(window.get());
+	return this->attach(parent, std::move(window), floating);
+}
+
+
+void  synthetic_tree::build_split(node_t*  parent, const size_t  windows, const uint32_t  depth) {
+	if (windows <= 2 || depth >= m_params.max_depth || chance(m_random) < 0.3) {
+		for (size_t  i = 0; i < windows; i++) {
+			this->add_window(parent, false);
+		}
+		return;
+	}
+
+	// Split windows into 2..4 parts, each one is a window or a nested split container
+	const size_t  parts = std::min<size_t>(windows, 2 + uniform(m_random, 3));
+	std::vector<size_t>  sizes(parts, 1);
+	for (size_t  i = parts; i < windows; i++) {
+		sizes[uniform(m_random, parts)]++;
+	}
+	for (size_t  size : sizes) {
+		if (size == 1) {
+			this->add_window(parent, false);
+			continue;
+		}
+		node_t*  con = this->add_node(parent, "con", false);
+		const double  layout = chance(m_random);
+		if (layout < m_params.tabbed_ratio) {
+			con->layout = "tabbed";
+		} else if (layout < m_params.tabbed_ratio + m_params.stacked_ratio) {
+			con->layout = "stacked";
+		} else {
+			con->layout = (parent->layout == "splith" ? "splitv" : "splith");
+		}
+		this->build_split(con, size, depth + 1);
+	}
+}
+
+
+void  synthetic_tree::layout(node_t*  node) {
+	const size_t  n = node->nodes.size();
+	if (node->type == "root") {
+		// Outputs have fixed rects
+	} else if (node->type == "output") {
+		for (auto&  child : node->nodes) {
+			child->rect = node->rect;
+			if (child->type == "dockarea") {
+				child->rect.height = 0;
+				if (child->name == "bottomdock")
+					child->rect.y += node->rect.height;
+			}
+		}
+	} else if (node->type == "con" && node->parent && node->parent->type == "output") {
+		for (auto&  child : node->nodes) {
+			child->rect = node->rect;
+		}
+	} else if (n > 0) {
+		const rect_t&  r = node->rect;
+		const bool  tabbed = (node->layout == "tabbed");
+		const bool  stacked = (node->layout == "stacked");
+		const uint32_t  bar = (tabbed ? g_deco_height : stacked ? g_deco_height * n : 0);
+		uint32_t  offset = 0;
+		for (size_t  i = 0; i < n; i++) {
+			node_t&  child = *node->nodes[i];
+			child.percent = 1.0 / n;
+			if (tabbed || stacked) {
+				child.rect = { r.x, r.y + static_cast<int32_t>(bar), r.width, saturating_sub(r.height, bar) };
+				child.deco_rect = tabbed ?
+					rect_t{ static_cast<int32_t>(r.width * i / n), 0, static_cast<uint32_t>(r.width * (i + 1) / n - r.width * i / n), g_deco_height } :
+					rect_t{ 0, static_cast<int32_t>(g_deco_height * i), r.width, g_deco_height };
+			} else if (node->layout == "splitv") {
+				const uint32_t  size = (i + 1 == n ? r.height - offset : r.height / n);
+				child.rect = { r.x, r.y + static_cast<int32_t>(offset), r.width, size };
+				offset += size;
+			} else {
+				const uint32_t  size = (i + 1 == n ? r.width - offset : r.width / n);
+				child.rect = { r.x + static_cast<int32_t>(offset), r.y, size, r.height };
+				offset += size;
+			}
+			if (child.xid) {
+				// The decoration of a window in a tabbed/stacked container is on its parent
+				const uint32_t  deco = (tabbed || stacked ? 0 : g_deco_height);
+				if (deco) {
+					child.deco_rect = { child.rect.x - r.x, child.rect.y - r.y, child.rect.width, deco };
+				}
+				child.window_rect = {
+					static_cast<int32_t>(g_border_width),
+					static_cast<int32_t>(deco),
+					saturating_sub(child.rect.width, 2 * g_border_width),
+					saturating_sub(child.rect.height, deco + g_border_width),
+				};
+			}
+		}
+	}
+
+	for (auto&  floating : node->floating_nodes) {
+		// A floating window fills its floating_con
+		for (auto&  child : floating->nodes) {
+			child->rect = floating->rect;
+			child->percent = 1.0;
+			child->deco_rect = { 0, 0, floating->rect.width, g_deco_height };
+			child->window_rect = {
+				static_cast<int32_t>(g_border_width),
+				static_cast<int32_t>(g_deco_height),
+				saturating_sub(floating->rect.width, 2 * g_border_width),
+				saturating_sub(floating->rect.height, g_deco_height + g_border_width),
+			};
+		}
+	}
+	for (auto&  child : node->nodes) {
+		this->layout(child.get());
+	}
+}
+
+
+void  synthetic_tree::focus(node_t*  window) {
+	m_focused = window;
+	for (node_t*  node = window; node->parent; node = node->parent) {
+		auto&  focus = node->parent->focus;
+		auto  it = std::find(focus.begin(), focus.end(), node->id);
+		if (it != focus.end()) {
+			std::rotate(focus.begin(), it, it + 1);
+		}
+	}
+}
+
+
+synthetic_node_t*  synthetic_tree::workspace_of(node_t*  node) const {
+	while (node && node->type != "workspace")
+		node = node->parent;
+	return node;
+}
+
+synthetic_node_t*  synthetic_tree::output_of(node_t*  node) const {
+	while (node && node->type != "output")
+		node = node->parent;
+	return node;
+}
+
+synthetic_node_t*  synthetic_tree::random_window() {
+	return m_windows.empty() ? nullptr : m_windows[uniform(m_random, m_windows.size())];
+}
+
+synthetic_node_t*  synthetic_tree::random_workspace() {
+	return m_workspaces[uniform(m_random, m_workspaces.size())];
+}
+
+
+static void  write_string(std::string&  out, const std::string&  str) {
+	out += '"';
+	for (char  c : str) {
+		if (c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	out += '"';
+}
+
+static void  write_rect(std::string&  out, const char*  name, const rect_t&  rect) {
+	out += ",\"";
+	out += name;
+	out += "\":{\"x\":" + std::to_string(rect.x) + ",\"y\":" + std::to_string(rect.y) +
+		",\"width\":" + std::to_string(rect.width) + ",\"height\":" + std::to_string(rect.height) + "}";
+}
+
+/**
+ * Serialize a container as i3 does (with the subtree)
+ */
+static void  write_node(std::string&  out, const synthetic_node_t&  node, const synthetic_node_t*  focused, const std::string&  output) {
+	// Written by hand in the order of i3: with jsoncpp the big workspace events are generated several times slower
+	out += "{\"id\":" + std::to_string(node.id) + ",\"type\":";
+	write_string(out, node.type);
+	out += ",\"orientation\":";
+	out += (node.layout == "splith" ? "\"horizontal\"" : node.layout == "splitv" ? "\"vertical\"" : "\"none\"");
+	out += ",\"scratchpad_state\":\"none\",\"percent\":";
+	out += (node.percent < 0 ? std::string("null") : std::to_string(node.percent));
+	out += ",\"urgent\":false,\"marks\":[],\"focused\":";
+	out += (&node == focused ? "true" : "false");
+	out += ",\"output\":";
+	if (node.type == "root") {
+		out += "null";
+	} else {
+		write_string(out, output);
+	}
+	out += ",\"layout\":";
+	write_string(out, node.layout);
+	out += ",\"workspace_layout\":\"default\",\"last_split_layout\":\"splith\",\"border\":";
+	write_string(out, node.border);
+	out += ",\"current_border_width\":" + std::to_string(node.xid ? g_border_width : 0);
+	write_rect(out, "rect", node.rect);
+	write_rect(out, "deco_rect", node.deco_rect);
+	write_rect(out, "window_rect", node.window_rect);
+	write_rect(out, "geometry", node.geometry);
+	out += ",\"name\":";
+	if (node.name.empty()) {
+		out += "null";
+	} else {
+		write_string(out, node.name);
+	}
+	if (node.type == "workspace") {
+		out += ",\"num\":" + std::to_string(node.num);
+	}
+	out += ",\"window\":";
+	if (node.xid) {
+		std::string  instance = node.window_class;
+		std::transform(instance.begin(), instance.end(), instance.begin(), ::tolower);
+		out += std::to_string(node.xid) + ",\"window_type\":\"normal\",\"window_properties\":{\"class\":";
+		write_string(out, node.window_class);
+		out += ",\"instance\":";
+		write_string(out, instance);
+		out += ",\"title\":";
+		write_string(out, node.name);
+		out += ",\"transient_for\":null}";
+	} else {
+		out += "null,\"window_type\":null";
+	}
+
+	out += ",\"nodes\":[";
+	for (size_t  i = 0; i < node.nodes.size(); i++) {
+		if (i)
+			out += ',';
+		write_node(out, *node.nodes[i], focused, node.type == "output" ? node.name : output);
+	}
+	out += "],\"floating_nodes\":[";
+	for (size_t  i = 0; i < node.floating_nodes.size(); i++) {
+		if (i)
+			out += ',';
+		write_node(out, *node.floating_nodes[i], focused, output);
+	}
+	out += "],\"focus\":[";
+	for (size_t  i = 0; i < node.focus.size(); i++) {
+		if (i)
+			out += ',';
+		out += std::to_string(node.focus[i]);
+	}
+	out += "],\"fullscreen_mode\":0,\"sticky\":false,\"floating\":";
+	out += (node.parent && node.parent->type == "floating_con" ? "\"user_on\"" : "\"auto_off\"");
+	out += ",\"swallows\":[]}";
+}
+
+
+std::string  synthetic_tree::get_tree_json() const {
+	std::string  out;
+	write_node(out, *m_root, m_focused, std::string());
+	return out;
+}
+
+
+std::string  synthetic_tree::get_workspaces_json() const {
+	const node_t*  focused_workspace = this->workspace_of(m_focused);
+	Json::Value  root(Json::arrayValue);
+	for (node_t*  workspace : m_workspaces) {
+		const node_t*  content = workspace->parent;
+		Json::Value  v(Json::objectValue);
+		v["id"] = Json::UInt64(workspace->id);
+		v["num"] = workspace->num;
+		v["name"] = workspace->name;
+		v["visible"] = (!content->focus.empty() && content->focus.front() == workspace->id);
+		v["focused"] = (workspace == focused_workspace);
+		v["urgent"] = false;
+		v["rect"] = rect_to_json(workspace->rect);
+		v["output"] = content->parent->name;
+		root.append(v);
+	}
+	return write_json(root);
+}
+
+
+std::string  synthetic_tree::get_outputs_json() const {
+	Json::Value  root(Json::arrayValue);
+	bool  primary = true;
+	for (auto&  output : m_root->nodes) {
+		const bool  active = (output->name != "__i3");
+		const node_t*  content = output->nodes.size() > 1 ? output->nodes[1].get() : nullptr;
+		Json::Value  v(Json::objectValue);
+		v["name"] = output->name;
+		v["active"] = active;
+		v["primary"] = active && primary;
+		v["rect"] = rect_to_json(output->rect);
+		v["current_workspace"] = Json::Value();
+		if (active && content && !content->focus.empty()) {
+			for (auto&  workspace : content->nodes) {
+				if (workspace->id == content->focus.front())
+					v["current_workspace"] = workspace->name;
+			}
+		}
+		primary = primary && !active;
+		root.append(v);
+	}
+	return write_json(root);
+}
+
+
+void  synthetic_tree::install(mock_server&  server) const {
+	server.set_reply(ClientMessageType::GET_TREE, this->get_tree_json());
+	server.set_reply(ClientMessageType::GET_WORKSPACES, this->get_workspaces_json());
+	server.set_reply(ClientMessageType::GET_OUTPUTS, this->get_outputs_json());
+}
+
+
+std::string  synthetic_tree::workspace_event(const std::string&  change, node_t*  current, node_t*  old) const {
+	std::string  out = "{\"change\":";
+	write_string(out, change);
+	out += ",\"current\":";
+	if (current) {
+		write_node(out, *current, m_focused, this->output_of(current)->name);
+	} else {
+		out += "null";
+	}
+	out += ",\"old\":";
+	if (old) {
+		write_node(out, *old, m_focused, this->output_of(old)->name);
+	} else {
+		out += "null";
+	}
+	out += '}';
+	return out;
+}
+
+
+std::string  synthetic_tree::window_event(const std::string&  change, node_t*  window) const {
+	std::string  out = "{\"change\":";
+	write_string(out, change);
+	out += ",\"container\":";
+	write_node(out, *window, m_focused, this->output_of(window)->name);
+	out += '}';
+	return out;
+}
+
+
+std::vector<synthetic_event_t>  synthetic_tree::generate_events(const size_t  count) {
+	std::vector<synthetic_event_t>  events;
+	events.reserve(count);
+	if (m_workspaces.empty())
+		return events;
+
+	// Focus a window like i3 does: with a workspace event, if the focused workspace changes
+	auto  emit_focus = [this, &events](node_t*  window) {
+		node_t*  old = this->workspace_of(m_focused);
+		this->focus(window);
+		node_t*  current = this->workspace_of(window);
+		if (old != current) {
+			events.push_back({ ET_WORKSPACE, this->workspace_event("focus", current, old) });
+		}
+		events.push_back({ ET_WINDOW, this->window_event("focus", window) });
+	};
+
+	while (events.size() < count) {
+		const size_t  left = count - events.size();
+		node_t*  window = this->random_window();
+		const uint32_t  action = uniform(m_random, 100);
+
+		if (!window) {
+			// Nothing to do with windows, open one
+			window = this->add_window(this->random_workspace(), false);
+			this->layout(this->workspace_of(window));
+			events.push_back({ ET_WINDOW, this->window_event("new", window) });
+		} else if (action < 35 && left >= 2) {
+			emit_focus(window);
+		} else if (action < 45 && left >= 3) {
+			// A new window opens next to the focused one
+			node_t*  parent = !m_focused ? this->random_workspace() : m_focused->parent->type == "floating_con" ? this->workspace_of(m_focused) : m_focused->parent;
+			node_t*  created = this->add_window(parent, false);
+			this->layout(this->workspace_of(created));
+			events.push_back({ ET_WINDOW, this->window_event("new", created) });
+			emit_focus(created);
+		} else if (action < 55 && m_windows.size() > 1 && window != m_focused) {
+			const std::string  payload = this->window_event("close", window);
+			node_t*  workspace = this->workspace_of(window);
+			m_windows.erase(std::find(m_windows.begin(), m_windows.end(), window));
+			this->detach(window);
+			this->layout(workspace);
+			events.push_back({ ET_WINDOW, payload });
+		} else if (action < 65 && window != m_focused && window->parent->type != "floating_con" && m_workspaces.size() > 1) {
+			node_t*  from = this->workspace_of(window);
+			node_t*  to = this->random_workspace();
+			if (to == from)
+				to = m_workspaces[(std::find(m_workspaces.begin(), m_workspaces.end(), from) - m_workspaces.begin() + 1) % m_workspaces.size()];
+			this->attach(to, this->detach(window), false);
+			this->layout(from);
+			this->layout(to);
+			events.push_back({ ET_WINDOW, this->window_event("move", window) });
+		} else if (action < 70 && window != m_focused) {
+			node_t*  workspace = this->workspace_of(window);
+			const bool  floating = (window->parent->type != "floating_con");
+			this->attach(workspace, this->detach(window), floating);
+			this->layout(workspace);
+			events.push_back({ ET_WINDOW, this->window_event("floating", window) });
+		} else {
+			window->name = window->window_class + " - " + std::to_string(uniform(m_random, 1000000));
+			events.push_back({ ET_WINDOW, this->window_event("title", window) });
+		}
+	}
+	return events;
+}
+
+
+size_t  synthetic_tree::containers() const {
+	size_t  result = 0;
+	std::vector<const node_t*>  stack = { m_root.get() };
+	while (!stack.empty()) {
+		const node_t*  node = stack.back();
+		stack.pop_back();
+		result++;
+		for (auto&  child : node->nodes)
+			stack.push_back(child.get());
+		for (auto&  child : node->floating_nodes)
+			stack.push_back(child.get());
+	}
+	return result;
+}
+
+
+uint64_t  synthetic_tree::focused_window() const {
+	return m_focused ? m_focused->id : 0;
+}
+
+}
@@ -0,0 +1,139 @@
+extern "C" {
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include "ipc-util.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+namespace i3ipc {
+
+std::atomic<bool>  g_trace_enabled(false);
+
+/**
+ * A trace file in the Chrome trace event format (JSON object with the traceEvents array)
+ */
+class trace_file {
+public:
+	explicit trace_file(const std::string&  path) : m_out(path, std::ios::trunc), m_first(true), m_pid(getpid()) {
+		if (!m_out) {
+			throw errno_error("Failed to create trace file " + path);
+		}
+		m_out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	}
+
+	~trace_file() {
+		m_out << "\n]}\n";
+	}
+
+	void  write(const trace_event_t&  event) {
+		char  line[256];
+		int  n = snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"cat\":\"i3ipc\",\"ph\":\"X\",\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,\"pid\":%d,\"tid\":%u",
+			(m_first ? "" : ","), event.name,
+			static_cast<long long>(event.start / 1000), static_cast<long long>(event.start % 1000),
+			static_cast<long long>(event.duration / 1000), static_cast<long long>(event.duration % 1000),
+			static_cast<int>(m_pid), event.thread_id);
+		m_out.write(line, std::min<size_t>(n, sizeof(line) - 1));
+		if (event.bytes) {
+			m_out << ",\"args\":{\"type\":\"" << message_type_name(event.type) << "\",\"bytes\":" << event.bytes << '}';
+		}
+		m_out << '}';
+		m_first = false;
+	}
+
+private:
+	std::ofstream  m_out;
+	bool  m_first;
+	pid_t  m_pid;
+};
+
+
+/**
+ * State of the tracing. Changed and read (when a span is finished) under the mutex
+ */
+struct trace_state_t {
+	std::mutex  mutex;
+	trace_sink_t  sink;
+	std::unique_ptr<trace_file>  file;
+	int64_t  start = 0;
+};
+
+static trace_state_t&  get_trace_state() {
+	// Never destroyed: spans may be finished by destructors of other static objects
+	static trace_state_t*  state = new trace_state_t();
+	return *state;
+}
+
+static int64_t  now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t  current_thread_id() {
+	static thread_local uint32_t  id = static_cast<uint32_t>(syscall(SYS_gettid));
+	return id;
+}
+
+
+void  start_trace(const std::string&  path) {
+	// The previous trace is closed first, it may be written to the same path
+	stop_trace();
+	auto  file = std::make_unique<trace_file>(path);
+	trace_file*  out = file.get();
+
+	trace_state_t&  state = get_trace_state();
+	std::lock_guard<std::mutex>  lock(state.mutex);
+	state.file = std::move(file);
+	state.sink = [out](const trace_event_t&  event) { out->write(event); };
+	state.start = now_ns();
+	g_trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+
+void  start_trace(trace_sink_t  sink) {
+	stop_trace();
+
+	trace_state_t&  state = get_trace_state();
+	std::lock_guard<std::mutex>  lock(state.mutex);
+	state.sink = std::move(sink);
+	state.start = now_ns();
+	g_trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+
+void  stop_trace() {
+	trace_state_t&  state = get_trace_state();
+	std::lock_guard<std::mutex>  lock(state.mutex);
+	g_trace_enabled.store(false, std::memory_order_relaxed);
+	state.sink = nullptr;
+	state.file.reset();
+}
+
+
+int64_t  trace_span::now() {
+	return now_ns();
+}
+
+
+void  trace_span::finish() {
+	const int64_t  end = now();
+	trace_state_t&  state = get_trace_state();
+	std::lock_guard<std::mutex>  lock(state.mutex);
+	if (!state.sink || m_start < state.start)
+		return; // Started before the current trace
+	const trace_event_t  event = { m_name, m_start - state.start, end - m_start, current_thread_id(), m_type, m_bytes };
+	try {
+		state.sink(event);
+	} catch (...) {
+		// Spans are finished in destructors
+	}
+}
+
+}
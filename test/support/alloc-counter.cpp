@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <new>
+
+#include "alloc-counter.hpp"
+
+thread_local alloc_counter_t  g_alloc_counter = { false, 0, 0 };
+
+/**
+ * Every replaceable non-aligned operator is replaced, so all of them allocate with malloc() and free with free()
+ */
+static void*  counted_malloc(const std::size_t  size) noexcept {
+	if (g_alloc_counter.enabled) {
+		g_alloc_counter.count++;
+		g_alloc_counter.bytes += size;
+	}
+	return std::malloc(size ? size : 1);
+}
+
+void*  operator new(std::size_t  size) {
+	void*  p = counted_malloc(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void*  operator new[](std::size_t  size) {
+	void*  p = counted_malloc(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void*  operator new(std::size_t  size, const std::nothrow_t&) noexcept {
+	return counted_malloc(size);
+}
+
+void*  operator new[](std::size_t  size, const std::nothrow_t&) noexcept {
+	return counted_malloc(size);
+}
+
+void  operator delete(void*  p) noexcept {
+	std::free(p);
+}
+
+void  operator delete[](void*  p) noexcept {
+	std::free(p);
+}
+
+void  operator delete(void*  p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void  operator delete[](void*  p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void  operator delete(void*  p, const std::nothrow_t&) noexcept {
+	std::free(p);
+}
+
+void  operator delete[](void*  p, const std::nothrow_t&) noexcept {
+	std::free(p);
+}
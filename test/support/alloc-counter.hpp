@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Allocation accounting of the unit tests: the global operator new is replaced (in alloc-counter.cpp, so
+ * the replacement operators don't meet the inlined standard ones in one translation unit) to count
+ * allocations of the current thread, while counting is enabled
+ */
+struct alloc_counter_t {
+	bool  enabled;
+	uint64_t  count;
+	uint64_t  bytes;
+};
+
+extern thread_local alloc_counter_t  g_alloc_counter;
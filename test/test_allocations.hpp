@@ -0,0 +1,133 @@
+extern "C" {
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <string>
+#include <vector>
+
+#include "ipc.hpp"
+#include "ipc-util.hpp"
+#include "support/alloc-counter.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+/**
+ * Allocations of a scope of the current thread
+ */
+class alloc_scope {
+public:
+	alloc_scope() : m_saved(g_alloc_counter) {
+		g_alloc_counter = { true, 0, 0 };
+	}
+
+	~alloc_scope() {
+		g_alloc_counter = m_saved;
+	}
+
+	uint64_t  count() const { return g_alloc_counter.count; }
+	uint64_t  bytes() const { return g_alloc_counter.bytes; }
+
+private:
+	alloc_counter_t  m_saved;
+};
+
+
+struct alloc_budget_t {
+	const char*  name;
+	uint32_t  index; ///< Index of the event type (its bit in EventType)
+	std::string  payload;
+	bool  typed; ///< Connect a slot of the typed signal (so the event is decoded)
+	double  max_allocs; ///< Allocations per event
+	double  max_bytes; ///< Allocated bytes per event
+};
+
+/**
+ * The event path is driven by canned frames from a socketpair and the allocations per event (counted by
+ * the replaced operator new, see support/alloc-counter.cpp) are compared with budgets, so an allocation
+ * eliminated from buf_t, event structures or parsing can't silently come back. Lower a budget, when you
+ * eliminate allocations.
+ */
+class testsuite_allocations : public CxxTest::TestSuite {
+public:
+	void test_event_budgets() {
+		const std::string  rect = "{\"x\":0,\"y\":0,\"width\":1920,\"height\":1080}";
+		const std::string  workspace = "{\"id\":7,\"num\":2,\"name\":\"2\",\"type\":\"workspace\",\"layout\":\"splith\",\"border\":\"normal\",\"rect\":" + rect +
+			",\"nodes\":[],\"floating_nodes\":[],\"focus\":[]}";
+		const std::string  window = "{\"id\":42,\"type\":\"con\",\"name\":\"window 42\",\"layout\":\"splith\",\"border\":\"normal\",\"current_border_width\":2"
+			",\"percent\":0.5,\"urgent\":false,\"focused\":true,\"window\":16777258,\"rect\":" + rect + ",\"window_rect\":" + rect + ",\"deco_rect\":" + rect +
+			",\"geometry\":" + rect + ",\"window_properties\":{\"class\":\"Term\",\"instance\":\"term\",\"title\":\"window 42\"},\"nodes\":[],\"floating_nodes\":[],\"focus\":[]}";
+
+		// Budgets are a bit over the measured values (libstdc++ 12, jsoncpp 1.9) to tolerate other versions of them
+		const alloc_budget_t  budgets[] = {
+			{ "raw", 3, "{\"change\":\"title\",\"container\":" + window + "}", false, 3, 640 },
+			{ "workspace", 0, "{\"change\":\"focus\",\"current\":" + workspace + ",\"old\":" + workspace + "}", true, 120, 11264 },
+			{ "output", 1, "{\"change\":\"unspecified\"}", true, 3, 128 },
+			{ "mode", 2, "{\"change\":\"resize\",\"pango_markup\":false}", true, 28, 3328 },
+			{ "window", 3, "{\"change\":\"title\",\"container\":" + window + "}", true, 170, 19456 },
+			{ "barconfig_update", 4, "{\"id\":\"bar-0\",\"mode\":\"dock\",\"position\":\"top\",\"status_command\":\"i3status\",\"font\":\"monospace 10\""
+				",\"workspace_buttons\":true,\"binding_mode_indicator\":true,\"verbose\":false,\"colors\":{\"background\":\"#000000\"}}", true, 42, 4608 },
+			{ "binding", 5, "{\"change\":\"run\",\"binding\":{\"command\":\"workspace 2\",\"event_state_mask\":[\"Mod4\"],\"input_code\":0"
+				",\"symbol\":\"2\",\"input_type\":\"keyboard\"}}", true, 48, 5120 },
+			{ "shutdown", 6, "{\"change\":\"restart\"}", true, 3, 128 },
+			{ "tick", 7, "{\"first\":false,\"payload\":\"x\"}", true, 28, 3328 },
+		};
+
+		for (auto&  budget : budgets) {
+			uint64_t  allocs, bytes;
+			this->measure(budget, allocs, bytes);
+			const double  allocs_per_event = double(allocs) / EVENTS;
+			const double  bytes_per_event = double(bytes) / EVENTS;
+			TS_TRACE(budget.name << ": " << allocs_per_event << " allocations, " << bytes_per_event << " bytes per event")
+			TSM_ASSERT_LESS_THAN_EQUALS(budget.name, allocs_per_event, budget.max_allocs)
+			TSM_ASSERT_LESS_THAN_EQUALS(budget.name, bytes_per_event, budget.max_bytes)
+		}
+	}
+
+private:
+	static const int  WARMUP = 16;
+	static const int  EVENTS = 256;
+
+	/**
+	 * Dispatch canned events through connection::handle_event() and count allocations of the dispatching
+	 */
+	void  measure(const alloc_budget_t&  budget, uint64_t&  allocs, uint64_t&  bytes) {
+		int  fds[2];
+		TS_ASSERT_EQUALS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0)
+		auto  frame = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, budget.payload);
+		frame->header->type = 0x80000000 | budget.index;
+
+		uint64_t  received = 0;
+		{
+			i3ipc::connection  conn(-1, fds[0]); // Takes the ownership of the socket
+			if (budget.typed) {
+				conn.signal_workspace_event.connect([&received](const i3ipc::workspace_event_t&) { received++; });
+				conn.signal_output_event.connect([&received]() { received++; });
+				conn.signal_mode_event.connect([&received](const i3ipc::mode_t&) { received++; });
+				conn.signal_window_event.connect([&received](const i3ipc::window_event_t&) { received++; });
+				conn.signal_barconfig_update_event.connect([&received](const i3ipc::bar_config_t&) { received++; });
+				conn.signal_binding_event.connect([&received](const i3ipc::binding_t&) { received++; });
+				conn.signal_shutdown_event.connect([&received]() { received++; });
+				conn.signal_tick_event.connect([&received](const i3ipc::tick_event_t&) { received++; });
+			} else {
+				conn.signal_event.connect([&received](i3ipc::EventType, const std::shared_ptr<const i3ipc::buf_t>&) { received++; });
+			}
+
+			allocs = 0;
+			bytes = 0;
+			for (int  i = 0; i < WARMUP + EVENTS; i++) {
+				TS_ASSERT_EQUALS(write(fds[1], frame->data.data(), frame->data.size()), ssize_t(frame->data.size()))
+				alloc_scope  scope;
+				conn.handle_event();
+				if (i >= WARMUP) {
+					allocs += scope.count();
+					bytes += scope.bytes();
+				}
+			}
+			TSM_ASSERT_EQUALS(budget.name, received, uint64_t(WARMUP + EVENTS))
+		}
+		TSM_ASSERT(budget.name, fcntl(fds[0], F_GETFD) == -1) // Closed by the connection
+		close(fds[1]);
+	}
+};
@@ -0,0 +1,86 @@
+extern "C" {
+#include <unistd.h>
+}
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::string  capture_window_event_json(const uint64_t  id) {
+	return "{\"change\":\"title\",\"container\":{\"id\":" + std::to_string(id) + ",\"name\":\"w" + std::to_string(id) +
+		"\",\"type\":\"con\",\"layout\":\"splith\",\"border\":\"normal\",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1}}}";
+}
+
+class testsuite_capture : public CxxTest::TestSuite {
+public:
+	void test_round_trip() {
+		const std::string  path = "/tmp/i3ipcpp-test-capture-" + std::to_string(getpid()) + ".i3cap";
+		const uint64_t  EVENTS = 5;
+		std::vector<std::string>  payloads;
+		for (uint64_t  i = 0; i < EVENTS; i++) {
+			payloads.push_back(capture_window_event_json(i));
+		}
+
+		// Record: the handler is slow, so the events wait in the queue of the event reader
+		{
+			i3ipc::mock_server  server;
+			i3ipc::connection  conn(server.get_socket_path());
+			std::vector<uint64_t>  ids;
+			conn.signal_window_event.connect([&ids](const i3ipc::window_event_t&  ev) {
+				ids.push_back(ev.container->id);
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			});
+			conn.start_capture(path);
+			conn.subscribe(i3ipc::ET_WINDOW);
+			conn.connect_event_socket();
+			conn.start_event_reader();
+			server.send_events(i3ipc::ET_WINDOW, payloads);
+			while (ids.size() < EVENTS) {
+				conn.handle_event();
+			}
+			conn.stop_capture();
+		}
+
+		// Read: the records have the times of receipt, not of dispatching
+		std::vector<i3ipc::capture_record_t>  records;
+		{
+			i3ipc::capture_reader  reader(path);
+			i3ipc::capture_record_t  record;
+			while (reader.next(record)) {
+				records.push_back(record);
+			}
+		}
+		TS_ASSERT_EQUALS(records.size(), EVENTS)
+		for (size_t  i = 0; i < records.size(); i++) {
+			TS_ASSERT(records[i].channel == i3ipc::CaptureChannel::EVENT)
+			TS_ASSERT_EQUALS(std::string(records[i].buf->payload, records[i].buf->header->size), payloads[i])
+		}
+		if (records.size() == EVENTS) {
+			TS_ASSERT(records.back().time - records.front().time < std::chrono::milliseconds(20 * (EVENTS - 1)))
+		}
+
+		// Replay
+		{
+			i3ipc::capture_replayer  replayer(path, 0);
+			auto&  conn = replayer.get_connection();
+			std::vector<uint64_t>  ids;
+			conn.signal_window_event.connect([&ids](const i3ipc::window_event_t&  ev) {
+				ids.push_back(ev.container->id);
+			});
+			conn.subscribe(i3ipc::ET_WINDOW);
+			TS_ASSERT_THROWS(while (true) conn.handle_event(), i3ipc::eof_error)
+			TS_ASSERT_EQUALS(ids.size(), EVENTS)
+			for (uint64_t  i = 0; i < ids.size(); i++) {
+				TS_ASSERT_EQUALS(ids[i], i)
+			}
+			TS_ASSERT(replayer.finished())
+		}
+		unlink(path.c_str());
+	}
+};
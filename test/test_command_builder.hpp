@@ -0,0 +1,65 @@
+#include <string>
+#include <vector>
+
+#include "command-builder.hpp"
+#include "ipc.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_command_builder : public CxxTest::TestSuite {
+public:
+	void test_build() {
+		i3ipc::command_builder  cmd;
+		cmd.con_id(123).verb(i3ipc::CommandVerb::MOVE)
+			.option(i3ipc::CommandOption::CONTAINER).option(i3ipc::CommandOption::TO).option(i3ipc::CommandOption::WORKSPACE)
+			.arg("foo \"bar\"");
+		TS_ASSERT_EQUALS(std::string(cmd.str()), "[con_id=123] move container to workspace \"foo \\\"bar\\\"\"")
+		TS_ASSERT_EQUALS(cmd.size(), 1u)
+
+		cmd.clear();
+		cmd.window_class("a\\b").floating().verb(i3ipc::CommandVerb::FOCUS)
+			.chain().verb(i3ipc::CommandVerb::RESIZE).option(i3ipc::CommandOption::SET).arg(int64_t(640)).arg(int64_t(-480))
+			.next().verb(i3ipc::CommandVerb::NOP)
+			.con_mark("m").verb(i3ipc::CommandVerb::KILL);
+		TS_ASSERT_EQUALS(std::string(cmd.str()), "[class=\"a\\\\b\" floating] focus,resize set 640 -480;nop;[con_mark=\"m\"] kill")
+		TS_ASSERT_EQUALS(cmd.size(), 3u)
+		TS_ASSERT_EQUALS(cmd.results_of(0), 2u)
+		TS_ASSERT_EQUALS(cmd.results_of(1), 1u)
+		TS_ASSERT_EQUALS(cmd.results_of(2), 1u)
+
+		const i3ipc::buf_t&  message = cmd.message();
+		TS_ASSERT_EQUALS(message.header->type, static_cast<uint32_t>(i3ipc::ClientMessageType::COMMAND))
+		TS_ASSERT_EQUALS(message.header->size, cmd.str().size())
+		TS_ASSERT_EQUALS(std::string(message.payload, message.header->size), std::string(cmd.str()))
+	}
+
+	void test_send() {
+		i3ipc::mock_server  server;
+		std::string  command;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [&command](const std::string&  payload) {
+			command = payload;
+			if (payload == "nop")
+				return std::string("[{\"success\":true}]");
+			return std::string("[{\"success\":true},{\"success\":false,\"error\":\"nope\"},{\"success\":true}]");
+		});
+		i3ipc::connection  conn(server.get_socket_path());
+
+		i3ipc::command_builder  cmd;
+		cmd.title("x").verb(i3ipc::CommandVerb::FOCUS).chain().verb(i3ipc::CommandVerb::KILL)
+			.next().verb(i3ipc::CommandVerb::WORKSPACE).arg("2");
+		auto  results = conn.send_commands(cmd);
+		TS_ASSERT_EQUALS(command, "[title=\"x\"] focus,kill;workspace \"2\"")
+		TS_ASSERT_EQUALS(results.size(), 2u)
+		TS_ASSERT(!results[0].success)
+		TS_ASSERT_EQUALS(results[0].error, "nope")
+		TS_ASSERT(results[1].success)
+
+		// The builder is reused
+		cmd.clear();
+		cmd.verb(i3ipc::CommandVerb::NOP);
+		results = conn.send_commands(cmd);
+		TS_ASSERT_EQUALS(command, "nop")
+		TS_ASSERT_EQUALS(results.size(), 1u)
+	}
+};
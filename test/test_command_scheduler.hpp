@@ -0,0 +1,131 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "command-scheduler.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_command_scheduler : public CxxTest::TestSuite {
+	typedef i3ipc::command_scheduler::clock  clock;
+public:
+	void test_key() {
+		std::pair<std::string, std::string>  key;
+		TS_ASSERT(i3ipc::get_command_key(" [con_id=42 title=\"a]b; c\"] resize set 640 480", key))
+		TS_ASSERT_EQUALS(key.first, "con_id=42 title=\"a]b; c\"")
+		TS_ASSERT_EQUALS(key.second, "resize set")
+		TS_ASSERT(i3ipc::get_command_key("focus left", key))
+		TS_ASSERT_EQUALS(key.first, "")
+		TS_ASSERT_EQUALS(key.second, "focus left")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] move container to workspace \"x; y\"", key))
+		TS_ASSERT_EQUALS(key.second, "move container to workspace")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] resize grow width -10 px or 5ppt", key))
+		TS_ASSERT_EQUALS(key.second, "resize grow width")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] move container to workspace web", key))
+		TS_ASSERT_EQUALS(key.second, "move container to workspace")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] move --no-auto-back-and-forth container to workspace number 3:web", key))
+		TS_ASSERT_EQUALS(key.second, "move container to workspace number")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] resize set 640 px 480 px", key))
+		TS_ASSERT_EQUALS(key.second, "resize set")
+		TS_ASSERT(i3ipc::get_command_key("[con_id=1] resize set width 640 px", key))
+		TS_ASSERT_EQUALS(key.second, "resize set width")
+		TS_ASSERT(!i3ipc::get_command_key("[con_id=1] move container to workspace web; focus left", key))
+		TS_ASSERT(!i3ipc::get_command_key("[class=\"x\"] focus, move left", key))
+		TS_ASSERT(!i3ipc::get_command_key("   ", key))
+	}
+
+	void test_batching() {
+		i3ipc::mock_server  server;
+		std::vector<std::string>  payloads;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [&payloads](const std::string&  payload) {
+			payloads.push_back(payload);
+			std::string  reply;
+			size_t  start = 0;
+			for (size_t  end = 0; end != std::string::npos; start = end + 1) {
+				end = payload.find(';', start);
+				const bool  mark = (payload.compare(start, 10, "[con_mark=") == 0);
+				reply += (reply.empty() ? "[" : ",") + std::string(mark ? "{\"success\":false,\"error\":\"No such mark\"}" : "{\"success\":true}");
+			}
+			return reply + "]";
+		});
+		i3ipc::connection  conn(server.get_socket_path());
+		i3ipc::command_scheduler  scheduler(conn, std::chrono::milliseconds(10), 20);
+		scheduler.set_superseding("resize set", true);
+		std::vector<std::string>  failed;
+		scheduler.signal_command_error.connect([&failed](const std::string&  command, const i3ipc::command_result_t&  result) {
+			failed.push_back(command);
+		});
+
+		auto  t0 = clock::now();
+		scheduler.schedule("[con_id=1] resize set 100 100", t0);
+		scheduler.schedule("[con_id=2] resize set 100 100", t0);
+		scheduler.schedule("[con_id=1] resize set 110 100", t0 + std::chrono::milliseconds(1));
+		scheduler.schedule("[con_mark=x] mark --add y", t0 + std::chrono::milliseconds(2));
+		scheduler.schedule("[con_id=1] resize set 120 100", t0 + std::chrono::milliseconds(3));
+		TS_ASSERT_EQUALS(scheduler.size(), 3u)
+		TS_ASSERT(!scheduler.run(t0 + std::chrono::milliseconds(9)))
+		TS_ASSERT(scheduler.next_deadline() == t0 + std::chrono::milliseconds(10))
+		TS_ASSERT(scheduler.run(t0 + std::chrono::milliseconds(10)))
+		TS_ASSERT_EQUALS(payloads.size(), 1u)
+		if (!payloads.empty()) {
+			TS_ASSERT_EQUALS(payloads[0], "[con_id=2] resize set 100 100;[con_mark=x] mark --add y;[con_id=1] resize set 120 100")
+		}
+		TS_ASSERT_EQUALS(failed.size(), 1u)
+		TS_ASSERT_EQUALS(scheduler.stats().superseded, 2u)
+		TS_ASSERT_EQUALS(scheduler.stats().sent, 3u)
+
+		// The max rate (20 per second) delays the next batch
+		scheduler.schedule("focus", t0 + std::chrono::milliseconds(11));
+		TS_ASSERT(scheduler.next_deadline() == t0 + std::chrono::milliseconds(60))
+		scheduler.flush();
+		TS_ASSERT_EQUALS(scheduler.size(), 0u)
+		TS_ASSERT_EQUALS(scheduler.stats().batches, 2u)
+		TS_ASSERT_EQUALS(scheduler.stats().scheduled, 6u)
+	}
+
+	void test_superseding() {
+		i3ipc::mock_server  server;
+		std::vector<std::string>  payloads;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [&payloads](const std::string&  payload) {
+			payloads.push_back(payload);
+			std::string  reply = "[{\"success\":true}";
+			for (char  c : payload) {
+				if (c == ';')
+					reply += ",{\"success\":true}";
+			}
+			return reply + "]";
+		});
+		i3ipc::connection  conn(server.get_socket_path());
+		i3ipc::command_scheduler  scheduler(conn);
+		auto  t0 = clock::now();
+
+		// Off by default: relative steps of a drag-resize are all sent
+		for (int  i = 0; i < 3; i++) {
+			scheduler.schedule("[con_id=1] resize grow width 10 px", t0);
+		}
+		scheduler.flush();
+		TS_ASSERT_EQUALS(scheduler.stats().superseded, 0u)
+		TS_ASSERT_EQUALS(payloads.back(), "[con_id=1] resize grow width 10 px;[con_id=1] resize grow width 10 px;[con_id=1] resize grow width 10 px")
+
+		// Commands without criteria act on the focused window, so they are never superseded
+		scheduler.set_superseding("focus left", true);
+		scheduler.set_superseding("move right", true);
+		scheduler.schedule("focus left", t0);
+		scheduler.schedule("move right", t0);
+		scheduler.schedule("focus left", t0);
+		scheduler.flush();
+		TS_ASSERT_EQUALS(scheduler.stats().superseded, 0u)
+		TS_ASSERT_EQUALS(payloads.back(), "focus left;move right;focus left")
+
+		// Different subcommands of a verb don't supersede each other, the same one does
+		scheduler.set_superseding("move left", true);
+		scheduler.set_superseding("move to workspace", true);
+		scheduler.schedule("[con_id=1] move left", t0);
+		scheduler.schedule("[con_id=1] move to workspace 3", t0);
+		scheduler.schedule("[con_id=1] move to workspace 4", t0);
+		scheduler.flush();
+		TS_ASSERT_EQUALS(scheduler.stats().superseded, 1u)
+		TS_ASSERT_EQUALS(payloads.back(), "[con_id=1] move left;[con_id=1] move to workspace 4")
+	}
+};
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc.hpp"
+#include "latency-probe.hpp"
+#include "mark-index.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::string  window_event_json(const char*  change, const uint64_t  id) {
+	return std::string("{\"change\":\"") + change + "\",\"container\":{\"id\":" + std::to_string(id) + ",\"name\":\"w" + std::to_string(id) +
+		"\",\"type\":\"con\",\"layout\":\"splith\",\"border\":\"normal\",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1}}}";
+}
+
+class testsuite_connection : public CxxTest::TestSuite {
+public:
+	void test_requests() {
+		i3ipc::mock_server  server;
+		std::string  command;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [&command](const std::string&  payload) {
+			command = payload;
+			return std::string("[{\"success\":false,\"error\":\"nope\"}]");
+		});
+		server.set_reply(i3ipc::ClientMessageType::GET_WORKSPACES,
+			"[{\"num\":1,\"name\":\"1\",\"visible\":true,\"focused\":true,\"urgent\":false,\"rect\":{\"x\":0,\"y\":0,\"width\":800,\"height\":600},\"output\":\"X\"}]");
+
+		i3ipc::connection  conn(server.get_socket_path());
+		TS_ASSERT_EQUALS(conn.get_version().major, 4u)
+		TS_ASSERT_EQUALS(conn.get_tree()->type, "root")
+		auto  workspaces = conn.get_workspaces();
+		TS_ASSERT_EQUALS(workspaces.size(), 1u)
+		TS_ASSERT_EQUALS(workspaces[0]->output, "X")
+		TS_ASSERT(!conn.send_command("focus left"))
+		TS_ASSERT_EQUALS(command, "focus left")
+		TS_ASSERT_EQUALS(server.requests(i3ipc::ClientMessageType::COMMAND), 1u)
+	}
+
+	void test_send_commands() {
+		i3ipc::mock_server  server;
+		std::string  command;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [&command](const std::string&  payload) {
+			command = payload;
+			// Like i3: a result per command of lists, stopping on the parse error
+			return std::string("[{\"success\":true},{\"success\":true},{\"success\":false,\"error\":\"No window matches\"}"
+				",{\"success\":true},{\"success\":false,\"parse_error\":true,\"error\":\"Expected one of these tokens\"}]");
+		});
+		i3ipc::connection  conn(server.get_socket_path());
+		const std::vector<std::string>  commands = {
+			"[title=\"a; b, c\"] focus",
+			"focus left, move right",
+			"",
+			"nop",
+			"bogus",
+			"nop",
+		};
+		auto  results = conn.send_commands(commands);
+		TS_ASSERT_EQUALS(command, "[title=\"a; b, c\"] focus;focus left, move right;;nop;bogus;nop")
+		TS_ASSERT_EQUALS(results.size(), 6u)
+		TS_ASSERT(results[0].success)
+		TS_ASSERT(!results[1].success)
+		TS_ASSERT_EQUALS(results[1].error, "No window matches")
+		TS_ASSERT(results[2].success)
+		TS_ASSERT(results[3].success)
+		TS_ASSERT_EQUALS(results[4].error, "Expected one of these tokens")
+		TS_ASSERT(!results[5].success)
+		TS_ASSERT_EQUALS(results[5].error, "Not executed")
+		TS_ASSERT(conn.send_commands({}).empty())
+		TS_ASSERT_EQUALS(server.requests(i3ipc::ClientMessageType::COMMAND), 1u)
+	}
+
+	void test_async_commands() {
+		i3ipc::mock_server  server;
+		server.set_handler(i3ipc::ClientMessageType::COMMAND, [](const std::string&  payload) {
+			if (payload.compare(0, 6, "resize") == 0)
+				return std::string("[{\"success\":true}]");
+			return std::string("[{\"success\":false,\"error\":\"Unknown command\"}]");
+		});
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.set_max_pending_commands(8);
+		std::vector<int>  done;
+		std::vector<std::string>  failed;
+		conn.signal_command_error.connect([&failed](const std::string&  command, const i3ipc::command_result_t&  result) {
+			failed.push_back(command + ": " + result.error);
+		});
+
+		for (int  i = 0; i < 100; i++) {
+			conn.send_command_async(i == 50 ? "bogus" : "resize grow width 1 px", [&done, i](const i3ipc::command_result_t&  result) {
+				done.push_back(result.success ? i : -i);
+			});
+			TS_ASSERT_LESS_THAN_EQUALS(conn.get_pending_commands(), 8u)
+		}
+		TS_ASSERT_EQUALS(done.size() + conn.get_pending_commands(), 100u)
+		conn.process_command_replies();
+		TS_ASSERT_EQUALS(conn.get_version().major, 4u) // Drains the replies first
+		TS_ASSERT_EQUALS(conn.get_pending_commands(), 0u)
+		TS_ASSERT_EQUALS(done.size(), 100u)
+		for (int  i = 0; i < 100 && i < int(done.size()); i++) {
+			TS_ASSERT_EQUALS(done[i], i == 50 ? -50 : i)
+		}
+		TS_ASSERT_EQUALS(failed.size(), 1u)
+		if (!failed.empty()) {
+			TS_ASSERT_EQUALS(failed[0], "bogus: Unknown command")
+		}
+
+		conn.send_command_async("resize shrink width 1 px");
+		conn.wait_command_replies();
+		TS_ASSERT_EQUALS(server.requests(i3ipc::ClientMessageType::COMMAND), 101u)
+	}
+
+	void test_events() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		std::vector<uint64_t>  ids;
+		int  ticks = 0;
+		conn.signal_window_event.connect([&ids](const i3ipc::window_event_t&  ev) {
+			ids.push_back(ev.container->id);
+		});
+		conn.signal_tick_event.connect([&ticks](const i3ipc::tick_event_t&  ev) {
+			ticks++;
+		});
+		conn.subscribe(i3ipc::ET_WINDOW | i3ipc::ET_TICK);
+		conn.connect_event_socket();
+
+		std::vector<std::string>  payloads;
+		for (uint64_t  i = 0; i < 100; i++) {
+			payloads.push_back(window_event_json("title", i));
+		}
+		server.send_event(i3ipc::ET_WORKSPACE, "{\"change\":\"focus\"}"); // Not subscribed
+		server.send_events(i3ipc::ET_WINDOW, payloads, 20000);
+		TS_ASSERT(conn.send_tick("x"))
+		while (ids.size() < payloads.size()) {
+			conn.handle_event();
+		}
+		for (uint64_t  i = 0; i < ids.size(); i++) {
+			TS_ASSERT_EQUALS(ids[i], i)
+		}
+		TS_ASSERT(server.wait_idle())
+		TS_ASSERT_EQUALS(server.sent_events(), 102u) // 100 window events and 2 ticks
+	}
+
+	void test_latency_probe() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.subscribe(i3ipc::ET_WINDOW);
+		conn.set_latency_probe_interval(std::chrono::milliseconds(1));
+		conn.connect_event_socket();
+		conn.start_event_reader();
+
+		auto&  probe = conn.get_latency_probe();
+		while (probe.received() < 3) {
+			conn.handle_event();
+		}
+		TS_ASSERT(probe.sent() >= 3u)
+		TS_ASSERT_EQUALS(probe.rtt().snapshot().count, probe.sent())
+
+		// Nothing new to subscribe to, while the reader is running
+		TS_ASSERT(conn.subscribe(i3ipc::ET_WINDOW | i3ipc::ET_TICK))
+		TS_ASSERT_THROWS_NOTHING(conn.set_latency_probe_interval(std::chrono::milliseconds(2)))
+		TS_ASSERT_THROWS_NOTHING(i3ipc::mark_index  marks(conn))
+	}
+
+	void test_subscribe_with_reader() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.subscribe(i3ipc::ET_WORKSPACE);
+		conn.connect_event_socket();
+		conn.start_event_reader();
+
+		// The subscriptions can't be changed, users of the connection must not silently get no events
+		TS_ASSERT(!conn.subscribe(i3ipc::ET_TICK))
+		TS_ASSERT_THROWS(conn.set_latency_probe_interval(std::chrono::milliseconds(1)), i3ipc::ipc_error)
+		TS_ASSERT_THROWS(i3ipc::mark_index  marks(conn), i3ipc::ipc_error)
+		TS_ASSERT_EQUALS(conn.signal_window_event.size(), 0u)
+		TS_ASSERT(conn.subscribe(i3ipc::ET_WORKSPACE))
+	}
+
+	void test_event_timing() {
+		const auto  start = std::chrono::steady_clock::now();
+		std::vector<std::string>  payloads = { window_event_json("title", 1), window_event_json("title", 2) };
+		for (const int32_t  predecode : { -1, 0, static_cast<int32_t>(i3ipc::ET_WINDOW) }) {
+			// -1 - direct path, without the event reader
+			i3ipc::mock_server  server;
+			i3ipc::connection  conn(server.get_socket_path());
+			std::vector<i3ipc::event_timing_t>  timings;
+			conn.set_event_timing(true);
+			conn.signal_event_timing.connect([&timings](const i3ipc::event_timing_t&  timing) {
+				timings.push_back(timing);
+			});
+			conn.signal_window_event.connect([](const i3ipc::window_event_t&) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			});
+			conn.subscribe(i3ipc::ET_WINDOW);
+			conn.connect_event_socket();
+			if (predecode >= 0) {
+				conn.start_event_reader(1024, predecode);
+			}
+			server.send_events(i3ipc::ET_WINDOW, payloads);
+			while (timings.size() < payloads.size()) {
+				conn.handle_event();
+			}
+
+			for (size_t  i = 0; i < timings.size(); i++) {
+				const auto&  timing = timings[i];
+				TS_ASSERT_EQUALS(timing.type, i3ipc::ET_WINDOW)
+				TS_ASSERT_EQUALS(timing.bytes, sizeof(i3ipc::header_t) + payloads[i].size())
+				TS_ASSERT(timing.received >= start)
+				TS_ASSERT(timing.dispatched >= timing.received)
+				TS_ASSERT(timing.parse > std::chrono::nanoseconds::zero())
+				TS_ASSERT(timing.dispatch >= std::chrono::milliseconds(5))
+				TS_ASSERT_EQUALS(timing.predecoded, predecode > 0)
+			}
+			if (predecode >= 0) {
+				// The second event was queued, while the first one was dispatched
+				TS_ASSERT(timings[1].dispatched - timings[1].received >= std::chrono::milliseconds(5))
+			}
+			TS_ASSERT(conn.get_last_event_timing().dispatched == timings.back().dispatched)
+		}
+	}
+};
@@ -0,0 +1,147 @@
+extern "C" {
+#include <poll.h>
+}
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event-bus.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::shared_ptr<const i3ipc::event_t>  bus_event(const i3ipc::EventType  type) {
+	auto  ev = std::make_shared<i3ipc::event_t>();
+	ev->type = type;
+	return ev;
+}
+
+static bool  bus_fd_readable(const int32_t  fd) {
+	struct pollfd  pfd = { fd, POLLIN, 0 };
+	return poll(&pfd, 1, 0) == 1;
+}
+
+class testsuite_event_bus : public CxxTest::TestSuite {
+public:
+	void test_consumers_order() {
+		i3ipc::mock_server  server;
+		i3ipc::event_bus  bus(server.get_socket_path(), i3ipc::ET_TICK);
+		const int  CONSUMERS = 3;
+		const uint64_t  EVENTS = 1000;
+
+		std::vector< std::vector<std::string> >  received(CONSUMERS);
+		std::vector<std::thread>  threads;
+		for (int  c = 0; c < CONSUMERS; c++) {
+			auto  consumer = bus.subscribe();
+			threads.emplace_back([consumer, &received, c, EVENTS]() {
+				std::shared_ptr<const i3ipc::event_t>  ev;
+				while (received[c].size() < EVENTS && consumer->next(ev, std::chrono::milliseconds(5000))) {
+					if (ev->tick && !ev->tick->first) {
+						received[c].push_back(ev->tick->payload);
+					}
+				}
+			});
+		}
+
+		std::vector<std::string>  payloads;
+		for (uint64_t  i = 0; i < EVENTS; i++) {
+			payloads.push_back("{\"first\":false,\"payload\":\"" + std::to_string(i) + "\"}");
+		}
+		server.send_events(i3ipc::ET_TICK, payloads);
+		for (auto&  t : threads) {
+			t.join();
+		}
+		for (auto&  r : received) {
+			TS_ASSERT_EQUALS(r.size(), EVENTS)
+			for (size_t  i = 0; i < r.size(); i++) {
+				TS_ASSERT_EQUALS(r[i], std::to_string(i))
+			}
+		}
+		bus.stop();
+	}
+
+	void test_overrun() {
+		i3ipc::mock_server  server;
+		// The server sends no workspace events, so the bus doesn't publish by itself
+		i3ipc::event_bus  bus(server.get_socket_path(), i3ipc::ET_WORKSPACE, 8);
+		auto  slow = bus.subscribe();
+		auto  fast = bus.subscribe(i3ipc::ET_WINDOW);
+
+		std::vector< std::shared_ptr<const i3ipc::event_t> >  published;
+		std::shared_ptr<const i3ipc::event_t>  ev;
+		for (int  i = 0; i < 100; i++) {
+			published.push_back(bus_event(i % 2 ? i3ipc::ET_WINDOW : i3ipc::ET_TICK));
+			bus.publish(published.back());
+			if (i % 2) {
+				// The fast one keeps up and gets only its types
+				TS_ASSERT(fast->try_next(ev))
+				TS_ASSERT(ev == published.back())
+			}
+		}
+		TS_ASSERT(!fast->try_next(ev))
+		TS_ASSERT_EQUALS(fast->skipped(), 0u)
+		TS_ASSERT_EQUALS(fast->taken(), 50u)
+
+		// The slow one has been lapped: it gets the events still in the ring, in order
+		TS_ASSERT_EQUALS(slow->lag(), 100u)
+		TS_ASSERT_EQUALS(bus.count_slow_consumers(), 1u)
+		std::vector< std::shared_ptr<const i3ipc::event_t> >  taken;
+		while (slow->try_next(ev)) {
+			taken.push_back(ev);
+		}
+		TS_ASSERT(!taken.empty())
+		TS_ASSERT(taken.size() <= 8u)
+		TS_ASSERT_EQUALS(slow->skipped() + slow->taken(), 100u)
+		for (size_t  i = 0; i < taken.size(); i++) {
+			TS_ASSERT(taken[i] == published[100 - taken.size() + i])
+		}
+		TS_ASSERT_EQUALS(slow->lag(), 0u)
+
+		slow->skip_to_latest();
+		bus.publish(bus_event(i3ipc::ET_TICK));
+		bus.publish(bus_event(i3ipc::ET_TICK));
+		slow->skip_to_latest();
+		TS_ASSERT_EQUALS(slow->skipped(), 100u - taken.size() + 2)
+		TS_ASSERT(!slow->try_next(ev))
+		bus.stop();
+	}
+
+	void test_wakeup() {
+		i3ipc::mock_server  server;
+		i3ipc::event_bus  bus(server.get_socket_path(), i3ipc::ET_WORKSPACE);
+		auto  consumer = bus.subscribe();
+		std::shared_ptr<const i3ipc::event_t>  ev;
+
+		// try_next() arms the eventfd, a publishing makes it readable
+		TS_ASSERT(!consumer->try_next(ev))
+		TS_ASSERT(!bus_fd_readable(consumer->get_fd()))
+		bus.publish(bus_event(i3ipc::ET_TICK));
+		TS_ASSERT(bus_fd_readable(consumer->get_fd()))
+		TS_ASSERT(consumer->try_next(ev))
+
+		TS_ASSERT(!consumer->next(ev, std::chrono::milliseconds(10)))
+
+		// A blocked consumer is woken by a publishing from another thread
+		bool  got = false;
+		std::thread  t([consumer, &got]() {
+			std::shared_ptr<const i3ipc::event_t>  ev;
+			got = consumer->next(ev, std::chrono::milliseconds(5000));
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		bus.publish(bus_event(i3ipc::ET_TICK));
+		t.join();
+		TS_ASSERT(got)
+
+		// stop() wakes waiting consumers
+		std::thread  t2([consumer, &got]() {
+			std::shared_ptr<const i3ipc::event_t>  ev;
+			got = consumer->next(ev);
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		bus.stop();
+		t2.join();
+		TS_ASSERT(!got)
+	}
+};
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "event-coalescer.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_event_coalescer : public CxxTest::TestSuite {
+	typedef i3ipc::event_coalescer::clock  clock;
+
+	static i3ipc::event_t  window_event(const std::string&  change, uint64_t  id, const std::string&  name = std::string()) {
+		auto  buff = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND,
+			"{\"change\":\"" + change + "\",\"container\":{\"id\":" + std::to_string(id) + ",\"name\":\"" + name + "\"}}");
+		return { i3ipc::ET_WINDOW, buff };
+	}
+
+	static std::string  name_of(const i3ipc::event_t&  ev) {
+		std::string_view  name;
+		i3ipc::i3_payload_read_string(*ev.buf, i3ipc::i3_payload_find_key(*ev.buf, "name"), name);
+		return std::string(name);
+	}
+public:
+	void test_pass_through() {
+		i3ipc::event_coalescer  c;
+		std::vector<i3ipc::event_t>  out;
+		c.push(window_event("title", 1), clock::now(), out);
+		TS_ASSERT(!c.enabled())
+		TS_ASSERT_EQUALS(out.size(), 1u)
+		TS_ASSERT_EQUALS(c.stats().passed, 1u)
+	}
+
+	void test_merge() {
+		i3ipc::event_coalescer  c;
+		c.set_interval(i3ipc::ET_WINDOW, "title", std::chrono::milliseconds(50));
+		std::vector<i3ipc::event_t>  out;
+		auto  t0 = clock::now();
+
+		c.push(window_event("title", 1, "a"), t0, out);
+		c.push(window_event("title", 2, "x"), t0, out);
+		c.push(window_event("title", 1, "b"), t0 + std::chrono::milliseconds(10), out);
+		c.push(window_event("title", 1, "c"), t0 + std::chrono::milliseconds(20), out);
+		TS_ASSERT(out.empty())
+		TS_ASSERT_EQUALS(c.size(), 2u)
+		TS_ASSERT(c.next_deadline() == t0 + std::chrono::milliseconds(50))
+
+		c.pop_due(t0 + std::chrono::milliseconds(49), out);
+		TS_ASSERT(out.empty())
+		c.pop_due(t0 + std::chrono::milliseconds(50), out);
+		TS_ASSERT_EQUALS(out.size(), 2u)
+		TS_ASSERT_EQUALS(name_of(out[0]), "c")
+		TS_ASSERT_EQUALS(name_of(out[1]), "x")
+		TS_ASSERT_EQUALS(c.stats().held, 2u)
+		TS_ASSERT_EQUALS(c.stats().merged, 2u)
+		TS_ASSERT_EQUALS(c.stats().delivered, 2u)
+		TS_ASSERT(!c.next_deadline())
+	}
+
+	void test_order_per_container() {
+		i3ipc::event_coalescer  c;
+		c.set_interval(i3ipc::ET_WINDOW, "title", std::chrono::milliseconds(50));
+		std::vector<i3ipc::event_t>  out;
+		auto  t0 = clock::now();
+
+		c.push(window_event("title", 1, "a"), t0, out);
+		c.push(window_event("title", 2, "x"), t0, out);
+		c.push(window_event("close", 1), t0, out);
+		TS_ASSERT_EQUALS(out.size(), 2u)
+		TS_ASSERT_EQUALS(name_of(out[0]), "a")
+		TS_ASSERT_EQUALS(c.size(), 1u)
+
+		c.flush(out);
+		TS_ASSERT_EQUALS(out.size(), 3u)
+		TS_ASSERT_EQUALS(name_of(out[2]), "x")
+	}
+};
@@ -0,0 +1,40 @@
+#include <string>
+
+#include "event-filter.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_event_filter : public CxxTest::TestSuite {
+	static std::shared_ptr<i3ipc::buf_t>  event(const std::string&  payload) {
+		return i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, payload);
+	}
+public:
+	void test_filters() {
+		using namespace i3ipc;
+		auto  focus = event("{\"change\":\"focus\",\"container\":{\"id\":42,\"name\":\"x\"}}");
+		auto  title = event("{\"change\":\"title\",\"container\":{\"id\":42,\"name\":\"x\"}}");
+		auto  ws_focus = event("{\"change\":\"focus\",\"current\":{\"id\":7,\"name\":\"1: web\"},\"old\":null}");
+		auto  ws_empty = event("{\"change\":\"empty\",\"current\":null,\"old\":{\"id\":7,\"name\":\"1: web\"}}");
+
+		event_filter_set  filters;
+		TS_ASSERT(filters.accepts(ET_WINDOW, *title))
+
+		uint32_t  id = filters.add({ ET_WINDOW, { "focus", "close" }, 0, "" });
+		TS_ASSERT(filters.accepts(ET_WINDOW, *focus))
+		TS_ASSERT(!filters.accepts(ET_WINDOW, *title))
+		TS_ASSERT(filters.accepts(ET_WORKSPACE, *ws_empty))
+
+		filters.add({ ET_WINDOW, {}, 42, "" });
+		TS_ASSERT(filters.accepts(ET_WINDOW, *title))
+		filters.remove(id);
+
+		filters.add({ ET_WORKSPACE, {}, 0, "1: web" });
+		TS_ASSERT(filters.check(ET_WORKSPACE, *ws_focus))
+		TS_ASSERT(!filters.check(ET_WORKSPACE, *ws_empty))
+		TS_ASSERT_EQUALS(filters.discarded(), 1u)
+
+		filters.clear();
+		TS_ASSERT(filters.empty())
+		TS_ASSERT(filters.accepts(ET_WORKSPACE, *ws_empty))
+	}
+};
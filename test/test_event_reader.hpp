@@ -0,0 +1,163 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::string  reader_window_event_json(const uint64_t  id, const std::string&  name) {
+	return "{\"change\":\"title\",\"container\":{\"id\":" + std::to_string(id) + ",\"name\":\"" + name +
+		"\",\"type\":\"con\",\"layout\":\"splith\",\"border\":\"normal\",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1}}}";
+}
+
+/**
+ * Send window events to a connection with a small queue, while it doesn't dispatch, then dispatch all of them
+ * @return names of the dispatched containers
+ */
+static std::vector<std::string>  reader_overflow(const i3ipc::OverflowPolicy  policy, const std::vector<uint64_t>&  ids, const size_t  expected, i3ipc::event_reader_stats_t&  stats, uint64_t&  lost) {
+	i3ipc::mock_server  server;
+	i3ipc::connection  conn(server.get_socket_path());
+	std::vector<std::string>  names;
+	conn.signal_window_event.connect([&names](const i3ipc::window_event_t&  ev) {
+		names.push_back(ev.container->name);
+	});
+	lost = 0;
+	conn.signal_resync_needed.connect([&lost](uint64_t  n) {
+		lost += n;
+	});
+	conn.subscribe(i3ipc::ET_WINDOW);
+	conn.connect_event_socket();
+	conn.start_event_reader(4, 0, policy);
+
+	std::vector<std::string>  payloads;
+	for (size_t  i = 0; i < ids.size(); i++) {
+		payloads.push_back(reader_window_event_json(ids[i], std::to_string(ids[i]) + "." + std::to_string(i)));
+	}
+	server.send_events(i3ipc::ET_WINDOW, payloads);
+
+	// Let the reader take everything from the socket (but the blocked one)
+	if (policy != i3ipc::OverflowPolicy::BLOCK) {
+		const auto  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (std::chrono::steady_clock::now() < deadline) {
+			auto  s = conn.get_event_reader_stats();
+			if (s.enqueued + s.backlog + s.dropped + s.coalesced == ids.size())
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	} else {
+		TS_ASSERT(server.wait_idle())
+	}
+
+	while (names.size() < expected) {
+		conn.handle_event();
+	}
+	stats = conn.get_event_reader_stats();
+	return names;
+}
+
+class testsuite_event_reader : public CxxTest::TestSuite {
+public:
+	void test_block() {
+		i3ipc::event_reader_stats_t  stats;
+		uint64_t  lost;
+		std::vector<uint64_t>  ids;
+		for (uint64_t  i = 0; i < 100; i++) {
+			ids.push_back(i);
+		}
+		auto  names = reader_overflow(i3ipc::OverflowPolicy::BLOCK, ids, ids.size(), stats, lost);
+		TS_ASSERT_EQUALS(names.size(), ids.size())
+		for (size_t  i = 0; i < names.size(); i++) {
+			TS_ASSERT_EQUALS(names[i], std::to_string(i) + "." + std::to_string(i))
+		}
+		TS_ASSERT_EQUALS(stats.dropped, 0u)
+		TS_ASSERT_EQUALS(stats.dequeued, 100u)
+		TS_ASSERT_EQUALS(lost, 0u)
+	}
+
+	void test_stop_blocked() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.subscribe(i3ipc::ET_WINDOW);
+		conn.connect_event_socket();
+		conn.start_event_reader(4);
+		std::vector<std::string>  payloads(20, reader_window_event_json(1, "1"));
+		server.send_events(i3ipc::ET_WINDOW, payloads);
+		TS_ASSERT(server.wait_idle())
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		TS_ASSERT_EQUALS(conn.get_event_reader_stats().depth, 4u)
+		conn.stop_event_reader(); // The thread waits for a room in the queue, it must be woken up
+	}
+
+	void test_error_after_events() {
+		std::unique_ptr<i3ipc::mock_server>  server(new i3ipc::mock_server());
+		i3ipc::connection  conn(server->get_socket_path());
+		std::vector<std::string>  names;
+		conn.signal_window_event.connect([&names](const i3ipc::window_event_t&  ev) {
+			names.push_back(ev.container->name);
+		});
+		// Events pass the coalescing stage, when it is on, so they are collected before dispatching
+		conn.get_event_coalescer().set_interval(i3ipc::ET_WINDOW, "focus", std::chrono::seconds(10));
+		conn.subscribe(i3ipc::ET_WINDOW);
+		conn.connect_event_socket();
+		conn.start_event_reader(4);
+		server->send_events(i3ipc::ET_WINDOW, { reader_window_event_json(1, "a"), reader_window_event_json(2, "b") });
+		TS_ASSERT(server->wait_idle())
+
+		// The reader fails on EOF after the events: they are dispatched before the error is thrown
+		server.reset();
+		const auto  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (conn.get_event_reader_stats().enqueued < 2 && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		TS_ASSERT_THROWS_ANYTHING(conn.dispatch_queued_events())
+		const std::vector<std::string>  expected = { "a", "b" };
+		TS_ASSERT(names == expected)
+	}
+
+	void test_drop_newest() {
+		i3ipc::event_reader_stats_t  stats;
+		uint64_t  lost;
+		auto  names = reader_overflow(i3ipc::OverflowPolicy::DROP_NEWEST, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }, 8, stats, lost);
+		const std::vector<std::string>  expected = { "0.0", "1.1", "2.2", "3.3", "4.4", "5.5", "6.6", "7.7" };
+		TS_ASSERT(names == expected)
+		TS_ASSERT_EQUALS(stats.dropped, 4u)
+		TS_ASSERT_EQUALS(stats.overflows, 8u)
+		TS_ASSERT_EQUALS(stats.backlog, 0u)
+		TS_ASSERT_EQUALS(lost, 4u)
+	}
+
+	void test_drop_oldest() {
+		i3ipc::event_reader_stats_t  stats;
+		uint64_t  lost;
+		auto  names = reader_overflow(i3ipc::OverflowPolicy::DROP_OLDEST, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }, 8, stats, lost);
+		const std::vector<std::string>  expected = { "0.0", "1.1", "2.2", "3.3", "8.8", "9.9", "10.10", "11.11" };
+		TS_ASSERT(names == expected)
+		TS_ASSERT_EQUALS(stats.dropped, 4u)
+		TS_ASSERT_EQUALS(lost, 4u)
+	}
+
+	void test_coalesce() {
+		i3ipc::event_reader_stats_t  stats;
+		uint64_t  lost;
+		// The queue takes the first 4, the rest go to the backlog: an older event about a container is dropped,
+		// the newer one takes its place at the end
+		auto  names = reader_overflow(i3ipc::OverflowPolicy::COALESCE, { 0, 1, 2, 3, 10, 11, 10, 12, 11 }, 7, stats, lost);
+		const std::vector<std::string>  expected = { "0.0", "1.1", "2.2", "3.3", "10.6", "12.7", "11.8" };
+		TS_ASSERT(names == expected)
+		TS_ASSERT_EQUALS(stats.coalesced, 2u)
+		TS_ASSERT_EQUALS(stats.dropped, 0u)
+		TS_ASSERT_EQUALS(lost, 0u)
+
+		// Nothing to coalesce: the oldest is dropped
+		names = reader_overflow(i3ipc::OverflowPolicy::COALESCE, { 0, 1, 2, 3, 4, 5, 6, 7, 8 }, 8, stats, lost);
+		TS_ASSERT_EQUALS(names.size(), 8u)
+		TS_ASSERT_EQUALS(names[4], "5.5")
+		TS_ASSERT_EQUALS(stats.dropped, 1u)
+		TS_ASSERT_EQUALS(lost, 1u)
+	}
+};
@@ -0,0 +1,97 @@
+#include <list>
+#include <string>
+
+#include "focus-tracker.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::string  tracker_con_json(const uint64_t  id, const char*  type, const std::string&  name, const std::string&  nodes, const uint64_t  window = 0) {
+	return "{\"id\":" + std::to_string(id) + ",\"type\":\"" + type + "\",\"name\":\"" + name + "\",\"layout\":\"splith\",\"border\":\"normal\""
+		",\"window\":" + std::to_string(window) + ",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1},\"nodes\":[" + nodes + "],\"floating_nodes\":[],\"focus\":[]}";
+}
+
+/**
+ * A tree with workspaces 10 ("1") and 20 ("2") on one output and windows on them
+ */
+static std::string  tracker_tree_json(const std::string&  ws1, const std::string&  ws1_windows, const std::string&  ws2_windows) {
+	return tracker_con_json(1, "root", "root", tracker_con_json(2, "output", "X", tracker_con_json(3, "con", "content",
+		tracker_con_json(10, "workspace", ws1, ws1_windows) + "," + tracker_con_json(20, "workspace", "2", ws2_windows))));
+}
+
+static std::string  tracker_window_json(const uint64_t  id) {
+	return tracker_con_json(id, "con", "w" + std::to_string(id), "", id * 1000);
+}
+
+class testsuite_focus_tracker : public CxxTest::TestSuite {
+public:
+	void test_tracking() {
+		i3ipc::mock_server  server;
+		server.set_reply(i3ipc::ClientMessageType::GET_TREE, tracker_tree_json("1", tracker_window_json(100), tracker_window_json(200)));
+		i3ipc::connection  conn(server.get_socket_path());
+		i3ipc::focus_tracker  tracker(conn);
+		TS_ASSERT(tracker.windows("1") == std::list<uint64_t>({ 100 }))
+		TS_ASSERT(tracker.windows("2") == std::list<uint64_t>({ 200 }))
+
+		int  events = 0;
+		conn.signal_window_event.connect([&events](const i3ipc::window_event_t&) { events++; });
+		conn.signal_workspace_event.connect([&events](const i3ipc::workspace_event_t&) { events++; });
+		conn.connect_event_socket();
+		auto  process = [&conn, &events](const int  count) {
+			while (events < count) {
+				conn.handle_event();
+			}
+		};
+
+		server.send_event(i3ipc::ET_WORKSPACE, "{\"change\":\"focus\",\"current\":{\"id\":10,\"name\":\"1\"}}");
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"focus\",\"container\":" + tracker_window_json(100) + "}");
+		process(2);
+		TS_ASSERT_EQUALS(tracker.focused_workspace(), "1")
+		TS_ASSERT_EQUALS(tracker.focused_window(), 100u)
+
+		// The lists follow the renamed workspace
+		server.send_event(i3ipc::ET_WORKSPACE, "{\"change\":\"rename\",\"current\":{\"id\":10,\"name\":\"one\"}}");
+		process(3);
+		TS_ASSERT_EQUALS(tracker.focused_workspace(), "one")
+		TS_ASSERT(tracker.workspaces() == std::list<std::string>({ "one", "2" }))
+		TS_ASSERT(tracker.windows("one") == std::list<uint64_t>({ 100 }))
+		TS_ASSERT(tracker.windows("1").empty())
+
+		// "move container to workspace 2": the destination is unknown until the window is focused
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"move\",\"container\":" + tracker_window_json(100) + "}");
+		process(4);
+		TS_ASSERT(tracker.windows("one").empty())
+		TS_ASSERT(tracker.windows("2") == std::list<uint64_t>({ 200 }))
+		TS_ASSERT(tracker.windows() == std::list<uint64_t>({ 100, 200 }))
+
+		// A new window belongs to the focused workspace
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"new\",\"container\":" + tracker_window_json(300) + "}");
+		process(5);
+		TS_ASSERT(tracker.windows("one") == std::list<uint64_t>({ 300 }))
+
+		// "move container to workspace 2; workspace 2"
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"move\",\"container\":" + tracker_window_json(300) + "}");
+		server.send_event(i3ipc::ET_WORKSPACE, "{\"change\":\"focus\",\"current\":{\"id\":20,\"name\":\"2\"},\"old\":{\"id\":10,\"name\":\"one\"}}");
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"focus\",\"container\":" + tracker_window_json(300) + "}");
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"close\",\"container\":" + tracker_window_json(200) + "}");
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"focus\",\"container\":" + tracker_window_json(100) + "}");
+		process(10);
+		TS_ASSERT(tracker.windows() == std::list<uint64_t>({ 100, 300 }))
+		TS_ASSERT(tracker.windows("2") == std::list<uint64_t>({ 100, 300 }))
+		TS_ASSERT(tracker.windows("one").empty())
+		TS_ASSERT(tracker.workspaces() == std::list<std::string>({ "2", "one" }))
+		TS_ASSERT_EQUALS(server.requests(i3ipc::ClientMessageType::GET_TREE), 1u) // Only the seeding
+	}
+
+	void test_subscribe_with_reader() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.subscribe(i3ipc::ET_WINDOW);
+		conn.connect_event_socket();
+		conn.start_event_reader();
+
+		// ET_WORKSPACE can't be subscribed to, while the reader is running
+		TS_ASSERT_THROWS(i3ipc::focus_tracker  tracker(conn), i3ipc::ipc_error)
+		TS_ASSERT_EQUALS(conn.signal_window_event.size(), 0u)
+	}
+};
@@ -0,0 +1,34 @@
+#include "histogram.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_histogram : public CxxTest::TestSuite {
+public:
+	void test_buckets() {
+		for (uint64_t  v : { 0ull, 7ull, 8ull, 9ull, 1000ull, 123456789ull, ~0ull }) {
+			const size_t  b = i3ipc::log_histogram::bucket_of(v);
+			TS_ASSERT(b < i3ipc::log_histogram::BUCKETS)
+			TS_ASSERT(i3ipc::log_histogram::bucket_upper_bound(b) >= v)
+			TS_ASSERT(i3ipc::log_histogram::bucket_upper_bound(b) - v <= v / 8)
+		}
+	}
+
+	void test_percentiles() {
+		i3ipc::log_histogram  h;
+		for (uint64_t  v = 1; v <= 1000; v++) {
+			h.record(v);
+		}
+		auto  s = h.snapshot();
+		TS_ASSERT_EQUALS(s.count, 1000u)
+		TS_ASSERT_EQUALS(s.min, 1u)
+		TS_ASSERT_EQUALS(s.max, 1000u)
+		TS_ASSERT_EQUALS(s.mean(), 500.5)
+		TS_ASSERT(s.percentile(0.5) >= 500 && s.percentile(0.5) < 500 * 1.125)
+		TS_ASSERT_EQUALS(s.percentile(1), 1000u)
+
+		h.reset();
+		s = h.snapshot();
+		TS_ASSERT_EQUALS(s.count, 0u)
+		TS_ASSERT_EQUALS(s.percentile(0.99), 0u)
+	}
+};
@@ -25,4 +25,25 @@ public:
 			TS_ASSERT_EQUALS(str, "69 33 2d 69 70 63 04 00 00 00 00 00 00 00 65 78 69 74")
 		}
 	}
+
+	void test_payload_scan() {
+		using namespace i3ipc;
+		auto  buff = i3_pack(ClientMessageType::COMMAND, "{\"change\": \"title\",\"container\":{\"id\":94271,\"name\":\"a \\\"change\\\":\\\"x\\\"\",\"window_id\":7}}");
+
+		std::string_view  change;
+		size_t  pos = i3_payload_find_key(*buff, "change");
+		TS_ASSERT(i3_payload_read_string(*buff, pos, change))
+		TS_ASSERT_EQUALS(std::string(change), "title")
+
+		uint64_t  id = 0;
+		pos = i3_payload_find_key(*buff, "container");
+		TS_ASSERT(i3_payload_read_uint(*buff, i3_payload_find_key(*buff, "id", pos), id))
+		TS_ASSERT_EQUALS(id, 94271u)
+
+		std::string_view  name;
+		TS_ASSERT(i3_payload_read_string(*buff, i3_payload_find_key(*buff, "name"), name))
+		TS_ASSERT_EQUALS(std::string(name), "a \\\"change\\\":\\\"x\\\"")
+		TS_ASSERT_EQUALS(i3_payload_find_key(*buff, "change", pos), std::string_view::npos)
+		TS_ASSERT_EQUALS(i3_payload_find_key(*buff, "window"), std::string_view::npos)
+	}
 };
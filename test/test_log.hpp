@@ -0,0 +1,76 @@
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+struct log_format_counter_t {
+	int*  count;
+};
+
+static std::ostream&  operator<<(std::ostream&  out, const log_format_counter_t&  c) {
+	(*c.count)++;
+	return out << "counted";
+}
+
+class testsuite_log : public CxxTest::TestSuite {
+public:
+	void setUp() {
+		m_messages.clear();
+		m_levels.clear();
+		i3ipc::set_log_sink([this](i3ipc::LogLevel  level, const std::string&  message) {
+			std::lock_guard<std::mutex>  lock(m_mutex);
+			m_messages.push_back(message);
+			m_levels.push_back(level);
+		});
+		m_level = i3ipc::get_log_level();
+	}
+
+	void tearDown() {
+		i3ipc::set_log_sink(nullptr);
+		i3ipc::set_log_level(m_level);
+		i3ipc::set_log_rate_limit(10);
+	}
+
+	void test_levels() {
+		int  formatted = 0;
+		i3ipc::set_log_level(i3ipc::LogLevel::WARNING);
+		I3IPC_INFO("info " << log_format_counter_t{ &formatted })
+		I3IPC_ERR("error " << log_format_counter_t{ &formatted })
+		i3ipc::flush_log();
+		TS_ASSERT_EQUALS(formatted, 1)
+		TS_ASSERT(m_messages == std::vector<std::string>{ "error counted" })
+		TS_ASSERT(m_levels[0] == i3ipc::LogLevel::ERROR)
+	}
+
+	void test_rate_limit() {
+		i3ipc::set_log_rate_limit(10, std::chrono::seconds(60));
+		const uint64_t  dropped = i3ipc::get_log_dropped();
+		for (int  i = 0; i < 100; i++) {
+			I3IPC_WARN("unknown layout")
+		}
+		for (int  i = 0; i < 3; i++) {
+			I3IPC_WARN("window " << i)
+		}
+		i3ipc::flush_log();
+		TS_ASSERT_EQUALS(i3ipc::get_log_dropped() - dropped, 90u)
+		const std::vector<std::string>  expected = { "unknown layout", "window 0", "window 1", "window 2", "message repeated 9 times: unknown layout" };
+		TS_ASSERT(m_messages == expected)
+
+		i3ipc::set_log_rate_limit(0);
+		m_messages.clear();
+		for (int  i = 0; i < 20; i++) {
+			I3IPC_WARN("unlimited")
+		}
+		i3ipc::flush_log();
+		TS_ASSERT_EQUALS(m_messages.size(), 20u)
+	}
+
+private:
+	std::mutex  m_mutex;
+	std::vector<std::string>  m_messages;
+	std::vector<i3ipc::LogLevel>  m_levels;
+	i3ipc::LogLevel  m_level;
+};
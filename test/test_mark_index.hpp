@@ -0,0 +1,54 @@
+#include <string>
+#include <vector>
+
+#include "mark-index.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static std::string  marked_container_json(const uint64_t  id, const std::string&  marks) {
+	return "{\"id\":" + std::to_string(id) + ",\"name\":\"w\",\"type\":\"con\",\"layout\":\"splith\",\"border\":\"normal\""
+		",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1},\"marks\":[" + marks + "],\"nodes\":[],\"floating_nodes\":[]}";
+}
+
+class testsuite_mark_index : public CxxTest::TestSuite {
+public:
+	void test_index() {
+		i3ipc::mock_server  server;
+		server.set_reply(i3ipc::ClientMessageType::GET_TREE, "{\"id\":1,\"name\":\"root\",\"type\":\"root\",\"layout\":\"splith\",\"border\":\"normal\""
+			",\"rect\":{\"x\":0,\"y\":0,\"width\":1,\"height\":1},\"nodes\":[" + marked_container_json(2, "\"a\",\"b\"") + "],\"floating_nodes\":["
+			+ marked_container_json(3, "") + "]}");
+		server.set_reply(i3ipc::ClientMessageType::GET_MARKS, "[\"a\",\"b\"]");
+		i3ipc::connection  conn(server.get_socket_path());
+		TS_ASSERT(conn.get_marks() == std::vector<std::string>({ "a", "b" }))
+
+		i3ipc::mark_index  index(conn);
+		TS_ASSERT_EQUALS(index.size(), 2u)
+		TS_ASSERT_EQUALS(index.find("a"), 2u)
+		TS_ASSERT_EQUALS(index.find("b"), 2u)
+		TS_ASSERT_EQUALS(index.find("c"), 0u)
+		TS_ASSERT(index.marks(3).empty())
+
+		int  events = 0;
+		conn.signal_window_event.connect([&events](const i3ipc::window_event_t&) { events++; });
+		conn.connect_event_socket();
+		// "b" is moved to 3, "a" is unmarked, then 3 is closed
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"mark\",\"container\":" + marked_container_json(3, "\"b\",\"c\"") + "}");
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"mark\",\"container\":" + marked_container_json(2, "") + "}");
+		while (events < 2) {
+			conn.handle_event();
+		}
+		TS_ASSERT_EQUALS(index.find("a"), 0u)
+		TS_ASSERT_EQUALS(index.find("b"), 3u)
+		TS_ASSERT_EQUALS(index.find("c"), 3u)
+		TS_ASSERT(index.marks(2).empty())
+		TS_ASSERT(index.marks(3) == std::vector<std::string>({ "b", "c" }))
+
+		server.send_event(i3ipc::ET_WINDOW, "{\"change\":\"close\",\"container\":" + marked_container_json(3, "\"b\",\"c\"") + "}");
+		while (events < 3) {
+			conn.handle_event();
+		}
+		TS_ASSERT_EQUALS(index.size(), 0u)
+		TS_ASSERT_EQUALS(server.requests(i3ipc::ClientMessageType::GET_TREE), 1u)
+	}
+};
@@ -0,0 +1,102 @@
+extern "C" {
+#include <unistd.h>
+}
+
+#include <sstream>
+
+#include <json/json.h>
+
+#include "capture.hpp"
+#include "ipc-util.hpp"
+#include "metrics.hpp"
+#include "mock-server.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_metrics : public CxxTest::TestSuite {
+public:
+	void test_counting() {
+		auto&  metrics = i3ipc::get_metrics();
+		metrics.reset();
+		metrics.on_send(20);
+		metrics.on_receive(0x80000003, 100);
+		metrics.on_receive(4, 1000);
+		metrics.on_reply(4, std::chrono::microseconds(50));
+		i3ipc::eof_error  error("test");
+
+		auto  s = metrics.snapshot();
+		TS_ASSERT_EQUALS(s.frames_sent, 1u)
+		TS_ASSERT_EQUALS(s.bytes_received, 1100u)
+		TS_ASSERT_EQUALS(s.events["window"], 1u)
+		TS_ASSERT_EQUALS(s.requests["GET_TREE"].count, 1u)
+		TS_ASSERT_EQUALS(s.requests["GET_TREE"].latency.max, 50000u)
+		TS_ASSERT_EQUALS(s.errors["eof_error"], 1u)
+
+		Json::Value  root;
+		std::istringstream  in(s.to_json());
+		TS_ASSERT(Json::parseFromStream(Json::CharReaderBuilder(), in, &root, nullptr))
+		TS_ASSERT_EQUALS(root["events"]["window"].asUInt64(), 1u)
+		TS_ASSERT(s.to_text().find("i3ipc_requests_total{type=\"GET_TREE\"} 1\n") != std::string::npos)
+
+		metrics.set_enabled(false);
+		metrics.on_send(20);
+		metrics.set_enabled(true);
+		metrics.reset();
+		TS_ASSERT_EQUALS(metrics.snapshot().frames_sent, 0u)
+	}
+
+	void test_accounting() {
+		auto&  metrics = i3ipc::get_metrics();
+		const std::string  path = "/tmp/i3ipcpp-test-metrics-" + std::to_string(getpid()) + ".i3cap";
+		{
+			i3ipc::mock_server  server;
+			i3ipc::connection  conn(server.get_socket_path());
+			conn.start_capture(path);
+			conn.subscribe(i3ipc::ET_WINDOW);
+			conn.connect_event_socket();
+			metrics.reset();
+			conn.get_version();
+			auto  s = metrics.snapshot();
+			TS_ASSERT_EQUALS(s.frames_sent, 1u)
+			TS_ASSERT_EQUALS(s.frames_received, 1u)
+			TS_ASSERT_EQUALS(s.requests["GET_VERSION"].count, 1u)
+			TS_ASSERT_EQUALS(s.parse_time.count, 1u)
+
+			// Nothing is accounted while disabled, including replies of commands sent then
+			metrics.set_enabled(false);
+			conn.get_version();
+			conn.send_command_async("nop");
+			metrics.set_enabled(true);
+			conn.wait_command_replies();
+			s = metrics.snapshot();
+			TS_ASSERT_EQUALS(s.frames_sent, 1u)
+			TS_ASSERT_EQUALS(s.requests["GET_VERSION"].count, 1u)
+			TS_ASSERT_EQUALS(s.requests.count("COMMAND"), 0u) // Its round trip is unknown
+			TS_ASSERT_EQUALS(s.parse_time.count, 2u) // But its reply is parsed, while enabled
+
+			server.send_events(i3ipc::ET_WINDOW, { "{\"change\":\"title\"}", "{\"change\":\"title\"}" });
+			int  events = 0;
+			conn.signal_event.connect([&events](i3ipc::EventType, const std::shared_ptr<const i3ipc::buf_t>&) {
+				events++;
+			});
+			while (events < 2) {
+				conn.handle_event();
+			}
+			conn.stop_capture();
+		}
+
+		// The replayer plays i3: the requests it reads are accounted only by the connection, that sent them
+		metrics.reset();
+		{
+			i3ipc::capture_replayer  replayer(path, 0);
+			auto&  conn = replayer.get_connection();
+			conn.subscribe(i3ipc::ET_WINDOW);
+			TS_ASSERT_THROWS(while (true) conn.handle_event(), i3ipc::eof_error)
+		}
+		auto  s = metrics.snapshot();
+		TS_ASSERT_EQUALS(s.frames_sent, 1u) // SUBSCRIBE
+		TS_ASSERT_EQUALS(s.frames_received, 3u) // Its reply and 2 events
+		TS_ASSERT_EQUALS(s.events["window"], 2u)
+		unlink(path.c_str());
+	}
+};
@@ -0,0 +1,159 @@
+extern "C" {
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "mock-server.hpp"
+#include "shared-state.hpp"
+#include "synthetic.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+static size_t  count_containers(const i3ipc::container_t&  c) {
+	size_t  n = 1;
+	for (auto&  lst : { &c.nodes, &c.floating_nodes }) {
+		for (auto&  child : *lst) {
+			n += count_containers(*child);
+		}
+	}
+	return n;
+}
+
+class testsuite_shared_state : public CxxTest::TestSuite {
+public:
+	void test_publish() {
+		const std::string  name = "/i3ipc-test-state-" + std::to_string(getpid());
+		i3ipc::synthetic_tree_params_t  params;
+		params.windows = 20;
+		i3ipc::synthetic_tree  small(params);
+		i3ipc::mock_server  server;
+		small.install(server);
+		i3ipc::connection  conn(server.get_socket_path());
+
+		std::unique_ptr<i3ipc::state_publisher>  publisher(new i3ipc::state_publisher(conn, name));
+		i3ipc::state_reader  reader(name);
+		i3ipc::shared_state_t  state;
+		TS_ASSERT_EQUALS(reader.read(state), publisher->sequence())
+		TS_ASSERT(state.sequence > 0)
+		TS_ASSERT(state.tree)
+		TS_ASSERT_EQUALS(count_containers(*state.tree), small.containers())
+		auto  tree = conn.get_tree();
+		TS_ASSERT_EQUALS(state.tree->id, tree->id)
+		TS_ASSERT_EQUALS(state.tree->nodes.front()->name, tree->nodes.front()->name)
+		TS_ASSERT_EQUALS(state.tree->nodes.front()->rect.width, tree->nodes.front()->rect.width)
+		TS_ASSERT_EQUALS(state.workspaces.size(), conn.get_workspaces().size())
+		TS_ASSERT_EQUALS(state.workspaces[0]->name, conn.get_workspaces()[0]->name)
+		TS_ASSERT_EQUALS(state.workspaces[0]->id, conn.get_workspaces()[0]->id)
+		TS_ASSERT_EQUALS(state.outputs.size(), conn.get_outputs().size())
+		TS_ASSERT(!reader.wait(state.sequence, std::chrono::milliseconds(10)))
+
+		// A bigger tree doesn't fit the segment: the publisher grows it, the reader remaps it
+		params.windows = 2000;
+		i3ipc::synthetic_tree  big(params);
+		big.install(server);
+		std::atomic<bool>  woken(false);
+		std::thread  waiter([&reader, &state, &woken]() {
+			woken = reader.wait(state.sequence, std::chrono::milliseconds(5000));
+		});
+		conn.connect_event_socket();
+		server.send_event(i3ipc::ET_OUTPUT, "{\"change\":\"unspecified\"}");
+		const uint32_t  old_sequence = state.sequence;
+		while (publisher->sequence() == old_sequence) {
+			conn.handle_event();
+		}
+		waiter.join();
+		TS_ASSERT(woken)
+		TS_ASSERT(publisher->snapshot_size() > 256 * 1024)
+		TS_ASSERT(reader.read(state) > old_sequence)
+		TS_ASSERT_EQUALS(count_containers(*state.tree), big.containers())
+
+		TS_ASSERT(!reader.is_closed())
+		publisher.reset();
+		TS_ASSERT(reader.is_closed())
+		TS_ASSERT(reader.wait(state.sequence, std::chrono::milliseconds(10)))
+		TS_ASSERT_THROWS_ANYTHING(i3ipc::state_reader  gone(name))
+	}
+
+	void test_unfinished_write() {
+		const std::string  name = "/i3ipc-test-state-write-" + std::to_string(getpid());
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		std::unique_ptr<i3ipc::state_publisher>  publisher(new i3ipc::state_publisher(conn, name));
+		i3ipc::state_reader  reader(name);
+		i3ipc::shared_state_t  state;
+		TS_ASSERT_THROWS_NOTHING(reader.read(state))
+
+		// The sequence follows the magic and the version, it is odd while a snapshot is being written
+		int  fd = shm_open(name.c_str(), O_RDWR, 0);
+		TS_ASSERT(fd != -1)
+		void*  data = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		TS_ASSERT(data != MAP_FAILED)
+		std::atomic<uint32_t>*  sequence = reinterpret_cast<std::atomic<uint32_t>*>(static_cast<char*>(data) + 12);
+
+		// A live publisher, that doesn't finish the snapshot
+		const uint32_t  published = sequence->load();
+		sequence->store(published + 1);
+		const auto  start = std::chrono::steady_clock::now();
+		TS_ASSERT_THROWS(reader.read(state), i3ipc::ipc_error)
+		TS_ASSERT(std::chrono::steady_clock::now() - start < std::chrono::seconds(3))
+		sequence->store(published);
+		TS_ASSERT_EQUALS(reader.read(state), published)
+
+		// A publisher, that has died while writing (its lock is released)
+		publisher.reset();
+		sequence->store(sequence->load() + 1);
+		const auto  dead_start = std::chrono::steady_clock::now();
+		TS_ASSERT_THROWS(reader.read(state), i3ipc::ipc_error)
+		TS_ASSERT(std::chrono::steady_clock::now() - dead_start < std::chrono::milliseconds(500)) // Not timed out
+
+		munmap(data, 4096);
+		close(fd);
+	}
+
+	void test_ownership() {
+		const std::string  name = "/i3ipc-test-state-mode-" + std::to_string(getpid());
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+
+		// A segment, that others can open (as if it was created by another user), is refused
+		int  fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		TS_ASSERT(fd != -1)
+		TS_ASSERT_EQUALS(fchmod(fd, 0666), 0)
+		TS_ASSERT_EQUALS(ftruncate(fd, 4096), 0)
+		TS_ASSERT_THROWS(i3ipc::state_publisher  publisher(conn, name), i3ipc::ipc_error)
+		TS_ASSERT_THROWS(i3ipc::state_reader  reader(name), i3ipc::ipc_error)
+		close(fd);
+		shm_unlink(name.c_str());
+
+		// A single publisher of a segment
+		{
+			i3ipc::state_publisher  publisher(conn, name);
+			TS_ASSERT_THROWS(i3ipc::state_publisher  second(conn, name), i3ipc::ipc_error)
+			TS_ASSERT_THROWS_NOTHING(i3ipc::state_reader  reader(name))
+		}
+		// The name is free again
+		TS_ASSERT_THROWS_NOTHING(i3ipc::state_publisher  publisher(conn, name))
+	}
+
+	void test_subscribe_with_reader() {
+		const std::string  name = "/i3ipc-test-state-reader-" + std::to_string(getpid());
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		conn.subscribe(i3ipc::ET_WINDOW);
+		conn.connect_event_socket();
+		conn.start_event_reader();
+
+		// ET_WORKSPACE and ET_OUTPUT can't be subscribed to, while the reader is running
+		TS_ASSERT_THROWS(i3ipc::state_publisher  publisher(conn, name), i3ipc::ipc_error)
+		TS_ASSERT_EQUALS(conn.signal_window_event.size(), 0u)
+		shm_unlink(name.c_str());
+	}
+};
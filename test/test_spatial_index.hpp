@@ -0,0 +1,113 @@
+#include <memory>
+
+#include "spatial-index.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_spatial_index : public CxxTest::TestSuite {
+	typedef std::shared_ptr<i3ipc::container_t>  con_ptr;
+
+	static con_ptr  con(uint64_t  id, const std::string&  type, i3ipc::rect_t  rect, uint64_t  window = 0) {
+		auto  c = std::make_shared<i3ipc::container_t>();
+		c->id = id;
+		c->type = type;
+		c->rect = rect;
+		c->xwindow_id = window;
+		c->layout = i3ipc::ContainerLayout::SPLIT_H;
+		return c;
+	}
+
+	/**
+	 * root -> output "eDP-1" -> content -> two workspaces (the second one is hidden)
+	 */
+	static con_ptr  make_tree(con_ptr&  ws) {
+		auto  root = con(1, "root", {0, 0, 1000, 1000});
+		auto  output = con(2, "output", {0, 0, 1000, 1000});
+		output->name = "eDP-1";
+		auto  scratch_output = con(3, "output", {0, 0, 1000, 1000});
+		scratch_output->name = "__i3";
+		scratch_output->nodes.push_back(con(4, "con", {0, 0, 1000, 1000}, 400));
+		auto  content = con(5, "con", {0, 0, 1000, 1000});
+		ws = con(10, "workspace", {0, 0, 1000, 1000});
+		auto  hidden_ws = con(11, "workspace", {0, 0, 1000, 1000});
+		hidden_ws->nodes.push_back(con(12, "con", {0, 0, 1000, 1000}, 1200));
+		content->nodes = { hidden_ws, ws };
+		content->focus = { 10, 11 };
+		output->nodes.push_back(content);
+		root->nodes = { scratch_output, output };
+		return root;
+	}
+public:
+	void test_tiling() {
+		con_ptr  ws;
+		auto  root = make_tree(ws);
+		auto  left = con(20, "con", {0, 0, 500, 1000}, 2000);
+		auto  right = con(21, "con", {500, 0, 500, 1000}, 2100);
+		ws->nodes = { left, right };
+
+		i3ipc::spatial_index  index(root);
+		TS_ASSERT_EQUALS(index.size(), 2u)
+		TS_ASSERT_EQUALS(index.window_at(10, 10), left)
+		TS_ASSERT_EQUALS(index.window_at(499, 999), left)
+		TS_ASSERT_EQUALS(index.window_at(500, 0), right)
+		TS_ASSERT(!index.window_at(1000, 0))
+		TS_ASSERT(!index.window_at(-1, 0))
+
+		auto  hits = index.windows_in({400, 400, 200, 200});
+		TS_ASSERT_EQUALS(hits.size(), 2u)
+		TS_ASSERT_EQUALS(index.windows_in({0, 0, 100, 100}).size(), 1u)
+	}
+
+	void test_tabbed_and_floating() {
+		con_ptr  ws;
+		auto  root = make_tree(ws);
+		auto  tabs = con(30, "con", {0, 0, 1000, 1000});
+		tabs->layout = i3ipc::ContainerLayout::TABBED;
+		auto  tab_a = con(31, "con", {0, 20, 1000, 980}, 3100);
+		tab_a->deco_rect = {0, 0, 500, 20};
+		auto  tab_b = con(32, "con", {0, 20, 1000, 980}, 3200);
+		tab_b->deco_rect = {500, 0, 500, 20};
+		tabs->nodes = { tab_a, tab_b };
+		tabs->focus = { 32, 31 };
+		ws->nodes = { tabs };
+
+		auto  floating_low = con(40, "floating_con", {100, 100, 300, 300});
+		auto  window_low = con(41, "con", {100, 100, 300, 300}, 4100);
+		floating_low->nodes = { window_low };
+		auto  floating_high = con(42, "floating_con", {200, 200, 300, 300});
+		auto  window_high = con(43, "con", {200, 200, 300, 300}, 4300);
+		floating_high->nodes = { window_high };
+		ws->floating_nodes = { floating_low, floating_high };
+
+		i3ipc::spatial_index  index(root);
+		TS_ASSERT_EQUALS(index.window_at(10, 10), tab_a)
+		TS_ASSERT_EQUALS(index.window_at(600, 10), tab_b)
+		TS_ASSERT_EQUALS(index.window_at(900, 900), tab_b)
+		TS_ASSERT_EQUALS(index.window_at(150, 150), window_low)
+		TS_ASSERT_EQUALS(index.window_at(250, 250), window_high)
+
+		auto  hits = index.windows_in({250, 250, 10, 10});
+		TS_ASSERT_EQUALS(hits.size(), 3u)
+		TS_ASSERT_EQUALS(hits[0], window_high)
+		TS_ASSERT_EQUALS(hits[1], window_low)
+		TS_ASSERT_EQUALS(hits[2], tab_b)
+	}
+
+	void test_many_windows() {
+		con_ptr  ws;
+		auto  root = make_tree(ws);
+		for (uint32_t  i = 0; i < 1000; i++) {
+			ws->nodes.push_back(con(100 + i, "con", {0, int32_t(i), 1000, 1}, 10000 + i));
+		}
+
+		i3ipc::spatial_index  index(root);
+		TS_ASSERT_EQUALS(index.size(), 1000u)
+		for (uint32_t  i = 0; i < 1000; i += 97) {
+			auto  w = index.window_at(500, i);
+			TS_ASSERT(w)
+			if (w) {
+				TS_ASSERT_EQUALS(w->id, 100u + i)
+			}
+		}
+	}
+};
@@ -0,0 +1,53 @@
+#include <thread>
+
+#include "spsc-ring.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_spsc_ring : public CxxTest::TestSuite {
+public:
+	void test_bounds() {
+		i3ipc::spsc_ring<int>  ring(3);
+		TS_ASSERT_EQUALS(ring.capacity(), 4u)
+		for (int  i = 0; i < 4; i++) {
+			TS_ASSERT(ring.push(int(i)))
+		}
+		TS_ASSERT(!ring.push(4))
+		TS_ASSERT_EQUALS(ring.size(), 4u)
+
+		int  v = -1;
+		TS_ASSERT(ring.pop(v))
+		TS_ASSERT_EQUALS(v, 0)
+		TS_ASSERT(ring.push(4))
+		for (int  i = 1; i <= 4; i++) {
+			TS_ASSERT(ring.pop(v))
+			TS_ASSERT_EQUALS(v, i)
+		}
+		TS_ASSERT(!ring.pop(v))
+		TS_ASSERT(ring.empty())
+	}
+
+	void test_threads() {
+		const uint64_t  count = 200000;
+		i3ipc::spsc_ring<uint64_t>  ring(64);
+		std::thread  producer([&ring, count]() {
+			for (uint64_t  i = 1; i <= count; i++) {
+				while (!ring.push(uint64_t(i))) {
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		uint64_t  expected = 1, v = 0;
+		bool  ordered = true;
+		while (expected <= count) {
+			if (ring.pop(v)) {
+				ordered = ordered && v == expected;
+				expected++;
+			}
+		}
+		producer.join();
+		TS_ASSERT(ordered)
+		TS_ASSERT(ring.empty())
+	}
+};
@@ -0,0 +1,120 @@
+#include <set>
+
+#include "ipc.hpp"
+#include "mock-server.hpp"
+#include "synthetic.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+struct synthetic_tree_stats_t {
+	size_t  containers = 0;
+	size_t  windows = 0;
+	size_t  bad_focus = 0; ///< Focus arrays with IDs of not children
+	size_t  outside = 0; ///< Windows out of their workspace
+	uint64_t  focused = 0;
+	std::set<uint64_t>  ids;
+};
+
+static void  collect_synthetic_stats(const i3ipc::container_t&  c, const i3ipc::container_t*  workspace, synthetic_tree_stats_t&  stats) {
+	stats.containers++;
+	stats.ids.insert(c.id);
+	if (c.type == "workspace")
+		workspace = &c;
+	if (c.xwindow_id) {
+		stats.windows++;
+		const auto&  w = workspace->rect;
+		if (c.rect.x < w.x || c.rect.y < w.y || c.rect.x + c.rect.width > w.x + w.width || c.rect.y + c.rect.height > w.y + w.height)
+			stats.outside++;
+	}
+	if (c.focused)
+		stats.focused = c.id;
+
+	std::set<uint64_t>  children;
+	for (auto&  n : c.nodes) {
+		children.insert(n->id);
+		collect_synthetic_stats(*n, workspace, stats);
+	}
+	for (auto&  n : c.floating_nodes) {
+		children.insert(n->id);
+		collect_synthetic_stats(*n, workspace, stats);
+	}
+	if (c.focus.size() != children.size())
+		stats.bad_focus++;
+	for (uint64_t  id : c.focus) {
+		if (!children.count(id))
+			stats.bad_focus++;
+	}
+}
+
+class testsuite_synthetic : public CxxTest::TestSuite {
+public:
+	void test_tree() {
+		i3ipc::synthetic_tree_params_t  params;
+		params.outputs = 2;
+		params.windows = 300;
+		params.floating_ratio = 0.1;
+		i3ipc::synthetic_tree  tree(params);
+		TS_ASSERT_EQUALS(tree.windows(), 300u)
+		TS_ASSERT_EQUALS(tree.get_tree_json(), i3ipc::synthetic_tree(params).get_tree_json())
+
+		i3ipc::mock_server  server;
+		tree.install(server);
+		i3ipc::connection  conn(server.get_socket_path());
+		synthetic_tree_stats_t  stats;
+		collect_synthetic_stats(*conn.get_tree(), nullptr, stats);
+		TS_ASSERT_EQUALS(stats.containers, tree.containers())
+		TS_ASSERT_EQUALS(stats.ids.size(), stats.containers)
+		TS_ASSERT_EQUALS(stats.windows, 300u)
+		TS_ASSERT_EQUALS(stats.bad_focus, 0u)
+		TS_ASSERT_EQUALS(stats.outside, 0u)
+		TS_ASSERT_EQUALS(stats.focused, tree.focused_window())
+
+		auto  workspaces = conn.get_workspaces();
+		TS_ASSERT_EQUALS(workspaces.size(), 8u)
+		TS_ASSERT_EQUALS(std::count_if(workspaces.begin(), workspaces.end(), [](const std::shared_ptr<i3ipc::workspace_t>&  ws) { return ws->focused; }), 1)
+		TS_ASSERT_EQUALS(std::count_if(workspaces.begin(), workspaces.end(), [](const std::shared_ptr<i3ipc::workspace_t>&  ws) { return ws->visible; }), 2)
+		TS_ASSERT_EQUALS(conn.get_outputs().size(), 3u) // With "__i3"
+	}
+
+	void test_events() {
+		i3ipc::synthetic_tree_params_t  params;
+		params.seed = 7;
+		params.windows = 50;
+		i3ipc::synthetic_tree  tree(params);
+		auto  events = tree.generate_events(1000);
+		TS_ASSERT_EQUALS(events.size(), 1000u)
+
+		int64_t  windows = 50;
+		uint64_t  focused = tree.focused_window();
+		for (auto&  e : events) {
+			i3ipc::event_t  ev;
+			ev.type = e.type;
+			ev.buf = i3ipc::i3_pack(i3ipc::ClientMessageType::COMMAND, e.payload);
+			i3ipc::decode_event(ev);
+			if (e.type == i3ipc::ET_WORKSPACE) {
+				TS_ASSERT(ev.workspace && ev.workspace->current)
+				continue;
+			}
+			TS_ASSERT(ev.window && ev.window->container)
+			if (ev.window->type == i3ipc::WindowEventType::NEW) {
+				windows++;
+			} else if (ev.window->type == i3ipc::WindowEventType::CLOSE) {
+				windows--;
+			} else if (ev.window->type == i3ipc::WindowEventType::FOCUS) {
+				focused = ev.window->container->id;
+			}
+		}
+		TS_ASSERT_EQUALS(static_cast<int64_t>(tree.windows()), windows)
+		TS_ASSERT_EQUALS(tree.focused_window(), focused)
+
+		i3ipc::mock_server  server;
+		tree.install(server);
+		i3ipc::connection  conn(server.get_socket_path());
+		synthetic_tree_stats_t  stats;
+		collect_synthetic_stats(*conn.get_tree(), nullptr, stats);
+		TS_ASSERT_EQUALS(stats.windows, tree.windows())
+		TS_ASSERT_EQUALS(stats.bad_focus, 0u)
+		TS_ASSERT_EQUALS(stats.outside, 0u)
+		TS_ASSERT_EQUALS(stats.focused, focused)
+	}
+};
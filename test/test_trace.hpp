@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "ipc.hpp"
+#include "mock-server.hpp"
+#include "trace.hpp"
+
+#include <cxxtest/TestSuite.h>
+
+class testsuite_trace : public CxxTest::TestSuite {
+public:
+	void test_sink() {
+		i3ipc::mock_server  server;
+		i3ipc::connection  conn(server.get_socket_path());
+		std::mutex  mutex;
+		std::vector<i3ipc::trace_event_t>  events;
+
+		conn.get_tree(); // Not traced
+		i3ipc::start_trace([&](const i3ipc::trace_event_t&  event) {
+			std::lock_guard<std::mutex>  lock(mutex);
+			events.push_back(event);
+		});
+		TS_ASSERT(i3ipc::trace_enabled())
+		conn.get_tree();
+		i3ipc::stop_trace();
+		conn.get_tree();
+
+		auto  find = [&](const std::string&  name) -> const i3ipc::trace_event_t* {
+			for (auto&  e : events) {
+				if (name == e.name)
+					return &e;
+			}
+			return nullptr;
+		};
+		const i3ipc::trace_event_t*  msg = find("i3_msg");
+		const i3ipc::trace_event_t*  recv = find("i3_recv");
+		const i3ipc::trace_event_t*  parse = find("parse_tree");
+		TS_ASSERT(msg && recv && parse && find("i3_send") && find("parse_json"))
+		if (!msg || !recv || !parse)
+			return;
+		TS_ASSERT_EQUALS(msg->type, 4u)
+		TS_ASSERT_EQUALS(recv->type, 4u)
+		TS_ASSERT(recv->bytes > 14)
+		TS_ASSERT(recv->start >= msg->start && recv->start + recv->duration <= msg->start + msg->duration)
+		TS_ASSERT(parse->start >= msg->start + msg->duration)
+		size_t  msgs = 0;
+		for (auto&  e : events) {
+			msgs += (std::string("i3_msg") == e.name);
+		}
+		TS_ASSERT_EQUALS(msgs, 1u)
+	}
+
+	void test_file() {
+		const std::string  path = "/tmp/i3ipcpp-test-trace.json";
+		i3ipc::start_trace(path);
+		{
+			i3ipc::trace_span  span("custom", 0x80000003, 100);
+		}
+		i3ipc::stop_trace();
+
+		Json::Value  root;
+		std::ifstream  in(path);
+		TS_ASSERT(Json::parseFromStream(Json::CharReaderBuilder(), in, &root, nullptr))
+		TS_ASSERT_EQUALS(root["traceEvents"].size(), 1u)
+		const Json::Value&  e = root["traceEvents"][0];
+		TS_ASSERT_EQUALS(e["name"].asString(), "custom")
+		TS_ASSERT_EQUALS(e["ph"].asString(), "X")
+		TS_ASSERT_EQUALS(e["args"]["type"].asString(), "window")
+		TS_ASSERT_EQUALS(e["args"]["bytes"].asUInt(), 100u)
+		std::remove(path.c_str());
+	}
+
+	void test_restart_same_file() {
+		const std::string  path = "/tmp/i3ipcpp-test-trace-restart.json";
+		i3ipc::start_trace(path);
+		{
+			i3ipc::trace_span  span("first");
+		}
+		i3ipc::start_trace(path);
+		{
+			i3ipc::trace_span  span("second");
+		}
+		i3ipc::stop_trace();
+
+		Json::Value  root;
+		std::ifstream  in(path);
+		TS_ASSERT(Json::parseFromStream(Json::CharReaderBuilder(), in, &root, nullptr))
+		TS_ASSERT_EQUALS(root["traceEvents"].size(), 1u)
+		TS_ASSERT_EQUALS(root["traceEvents"][0]["name"].asString(), "second")
+		std::remove(path.c_str());
+	}
+};